@@ -120,7 +120,7 @@ syn keyword     boronType	double! time! date! coord! vec3!
 syn keyword     boronType	word! lit-word! set-word! get-word! option!
 syn keyword     boronType	binary! bitset! string! file! vector!
 syn keyword     boronType	block! paren! path! lit-path! set-path!
-syn keyword     boronType	context! hash-map! error! func! cfunc!
+syn keyword     boronType	context! hash-map! matcher! error! func! cfunc!
 syn keyword     boronStatement	type?
 
 " Control statements
@@ -25,6 +25,21 @@ rejoin: func [b block!] [
 ]
 
 replace: func [series pat rep /all] [
+  if matcher? pat [
+    either all [
+      f: series
+      while [f: find/pattern f pat] [
+        size: second f
+        f: change/part first f rep size? pat/:size
+      ]
+    ][
+      if f: find/pattern series pat [
+        size: second f
+        change/part first f rep size? pat/:size
+      ]
+    ]
+    return series
+  ]
   size: either series? pat [size? pat][1]
   either all [
     f: series
@@ -335,6 +335,31 @@ UIndex boron_seriesEnd( UThread* ut, const UCell* cell )
 }
 
 
+/*
+  Return the position n characters away from pos in a UTF-8 string.
+  This is called through the boron_seriesStep() macro, which simply adds n
+  for other series.  As with other series, the result may be outside the
+  buffer.
+*/
+UIndex boron_utf8Step( UThread* ut, const UBuffer* buf, UIndex pos, UIndex n )
+{
+    const uint8_t* cp = buf->ptr.b;
+    if( n == 1 && pos >= 0 && pos < buf->used )
+    {
+        while( ++pos < buf->used && (cp[ pos ] & 0xc0) == 0x80 )
+            ;
+        return pos;
+    }
+    if( n == -1 && pos > 0 && pos <= buf->used )
+    {
+        while( --pos > 0 && (cp[ pos ] & 0xc0) == 0x80 )
+            ;
+        return pos;
+    }
+    return ur_strCharPos( ut, buf, ur_strCharIndex( ut, buf, pos ) + n );
+}
+
+
 #define a2  (a1 + 1)
 #define a3  (a1 + 2)
 #define ANY3(c,t1,t2,t3)    ((1<<ur_type(c)) & ((1<<t1) | (1<<t2) | (1<<t3)))
@@ -723,6 +748,7 @@ UThread* boron_makeEnv( UEnvParameters* par )
 
     for( i = 0; i < (sizeof(boron_types) / sizeof(UDatatype)); ++i )
         table[i] = boron_types + i;
+    table[i++] = &dt_matcher;   // Defined by Urlan.
     dtCount = i + par->dtCount;
 
     tt = par->dtTable;
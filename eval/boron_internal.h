@@ -57,6 +57,14 @@ BoronThread;
 
 
 extern UIndex boron_seriesEnd( UThread* ut, const UCell* cell );
+extern UIndex boron_utf8Step( UThread* ut, const UBuffer* buf, UIndex pos,
+                              UIndex n );
+
+// UTF-8 strings have byte positions but are indexed by character.
+#define UTF8_SERIES(buf) (ur_strIsUtf8(buf) && ur_isStringType((buf)->type))
+
+#define boron_seriesStep(ut,buf,pos,n) \
+    (UTF8_SERIES(buf) ? boron_utf8Step(ut,buf,pos,n) : (pos) + (n))
 
 
 #endif  // BORON_INTERNAL_H
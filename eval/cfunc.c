@@ -1512,7 +1512,11 @@ CFUNC(cfunc_second)
     int type = ur_type(a1);
     int n = ur_int(a2);
     if( ur_isSeriesType( type ) )
-        SERIES_DT( type )->pick( ur_bufferSer(a1), a1->series.it + n, res );
+    {
+        const UBuffer* buf = ur_bufferSer(a1);
+        SERIES_DT( type )->pick( buf,
+                            boron_seriesStep( ut, buf, a1->series.it, n ), res );
+    }
     else if( type == UT_COORD )
         coord_pick( a1, n, res );
     else if( type == UT_VEC3 )
@@ -1540,7 +1544,8 @@ CFUNC(cfunc_last)
     if( si.it == si.end )
         ur_setId(res, UT_NONE);
     else
-        SERIES_DT( type )->pick( ur_bufferSer(a1), si.end - 1, res );
+        SERIES_DT( type )->pick( si.buf,
+                                 boron_seriesStep( ut, si.buf, si.end, -1 ), res );
     return UR_OK;
 }
 
@@ -1567,7 +1572,8 @@ CFUNC(cfunc_2plus)
     if( ur_isSeriesType( ur_type(cell) ) )
     {
         if( cell->series.it < boron_seriesEnd(ut, cell) )
-            ++cell->series.it;
+            cell->series.it = boron_seriesStep( ut, ur_bufferSer(cell),
+                                                cell->series.it, 1 );
     }
     else if( ur_is(cell, UT_INT) )
         ur_int(cell) += 1;
@@ -1604,7 +1610,8 @@ CFUNC(cfunc_2minus)
     if( ur_isSeriesType( ur_type(cell) ) )
     {
         if( cell->series.it > 0 )
-            --cell->series.it;
+            cell->series.it = boron_seriesStep( ut, ur_bufferSer(cell),
+                                                cell->series.it, -1 );
     }
     else if( ur_is(cell, UT_INT) )
         ur_int(cell) -= 1;
@@ -1727,7 +1734,8 @@ CFUNC(cfunc_prev)
         return boron_badArg( ut, type, 0 );
     *res = *a1;
     if( res->series.it > 0 )
-        --res->series.it;
+        res->series.it = boron_seriesStep( ut, ur_bufferSer(res),
+                                           res->series.it, -1 );
     return UR_OK;
 }
 
@@ -1746,7 +1754,8 @@ CFUNC(cfunc_next)
         return boron_badArg( ut, type, 0 );
     *res = *a1;
     if( res->series.it < boron_seriesEnd(ut, res) )
-        ++res->series.it;
+        res->series.it = boron_seriesStep( ut, ur_bufferSer(res),
+                                           res->series.it, 1 );
     return UR_OK;
 }
 
@@ -1865,7 +1874,11 @@ CFUNC(cfunc_pick)
         return boron_badArg( ut, ur_type(c2), 1 );
 
     if( ur_isSeriesType( type ) )
-        SERIES_DT( type )->pick( ur_bufferSer(a1), a1->series.it + n, res );
+    {
+        const UBuffer* buf = ur_bufferSer(a1);
+        SERIES_DT( type )->pick( buf,
+                            boron_seriesStep( ut, buf, a1->series.it, n ), res );
+    }
     else if( type == UT_VEC3 )
         vec3_pick( a1, n, res );
     else if( type == UT_COORD )
@@ -1934,7 +1947,9 @@ CFUNC(cfunc_poke)
     {
         if( ! (buf = ur_bufferSerM(a1)) )
             return UR_THROW;
-        SERIES_DT( type )->poke( buf, a1->series.it + n, a3 );
+        SERIES_DT( type )->poke( buf,
+                                 boron_seriesStep( ut, buf, a1->series.it, n ),
+                                 a3 );
         return UR_OK;
     }
     else if( type == UT_VEC3 )
@@ -1968,7 +1983,7 @@ CFUNC(cfunc_pop)
     else
     {
         const USeriesType* dt = SERIES_DT( type );
-        si.it = si.end - 1;
+        si.it = boron_seriesStep( ut, si.buf, si.end, -1 );
         dt->pick( si.buf, si.it, res );
         dt->remove( ut, &si, 0 );
     }
@@ -2005,11 +2020,21 @@ CFUNC(cfunc_skip)
         *res = *a1;
         if( n )
         {
-            n += a1->series.it;
+            const UBuffer* buf = ur_bufferSer(a1);
+            int utf8 = UTF8_SERIES(buf);
+
+            end = boron_seriesEnd( ut, a1 );
+            if( utf8 )
+            {
+                n += ur_strCharIndex( ut, buf, a1->series.it );
+                end = ur_strCharIndex( ut, buf, end );
+            }
+            else
+                n += a1->series.it;
+
             if( n < 0 )
             {
-                if( (CFUNC_OPTIONS & OPT_SKIP_WRAP) &&
-                    (end = boron_seriesEnd( ut, a1 )) )
+                if( (CFUNC_OPTIONS & OPT_SKIP_WRAP) && end )
                 {
                     do
                         n += end;
@@ -2020,7 +2045,6 @@ CFUNC(cfunc_skip)
             }
             else
             {
-                end = boron_seriesEnd( ut, a1 );
                 if( (CFUNC_OPTIONS & OPT_SKIP_WRAP) && end )
                 {
                     while( n >= end )
@@ -2029,7 +2053,7 @@ CFUNC(cfunc_skip)
                 else if( n > end )
                     n = end;
             }
-            res->series.it = n;
+            res->series.it = utf8 ? ur_strCharPos( ut, buf, n ) : n;
         }
         return UR_OK;
     }
@@ -2244,7 +2268,7 @@ CFUNC(cfunc_change)
     {
         UCell* parg = CFUNC_OPT_ARG(2);
         if( ur_is(parg, UT_INT) )
-            part = ur_int(parg);
+            part = boron_seriesStep( ut, si.buf, si.it, ur_int(parg) ) - si.it;
         else if( ur_isSeriesType( ur_type(parg) ) )
             part = parg->series.it - si.it;
         else
@@ -2311,7 +2335,7 @@ CFUNC(cfunc_remove)
     if( opt & OPT_REMOVE_PART )
     {
         UCell* parg = CFUNC_OPT_ARG(2);
-        part = ur_int(parg);
+        part = boron_seriesStep( ut, si.buf, si.it, ur_int(parg) ) - si.it;
     }
     else if( opt & OPT_REMOVE_SLICE )
     {
@@ -2355,7 +2379,7 @@ CFUNC(cfunc_reverse)
     if( CFUNC_OPTIONS & OPT_REVERSE_PART )
     {
         UCell* parg = CFUNC_OPT_ARG(1);
-        part = ur_int(parg);
+        part = boron_seriesStep( ut, si.buf, si.it, ur_int(parg) ) - si.it;
         if( part < 1 )
             goto done;
         if( part < (si.end - si.it) )
@@ -2377,14 +2401,19 @@ done:
         /case       Case of characters in strings must match.
         /part       Restrict search to part of series.
             limit   series/int!
+        /pattern    Return position & index of the pattern found by a matcher!.
     return: Position of value in series or none!.
     group: series
+
+    With /pattern the value must be a matcher! and the result is a block of
+    the position and the (one-based) number of the matched pattern.
 */
 CFUNC(cfunc_find)
 {
 #define OPT_FIND_LAST   UR_FIND_LAST
 #define OPT_FIND_CASE   UR_FIND_CASE
 #define OPT_FIND_PART   0x04
+#define OPT_FIND_PATTERN 0x08
     USeriesIter si;
     UIndex i;
     uint32_t opt = CFUNC_OPTIONS;
@@ -2403,7 +2432,7 @@ CFUNC(cfunc_find)
         UCell* parg = CFUNC_OPT_ARG(3);
 
         if( ur_is(parg, UT_INT) )
-            part = ur_int(parg);
+            part = boron_seriesStep( ut, si.buf, si.it, ur_int(parg) ) - si.it;
         else if( ur_isSeriesType( ur_type(parg) ) )
             part = parg->series.it - si.it;
         else
@@ -2416,6 +2445,31 @@ CFUNC(cfunc_find)
             si.end = part;
     }
 
+    if( opt & OPT_FIND_PATTERN )
+    {
+        UBuffer* blk;
+        UCell* cell;
+        int len, pat;
+
+        if( ! ur_is(a2, UT_MATCHER) )
+            return errorType( "find /pattern expected matcher! value" );
+        if( ! ur_isStringType( type ) && type != UT_BINARY )
+            return boron_badArg( ut, type, 0 );
+
+        i = ur_matcherFind( ur_bufferSer(a2), si.buf, si.it, si.end, opt,
+                            &len, &pat );
+        if( i < 0 )
+            goto set_none;
+
+        blk = ur_makeBlockCell( ut, UT_BLOCK, 2, res );     // gc!
+        cell = ur_blkAppendNew( blk, type );
+        *cell = *a1;
+        cell->series.it = i;
+        cell = ur_blkAppendNew( blk, UT_INT );
+        ur_int(cell) = pat + 1;
+        return UR_OK;
+    }
+
     i = SERIES_DT( type )->find( ut, &si, a2, opt );
     if( i < 0 )
     {
@@ -2431,6 +2485,37 @@ set_none:
 }
 
 
+/*-cf-
+    index-series
+        series      block!
+        /skip       Only index the first value of each record.
+            size    int!
+    return: Series.
+    group: series
+    see: find, select
+
+    Build a hash index for a block so that subsequent find and select calls
+    on it do not need to do a linear search.  The index is discarded when
+    the block is modified.
+
+    Only number, date, char!, and word values are indexed.  Finding a
+    string, binary, or other series is still done with a linear search
+    as the series contents can change without the block being modified.
+
+    With /skip only the first value of every size values (starting from
+    the block head) is indexed, and find & select will only match values
+    at those record positions.
+*/
+CFUNC(cfunc_index_series)
+{
+    int skip = (CFUNC_OPTIONS & 1) ? ur_int(CFUNC_OPT_ARG(1)) : 1;
+    if( ! ur_blkIndex( ut, a1, skip ) )
+        return UR_THROW;
+    *res = *a1;
+    return UR_OK;
+}
+
+
 /*-cf-
     clear
         series  series or none!/hash-map!
@@ -2557,21 +2642,22 @@ CFUNC(cfunc_slice)
 set_end:
         if( end < 0 )
         {
-            res->series.end = (res->series.end < 0) ? buf->used + end
-                                                    : res->series.end + end;
+            res->series.end = boron_seriesStep( ut, buf,
+                (res->series.end < 0) ? buf->used : res->series.end, end );
             if( res->series.end < res->series.it )
                 res->series.end = res->series.it;
         }
         else
         {
-            res->series.end = res->series.it + end;
+            res->series.end = boron_seriesStep( ut, buf, res->series.it, end );
             if( res->series.end >= buf->used )
                 res->series.end = -1;
         }
     }
     else if( ur_is(limit, UT_COORD) )
     {
-        res->series.it += limit->coord.n[0];
+        res->series.it = boron_seriesStep( ut, buf, res->series.it,
+                                           limit->coord.n[0] );
         if( res->series.it < 0 )
             res->series.it = 0;
         end = limit->coord.n[1];
@@ -2663,7 +2749,11 @@ CFUNC(cfunc_sizeQ)
     {
         USeriesIter si;
         ur_seriesSlice( ut, &si, a1 );
-        len = si.end - si.it;
+        if( UTF8_SERIES(si.buf) && si.it < si.end )
+            len = ur_strCharIndex( ut, si.buf, si.end ) -
+                  ur_strCharIndex( ut, si.buf, si.it );
+        else
+            len = si.end - si.it;
     }
     else if( ur_is(a1, UT_COORD) )
         len = a1->coord.len;
@@ -2693,7 +2783,12 @@ CFUNC(cfunc_indexQ)
     int type = ur_type(a1);
 
     if( ur_isSeriesType( type ) )
-        ur_int(res) = a1->series.it + 1;
+    {
+        const UBuffer* buf = ur_bufferSer(a1);
+        ur_int(res) = (UTF8_SERIES(buf) ? ur_strCharIndex( ut, buf,
+                                                           a1->series.it )
+                                        : a1->series.it) + 1;
+    }
     else if( ur_isWordType( type ) )
         ur_int(res) = ur_atom(a1);
     else if( type == UT_DATATYPE )
@@ -3011,6 +3106,120 @@ static inline UIndex _sliceEnd( const UBuffer* buf, const UCell* cell )
 }
 
 
+/*
+  Loop for foreach & map with a single word.  The word cell is looked up
+  once and elements of blocks, strings & vectors are copied straight into
+  it (and map results straight back) rather than going through the
+  datatype pick & poke methods.
+*/
+static UStatus _eachWord( UThread* ut, const UCell* word, const UCell* sarg,
+                          const UCell* body, UCell* res, int map )
+{
+    const USeriesType* dt = SERIES_DT( ur_type(sarg) );
+    int type = ur_type(sarg);
+    UBuffer* buf;
+    UCell* cell;
+    UIndex ctxN;
+    USeriesIter si;
+
+    ur_seriesSlice( ut, &si, sarg );
+    if( si.it >= si.end )
+        return UR_OK;
+    if( ! (cell = ur_wordCellM(ut, word)) )
+        return UR_THROW;
+
+    // Stack cells stay put, but a context may be resized if the body adds
+    // words to it so its cell is found again after each evaluation.
+    ctxN = (ur_binding(word) == UR_BIND_THREAD) ? word->word.ctx
+                                                : UR_INVALID_BUF;
+    if( ur_isBlockType( type ) )
+        type = UT_BLOCK;
+    else if( UTF8_SERIES(si.buf) )
+        type = UT_UNSET;    // Picked & stepped over by character.
+
+    while( si.it < si.end )
+    {
+        switch( type )
+        {
+            case UT_BLOCK:
+                *cell = si.buf->ptr.cell[ si.it ];
+                break;
+
+            case UT_STRING:
+                ur_setId(cell, UT_CHAR);
+                ur_int(cell) = ur_strIsUcs2(si.buf) ? si.buf->ptr.u16[ si.it ]
+                                                    : si.buf->ptr.b[ si.it ];
+                break;
+
+            case UT_VECTOR:
+                switch( si.buf->form )
+                {
+                    case UR_VEC_I16:
+                        ur_setId(cell, UT_INT);
+                        ur_int(cell) = si.buf->ptr.i16[ si.it ];
+                        break;
+                    case UR_VEC_U16:
+                        ur_setId(cell, UT_INT);
+                        ur_int(cell) = si.buf->ptr.u16[ si.it ];
+                        break;
+                    case UR_VEC_I32:
+                    case UR_VEC_U32:
+                        ur_setId(cell, UT_INT);
+                        ur_int(cell) = si.buf->ptr.i[ si.it ];
+                        break;
+                    case UR_VEC_F32:
+                        ur_setId(cell, UT_DOUBLE);
+                        ur_double(cell) = si.buf->ptr.f[ si.it ];
+                        break;
+                    case UR_VEC_F64:
+                        ur_setId(cell, UT_DOUBLE);
+                        ur_double(cell) = si.buf->ptr.d[ si.it ];
+                        break;
+                }
+                break;
+
+            default:
+                dt->pick( si.buf, si.it, cell );
+                break;
+        }
+
+        if( ! boron_doBlock( ut, body, res ) )
+        {
+            if( boron_catchWord( ut, UR_ATOM_BREAK ) )
+                break;
+            return UR_THROW;
+        }
+
+        // Re-aquire buf & end.
+        if( map )
+        {
+            if( ! (buf = ur_bufferSerM( sarg )) )
+                return UR_THROW;
+            si.end = _sliceEnd( buf, sarg );
+            if( si.it >= si.end )
+                break;
+            if( type == UT_BLOCK )
+                buf->ptr.cell[ si.it ] = *res;
+            else
+                dt->poke( buf, si.it, res );
+            si.buf = buf;
+        }
+        else
+        {
+            si.buf = ur_bufferSer( sarg );
+            si.end = _sliceEnd( si.buf, sarg );
+        }
+        if( ctxN != UR_INVALID_BUF )
+            cell = ur_buffer(ctxN)->ptr.cell + word->word.index;
+        if( type == UT_UNSET )
+            si.it = boron_seriesStep( ut, si.buf, si.it, 1 );
+        else
+            ++si.it;
+    }
+    return UR_OK;
+}
+
+
 /*-cf-
     foreach
         'words  word!/block!  Value of element(s).
@@ -3049,6 +3258,7 @@ CFUNC(cfunc_foreach)
     UCell* cell;
     USeriesIter si;
     UBlockIterM wi;
+    UIndex start;
     int remove = ur_int(a1 + 3);
 
 
@@ -3109,6 +3319,9 @@ CFUNC(cfunc_foreach)
 
 loop:
 
+    if( ! remove && wi.end - words == 1 )
+        return _eachWord( ut, words, sarg, body, res, 0 );
+
     dt = SERIES_DT( ur_type(sarg) );
     if( remove )
     {
@@ -3122,12 +3335,14 @@ loop:
     }
     while( si.it < si.end )
     {
+        start = si.it;
         wi.it = words;
         ur_foreach( wi )
         {
             if( ! (cell = ur_wordCellM(ut, wi.it)) )
                 return UR_THROW;
-            dt->pick( si.buf, si.it++, cell ); 
+            dt->pick( si.buf, si.it, cell );
+            si.it = boron_seriesStep( ut, si.buf, si.it, 1 );
         }
         if( ! boron_doBlock( ut, body, res ) )
         {
@@ -3141,7 +3356,8 @@ loop:
 
         if( remove && ur_true(res) )
         {
-            si.it  -= remove;
+            remove = si.it - start;
+            si.it  = start;
             si.end -= remove;
             dt->remove( ut, (USeriesIterM*) &si, remove );
         }
@@ -3201,7 +3417,8 @@ CFUNC(cfunc_forall)
             return UR_THROW;
         if( ur_type(sarg) != type )     // Checks if word cell changed.
             break;
-        ++sarg->series.it;
+        sarg->series.it = boron_seriesStep( ut, ur_bufferSer(sarg),
+                                            sarg->series.it, 1 );
         ur_seriesSlice( ut, &si, sarg );
     }
     return UR_OK;
@@ -3221,34 +3438,15 @@ CFUNC(cfunc_forall)
 */
 CFUNC(cfunc_map)
 {
-    const USeriesType* dt;
     UCell* sarg = a2;
-    UCell* body = a3;
-    UCell* cell;
-    USeriesIter si;
-
 
     if( ! ur_isSeriesType( ur_type(sarg) ) )
         return boron_badArg( ut, ur_type(sarg), 1 );
     if( ur_isShared( sarg->series.buf ) )
         return errorType( "map cannot modify shared series" );
 
-    ur_seriesSlice( ut, &si, sarg );
-    dt = SERIES_DT( ur_type(sarg) );
-
-    ur_foreach( si )
-    {
-        if( ! (cell = ur_wordCellM(ut, a1)) )
-            return UR_THROW;
-        dt->pick( ur_bufferSer(sarg), si.it, cell ); 
-        if( ! boron_doBlock( ut, body, res ) )
-        {
-            if( boron_catchWord( ut, UR_ATOM_BREAK ) )
-                break;
-            return UR_THROW;
-        }
-        dt->poke( ur_bufferSerM(sarg), si.it, res ); 
-    }
+    if( ! _eachWord( ut, a1, sarg, a3, res, 1 ) )
+        return UR_THROW;
     *res = *sarg;
     return UR_OK;
 }
@@ -3781,6 +3979,9 @@ CFUNC(cfunc_setenv)
     see: close
 
     Create port!.
+
+    On Linux a file! opened with /nowait reads ahead and writes in the
+    background using io_uring.
 */
 CFUNC(cfunc_open)
 {
@@ -3816,6 +4017,8 @@ CFUNC(cfunc_close)
 #define OPT_READ_INTO   0x02
 #define OPT_READ_APPEND 0x04
 #define OPT_READ_PART   0x08
+#define OPT_READ_MMAP   0x10
+#define OPT_READ_LINES  0x20
 
 /*
   \param len   Default length.
@@ -3923,6 +4126,138 @@ CFUNC_PUB(cfunc_readPort)
 }
 
 
+#define READ_LINES_CHUNK    0x10000
+
+/*
+  Read port or file in pieces and call handler with a block of the lines
+  completed by each read.  The input, text, and line block buffers are
+  reused for each call so memory use depends only on the longest line.
+*/
+static UStatus _readLines( UThread* ut, const UCell* srcC,
+                           const UCell* funC, UCell* res )
+{
+    UCell binC;
+    UCell* call;
+    UCell* cell;
+    UBuffer* buf;
+    UBuffer* text;
+    UBuffer* blk;
+    const uint8_t* it;
+    const uint8_t* end;
+    const uint8_t* nl;
+    UIndex bufN[4];
+    UIndex hold[4];
+    UStatus ok = UR_OK;
+    int eof = 0;
+    int i;
+
+    ur_genBuffers( ut, 4, bufN );           // gc!
+    ur_binInit( ur_buffer( bufN[0] ), READ_LINES_CHUNK );
+    ur_strInit( ur_buffer( bufN[1] ), UR_ENC_UTF8, 0 );
+    ur_blkInit( ur_buffer( bufN[2] ), UT_BLOCK, 0 );
+    buf = ur_buffer( bufN[3] );
+    ur_blkInit( buf, UT_BLOCK, 4 );
+    for( i = 0; i < 4; ++i )
+        hold[i] = ur_hold( bufN[i] );
+
+    // The call block is [lines handler :lines port].
+    call = buf->ptr.cell;
+    buf->used = 4;
+    ur_initSeries( call, UT_BLOCK, bufN[2] );
+    call[1] = *funC;
+    ur_setId(call + 2, UT_GETWORD);
+    ur_setBinding(call + 2, UR_BIND_THREAD);
+    call[2].word.ctx   = bufN[3];
+    call[2].word.index = 0;
+    call[2].word.atom  = UR_ATOM_X;
+    ur_setId(call + 3, UT_NONE);
+
+    if( ur_is(srcC, UT_PORT) )
+        call[3] = *srcC;
+    else if( ! port_file.open( ut, &port_file, srcC, UR_PORT_READ,
+                               call + 3 ) )     // gc!
+    {
+        ok = UR_THROW;
+        goto cleanup;
+    }
+
+    ur_initSeries( &binC, UT_BINARY, bufN[0] );
+    ur_setId(res, UT_NONE);
+
+    do
+    {
+        PORT_SITE(dev, pbuf, (call + 3));
+        if( ! dev )
+        {
+            ok = errorScript( "cannot read from closed port" );
+            break;
+        }
+        ur_binReserve( ur_buffer( bufN[0] ),
+                       ur_buffer( bufN[0] )->used + READ_LINES_CHUNK );
+        ok = dev->read( ut, pbuf, &binC, READ_LINES_CHUNK );
+        if( ! ok )
+            break;
+        eof = ur_is(&binC, UT_NONE);
+
+        // Find the end of the last complete line.
+        buf = ur_buffer( bufN[0] );
+        it  = buf->ptr.b;
+        end = it + buf->used;
+        if( ! eof )
+        {
+            while( end != it && end[-1] != '\n' )
+                --end;
+        }
+        if( end == it )
+            continue;
+
+        // Move the complete lines to the text buffer.
+        text = ur_buffer( bufN[1] );
+        text->form = UR_ENC_UTF8;
+        text->used = 0;
+        ur_arrReserve( text, end - it );
+        memCpy( text->ptr.b, it, end - it );
+        text->used = end - it;
+        ur_strFlatten( text );
+        i = end - it;
+        buf->used -= i;
+        memMove( buf->ptr.b, buf->ptr.b + i, buf->used );
+
+        blk = ur_buffer( bufN[2] );
+        blk->used = 0;
+        it  = text->ptr.b;
+        end = it + text->used;
+        while( it != end )
+        {
+            nl = (const uint8_t*) memchr( it, '\n', end - it );
+            if( ! nl )
+                nl = end;
+            i = nl - text->ptr.b;
+            if( nl != it && nl[-1] == '\r' )
+                --i;
+            cell = ur_blkAppendNew( blk, UT_STRING );
+            ur_setSlice( cell, bufN[1], it - text->ptr.b, i );
+            it = (nl == end) ? end : nl + 1;
+        }
+
+        if( ! boron_eval1( ut, call + 1, call + 3, res ) )
+        {
+            ok = UR_THROW;
+            break;
+        }
+    }
+    while( ! eof );
+
+    if( ! ur_is(srcC, UT_PORT) )
+        DT( UT_PORT )->destroy( ur_buffer( call[3].port.buf ) );
+
+cleanup:
+    for( i = 0; i < 4; ++i )
+        ur_release( hold[i] );
+    return ok;
+}
+
+
 extern int ur_readDir( UThread*, const char* filename, UCell* res );
 
 /*-cf-
@@ -3935,6 +4270,9 @@ extern int ur_readDir( UThread*, const char* filename, UCell* res );
             abuf    binary!/string!
         /part       Read a specific number of bytes.
             size    int!
+        /mmap       Map file into memory rather than copying it.
+        /lines      Read in pieces and call handler with each block of lines.
+            handler func!/cfunc!
     return: binary!/string!/block!/none!
     group: io
     see: load, write
@@ -3950,6 +4288,17 @@ extern int ur_readDir( UThread*, const char* filename, UCell* res );
 
     If source is a directory name then a block containing file names is
     returned.
+
+    The /mmap option avoids copying large files by mapping them into memory.
+    Changes to the mapped series are not written to the file and the series
+    is moved to normal memory if it grows.  This option is ignored when
+    used with /into, /append, or /part, or if the file cannot be mapped.
+
+    With /lines the handler is called with a block of string! slices for
+    the complete lines of each read, without the line endings.  The block
+    and the text it references are reused for the next call, so copy any
+    line that must be kept.  The result of the last handler call is
+    returned, or none! if the source is empty.  Other options are ignored.
 */
 CFUNC(cfunc_read)
 {
@@ -3959,6 +4308,14 @@ CFUNC(cfunc_read)
     int len;
 
 
+    opt = CFUNC_OPTIONS;
+    if( opt & OPT_READ_LINES )
+    {
+        if( ! ur_is(a1, UT_FILE) && ! ur_is(a1, UT_PORT) )
+            return errorType( "read /lines expected file!/port! source" );
+        return _readLines( ut, a1, CFUNC_OPT_ARG(6), res );
+    }
+
     if( ur_is(a1, UT_PORT) )
         return cfunc_readPort( ut, a1, res );
 
@@ -3974,7 +4331,24 @@ CFUNC(cfunc_read)
     if( info.type == FI_Dir )
         return ur_readDir( ut, filename, res );
 
-    opt = CFUNC_OPTIONS;
+    if( (opt & OPT_READ_MMAP) &&
+        ! (opt & (OPT_READ_INTO | OPT_READ_APPEND | OPT_READ_PART)) )
+    {
+        UIndex bufN;
+        UBuffer* buf = ur_genBuffers( ut, 1, &bufN );   // gc!
+        if( ur_binInitMapped( buf, filename ) )
+        {
+            if( opt & OPT_READ_TEXT )
+            {
+                ur_binToStr( buf, UR_ENC_UTF8 );
+                ur_strFlatten( buf );
+            }
+            ur_initSeries( res, buf->type, bufN );
+            return UR_OK;
+        }
+        // The unused empty binary is left for the recycler.
+    }
+
     len = _readBuffer( ut, opt, a1, res, (int) info.size ); // gc!
     if( len > 0 )
     {
@@ -4023,15 +4397,46 @@ CFUNC(cfunc_read)
 }
 
 
+/*
+  Write string or binary data to file.  Strings which are not ASCII are
+  converted to UTF-8 using tmp.
+*/
+static void _fwriteSeries( UThread* ut, FILE* fp, const UCell* data,
+                           UBuffer* tmp )
+{
+    USeriesIter si;
+    ur_seriesSlice( ut, &si, data );
+
+    if( ur_is(data, UT_STRING) )
+    {
+        if( ur_strIsUcs2(si.buf) ||
+            ((si.buf->form == UR_ENC_LATIN1) && ! ur_strIsAscii(si.buf)) )
+        {
+            // Convert to UTF-8.
+            tmp->used = 0;
+            ur_strAppend( tmp, si.buf, si.it, si.end );
+            fwrite( tmp->ptr.b, 1, tmp->used, fp );
+            return;
+        }
+    }
+    fwrite( si.buf->ptr.b + si.it, 1, si.end - si.it, fp );
+}
+
+
 /*-cf-
     write
         dest    file!/string!/port!
-        data    binary!/string!/context!
+        data    binary!/string!/context!/block!
         /append
         /text   Emit new lines with carriage returns on Windows.
     return: unset!
     group: io
     see: read, save
+
+    A block of binary! and string! values can be written to a file, file
+    port, or socket port without first joining them together.  Large output
+    can therefore be collected as a block of pieces and written once rather
+    than appended to a single string.
 */
 CFUNC(cfunc_write)
 {
@@ -4056,45 +4461,35 @@ CFUNC(cfunc_write)
         ut->types[ UT_CONTEXT ]->toText( ut, data, str, 0 );
         data = res;
     }
+    else if( ur_is(data, UT_BLOCK) )
+    {
+        UBlockIt bi;
+        ur_blockIt( ut, &bi, data );
+        ur_foreach( bi )
+        {
+            if( ! ur_is(bi.it, UT_BINARY) && ! ur_is(bi.it, UT_STRING) )
+                return errorType( "write expected block of binary!/string!" );
+        }
+    }
 
-    if( ur_is(data, UT_BINARY) || ur_is(data, UT_STRING) )
+    if( ur_is(data, UT_BINARY) || ur_is(data, UT_STRING) ||
+        ur_is(data, UT_BLOCK) )
     {
         FILE* fp;
+        UBuffer tmp;
         const char* filename;
         const char* mode;
-        USeriesIter si;
-        UIndex size;
-        size_t n;
+        int opt;
 
         filename = boron_cstr( ut, a1, 0 );
 
         if( ! boron_requestAccess( ut, "Write file \"%s\"", filename ) )
             return UR_THROW;
 
-        ur_seriesSlice( ut, &si, data );
-        size = si.end - si.it;
-
-        if( ur_is(data, UT_STRING) )
+        opt = CFUNC_OPTIONS;
         {
-            if( ur_strIsUcs2(si.buf) ||
-                ((si.buf->form == UR_ENC_LATIN1) && ! ur_strIsAscii(si.buf)) )
-            {
-                // Convert to UTF-8.
-
-                UIndex nn = ur_makeString( ut, UR_ENC_UTF8, 0 );
-                // si.buf is invalid after make.
-                si.buf = ur_buffer(nn);
-                ur_strAppend( (UBuffer*) si.buf, ur_bufferSer(data),
-                              si.it, si.end );
-                si.it = 0;
-                size = si.buf->used;
-            }
-        }
-
-        n = CFUNC_OPTIONS;
-        {
-        int append = n & OPT_WRITE_APPEND;
-        if( n & OPT_WRITE_TEXT )
+        int append = opt & OPT_WRITE_APPEND;
+        if( opt & OPT_WRITE_TEXT )
             mode = append ? "a" : "w";
         else
             mode = append ? "ab" : "wb";
@@ -4107,14 +4502,203 @@ CFUNC(cfunc_write)
                              "could not open %s", filename );
         }
 
-        n = fwrite( si.buf->ptr.b + si.it, 1, size, fp );
+        ur_strInit( &tmp, UR_ENC_UTF8, 0 );
+        if( ur_is(data, UT_BLOCK) )
+        {
+            UBlockIt bi;
+            ur_blockIt( ut, &bi, data );
+            ur_foreach( bi )
+                _fwriteSeries( ut, fp, bi.it, &tmp );
+        }
+        else
+        {
+            _fwriteSeries( ut, fp, data, &tmp );
+        }
+        ur_strFree( &tmp );
         fclose( fp );
 
         ur_setId(res, UT_UNSET);
         return UR_OK;
     }
     else
-        return errorType( "write expected binary!/string!/context! data" );
+        return errorType( "write expected binary!/string!/context!/block! data" );
+}
+
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#ifndef SPLICE_F_MOVE
+#define SPLICE_F_MOVE   1
+#endif
+
+
+/*
+  Return file descriptor which the kernel can send to/from directly, or -1.
+  Both file & socket ports keep their descriptor in UBuffer::used.
+*/
+static int _transferFD( const UPortDevice* dev, const UBuffer* pbuf )
+{
+    if( dev == &port_file )
+        return pbuf->used;
+#ifdef CONFIG_SOCKET
+    if( dev == &port_socket && pbuf->elemSize /*TCP*/ )
+        return pbuf->used;
+#endif
+    return -1;
+}
+
+
+/*
+  Move data between descriptors inside the kernel.  Sendfile requires a
+  source which can be mapped and splice requires one end to be a pipe.
+
+  Return number of bytes moved, -1 if neither call works with these
+  descriptors, or -2 if an error is set in errno.
+*/
+static int64_t _transferKernel( int in, int out, int64_t len )
+{
+    struct pollfd pfd;
+    int64_t total = 0;
+    ssize_t n;
+    int useSplice = 0;
+
+    while( len )
+    {
+        size_t part = (len < 0 || len > 0x7ffff000) ? 0x7ffff000 : len;
+        if( useSplice )
+            n = syscall( SYS_splice, in, NULL, out, NULL, part,
+                         SPLICE_F_MOVE );
+        else
+            n = sendfile( out, in, NULL, part );
+        if( n > 0 )
+        {
+            total += n;
+            if( len > 0 )
+                len -= n;
+        }
+        else if( n == 0 )
+            break;
+        else if( errno == EINTR )
+            continue;
+        else if( errno == EAGAIN )
+        {
+            pfd.fd = out;
+            pfd.events = POLLOUT;
+            poll( &pfd, 1, -1 );
+        }
+        else if( total == 0 && (errno == EINVAL || errno == ENOSYS) )
+        {
+            if( useSplice )
+                return -1;
+            useSplice = 1;
+        }
+        else
+            return -2;
+    }
+    return total;
+}
+#endif
+
+
+#define TRANSFER_CHUNK  0x10000
+
+/*-cf-
+    transfer
+        source  port!
+        dest    port!
+        /part   Limit number of bytes sent.
+            size    int!
+    return: Number of bytes sent.
+    group: io
+    see: read, write
+
+    Send data from source to dest until the end of source is reached.
+
+    On Linux the data is moved with sendfile or splice when source is a file
+    port and dest is a file or TCP socket port, so it is never copied into a
+    binary!.  Other ports are read & written in pieces.  A source which
+    was opened with /nowait stops when no data is ready.
+*/
+CFUNC(cfunc_transfer)
+{
+#define OPT_TRANSFER_PART   0x01
+    UBuffer* buf;
+    UCell* binC;
+    int64_t len = -1;
+    int64_t total = 0;
+    UIndex hold;
+    UStatus ok = UR_OK;
+
+    if( CFUNC_OPTIONS & OPT_TRANSFER_PART )
+    {
+        len = ur_int( CFUNC_OPT_ARG(1) );
+        if( len < 0 )
+            len = 0;
+    }
+
+#ifdef __linux__
+    {
+    PORT_SITE(sdev, sbuf, a1);
+    PORT_SITE(ddev, dbuf, a2);
+    int in  = sdev ? _transferFD( sdev, sbuf ) : -1;
+    int out = ddev ? _transferFD( ddev, dbuf ) : -1;
+    if( in > -1 && out > -1 )
+    {
+        total = _transferKernel( in, out, len );
+        if( total == -2 )
+            return ur_error( ut, UR_ERR_ACCESS, "transfer %s",
+                             strerror( errno ) );
+        if( total >= 0 )
+        {
+            ur_setId(res, UT_INT);
+            ur_int(res) = total;
+            return UR_OK;
+        }
+        total = 0;
+    }
+    }
+#endif
+
+    // Copy through a binary! buffer.
+    binC = res;
+    buf = ur_makeBinaryCell( ut, TRANSFER_CHUNK, binC );    // gc!
+    hold = ur_hold( binC->series.buf );
+    while( len )
+    {
+        PORT_SITE(sdev, sbuf, a1);
+        PORT_SITE(ddev, dbuf, a2);
+        int part = (len < 0 || len > TRANSFER_CHUNK) ? TRANSFER_CHUNK : len;
+
+        if( ! sdev || ! ddev )
+        {
+            ok = errorScript( "cannot transfer with closed port" );
+            break;
+        }
+        buf = ur_buffer( binC->series.buf );
+        buf->used = 0;
+        ur_binReserve( buf, part );
+        ok = sdev->read( ut, sbuf, binC, part );
+        if( ! ok || ur_is(binC, UT_NONE) )
+            break;
+        buf = ur_buffer( binC->series.buf );
+        if( ! buf->used )
+            break;
+        total += buf->used;
+        if( len > 0 )
+            len -= buf->used;
+        ok = ddev->write( ut, dbuf, binC );
+        if( ! ok )
+            break;
+    }
+    ur_release( hold );
+    if( ! ok )
+        return UR_THROW;
+
+    ur_setId(res, UT_INT);
+    ur_int(res) = total;
+    return UR_OK;
 }
 
 
@@ -4214,17 +4798,131 @@ CFUNC( cfunc_unserialize )
 
 extern int ur_serializedHeader( const uint8_t* data, int len );
 
+#define LOAD_STREAM_CHUNK   0x10000
+
+/*
+  Read file or port in pieces and call handler with each block of completed
+  values.
+*/
+static UStatus _loadStream( UThread* ut, const UCell* srcC,
+                            const UCell* funC, UCell* res )
+{
+    UTokenizer tok;
+    UCell binC;
+    UCell* call;
+    UBuffer* buf;
+    UIndex bufN[2];
+    UIndex hold[2];
+    UStatus ok;
+    int eof = 0;
+
+    ur_genBuffers( ut, 2, bufN );           // gc!
+    ur_binInit( ur_buffer( bufN[0] ), LOAD_STREAM_CHUNK );
+    hold[0] = ur_hold( bufN[0] );
+    buf = ur_buffer( bufN[1] );
+    ur_blkInit( buf, UT_BLOCK, 4 );
+    hold[1] = ur_hold( bufN[1] );
+
+    // The call block is [values handler :values port].
+    call = buf->ptr.cell;
+    buf->used = 4;
+    ur_setId(call, UT_NONE);
+    call[1] = *funC;
+    ur_setId(call + 2, UT_GETWORD);
+    ur_setBinding(call + 2, UR_BIND_THREAD);
+    call[2].word.ctx   = bufN[1];
+    call[2].word.index = 0;
+    call[2].word.atom  = UR_ATOM_X;
+    ur_setId(call + 3, UT_NONE);
+
+    if( ur_is(srcC, UT_PORT) )
+        call[3] = *srcC;
+    else if( ! port_file.open( ut, &port_file, srcC, UR_PORT_READ,
+                               call + 3 ) )     // gc!
+    {
+        ok = UR_THROW;
+        goto cleanup;
+    }
+
+    ur_initSeries( &binC, UT_BINARY, bufN[0] );
+    ur_tokenizeInit( &tok, UR_ENC_UTF8, UR_INVALID_BUF );
+    ur_setId(res, UT_NONE);
+
+    do
+    {
+        PORT_SITE(dev, pbuf, (call + 3));
+        if( ! dev )
+        {
+            ok = errorScript( "cannot read from closed port" );
+            break;
+        }
+        ur_buffer( bufN[0] )->used = 0;
+        ok = dev->read( ut, pbuf, &binC, LOAD_STREAM_CHUNK );
+        if( ! ok )
+            break;
+        eof = ur_is(&binC, UT_NONE);
+
+        ur_makeBlockCell( ut, UT_BLOCK, 0, call );      // gc!
+        tok.blkN = call->series.buf;
+        buf = ur_buffer( bufN[0] );
+        if( eof )
+            ok = ur_tokenizeFeed( ut, &tok, NULL, NULL );
+        else
+            ok = ur_tokenizeFeed( ut, &tok, buf->ptr.b,
+                                  buf->ptr.b + buf->used );
+        if( ! ok )
+            break;
+
+        if( ur_buffer( tok.blkN )->used )
+        {
+            boron_bindDefault( ut, tok.blkN );
+            if( ! boron_eval1( ut, call + 1, call + 3, res ) )
+            {
+                ok = UR_THROW;
+                break;
+            }
+        }
+    }
+    while( ! eof );
+
+    ur_tokenizeFree( &tok );
+    if( ! ur_is(srcC, UT_PORT) )
+        DT( UT_PORT )->destroy( ur_buffer( call[3].port.buf ) );
+
+cleanup:
+    ur_release( hold[0] );
+    ur_release( hold[1] );
+    return ok;
+}
+
+
 /*-cf-
     load
-        file    file!/string!/binary!
+        file    file!/string!/binary!/port!
+        /stream Read file or port in pieces and call handler with the values
+                loaded.
+            handler func!/cfunc!
     return: block! or none! if file is empty.
     group: io
     see: read, save
 
     Load file or serialized data with default bindings.
+
+    With /stream the handler is called with a block of the top level
+    values completed by each read, so that large data files or logs can be
+    processed without holding all of them in memory.  The result of the
+    last handler call is returned, or none! if no values were loaded.
 */
 CFUNC(cfunc_load)
 {
+#define OPT_LOAD_STREAM 0x01
+    if( CFUNC_OPTIONS & OPT_LOAD_STREAM )
+    {
+        if( ur_is(a1, UT_FILE) || ur_is(a1, UT_PORT) )
+            return _loadStream( ut, a1, CFUNC_OPT_ARG(1), res );
+        return errorType( "load /stream expected file!/port!" );
+    }
+
     if( ur_is(a1, UT_BINARY) )
     {
         if( cfunc_unserialize( ut, a1, res ) )
@@ -4340,7 +5038,7 @@ extern UStatus ur_parseBinary( UThread* ut, UBuffer*, UIndex start, UIndex end,
 
 extern UStatus ur_parseBlock( UThread* ut, UBuffer*, UIndex start, UIndex end,
                               UIndex* parsePos, const UBuffer* ruleBlk,
-                              UStatus (*eval)( UThread*, const UCell* ) );
+                              UStatus (*eval)( UThread*, const UCell* ), int );
 
 extern UStatus ur_parseString( UThread* ut, UBuffer*, UIndex start, UIndex end,
                                UIndex* parsePos, const UBuffer* ruleBlk,
@@ -4352,13 +5050,21 @@ extern UStatus ur_parseString( UThread* ut, UBuffer*, UIndex start, UIndex end,
         rules   block!
         /case   Character case must match when comparing strings.
         /binary Parse binary! using binary structure language.
+        /memo   Remember the result of word sub-rules at each input position.
     return:  True if end of input reached.
     group: data
+
+    With /memo a sub-rule referenced by a word is only parsed once at any
+    input position, so grammars with many backtracking alternatives run in
+    linear time.  When the remembered result is used, any parens in that
+    sub-rule are not evaluated again.  The memo table has a fixed size so
+    very large inputs may still have some repeated parsing.
 */
 CFUNC(cfunc_parse)
 {
 #define OPT_PARSE_CASE      0x01
 #define OPT_PARSE_BINARY    0x02
+#define OPT_PARSE_MEMO      0x04
     uint32_t opt = CFUNC_OPTIONS;
     USeriesIterM si;
     const UBuffer* rules;
@@ -4384,11 +5090,14 @@ CFUNC(cfunc_parse)
 
         case UT_STRING:
             ok = ur_parseString( ut, si.buf, si.it, si.end, &pos, rules,
-                                 boron_doVoid, opt & OPT_PARSE_CASE );
+                                 boron_doVoid,
+                                 ((opt & OPT_PARSE_CASE) ? UR_PARSE_CASE : 0) |
+                                 ((opt & OPT_PARSE_MEMO) ? UR_PARSE_MEMO : 0) );
             break;
         case UT_BLOCK:
             ok = ur_parseBlock( ut, si.buf, si.it, si.end, &pos, rules,
-                                boron_doVoid );
+                                boron_doVoid,
+                                (opt & OPT_PARSE_MEMO) ? UR_PARSE_MEMO : 0 );
             break;
     }
     if( ! ok )
@@ -4769,7 +5478,8 @@ CFUNC(cfunc_terminate)
     ur_seriesSliceM( ut, &si, a1 );
     if( si.it != si.end )
     {
-        SERIES_DT( type )->pick( si.buf, si.end - 1, res );
+        SERIES_DT( type )->pick( si.buf,
+                                 boron_seriesStep( ut, si.buf, si.end, -1 ), res );
         if( ur_equal( ut, val, res ) )
             goto done;
         if( CFUNC_OPTIONS & OPT_TERMINATE_DIR )
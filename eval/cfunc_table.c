@@ -76,7 +76,8 @@ DEF_CF( cfunc_insert,  "insert ser val /block /part n /repeat a int!\n" )
 DEF_CF( cfunc_change,  "change ser val /slice /part n\n" )
 DEF_CF( cfunc_remove,  "remove ser /slice /part n int! /key val\n" )
 DEF_CF( cfunc_reverse, "reverse ser /part n int!\n" )
-DEF_CF( cfunc_find,    "find ser val /last /case /part n\n" )
+DEF_CF( cfunc_find,    "find ser val /last /case /part n /pattern\n" )
+DEF_CF( cfunc_index_series, "index-series ser block! /skip n int!\n" )
 DEF_CF( cfunc_clear,   "clear ser\n" )
 DEF_CF( cfunc_slice,   "slice ser n\n" )
 DEF_CF( cfunc_emptyQ,  "empty? ser\n" )
@@ -92,7 +93,7 @@ DEF_CF( cfunc_intersect,  "intersect a b /case\n" )
 DEF_CF( cfunc_difference, "difference a b /case\n" )
 DEF_CF( cfunc_union,      "union a b /case\n" )
 DEF_CF( cfunc_sort,       "sort ser /case /group size int!"
-                            " /field b block!\n" )
+                            " /field b block! /stable /key f func!/cfunc!\n" )
 DEF_CF( cfunc_foreach,    "foreach 'w s body 0 /no-trace\n" )
 DEF_CF( cfunc_foreach,    "remove-each 'w s body 1 /no-trace\n" )
 DEF_CF( cfunc_forall,     "forall 'w word! body block! /no-trace\n" )
@@ -107,14 +108,16 @@ DEF_CF( cfunc_getenv,     "getenv name string!\n" )
 DEF_CF( cfunc_setenv,     "setenv name string! val\n" )
 DEF_CF( cfunc_open,       "open from /read /write /new /nowait\n" )
 DEF_CF( cfunc_read,       "read from /text /into b /append a"
-                            " /part size int!\n" )
+                            " /part size int! /mmap"
+                            " /lines handler func!/cfunc!\n" )
 DEF_CF( cfunc_write,      "write to data /append /text\n" )
+DEF_CF( cfunc_transfer,   "transfer from port! to port! /part size int!\n" )
 DEF_CF( cfunc_delete,     "delete file string!/file!\n" )
 DEF_CF( cfunc_rename,     "rename a string!/file! b string!/file!\n" )
-DEF_CF( cfunc_load,       "load from\n" )
+DEF_CF( cfunc_load,       "load from /stream f func!/cfunc!\n" )
 DEF_CF( cfunc_save,       "save to data\n" )
 DEF_CF( cfunc_parse,      "parse input binary!/string!/block!"
-                            " rules block! /case /binary\n" )
+                            " rules block! /case /binary /memo\n" )
 DEF_CF( cfunc_sameQ,      "same? a b\n" )
 DEF_CF( cfunc_equalQ,     "equal? a b\n" )
 DEF_CF( cfunc_neQ,        "ne? a b\n" )
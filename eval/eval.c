@@ -7,7 +7,7 @@
 #include <assert.h>
 #include <string.h>
 #include "boron.h"
-#include "i_parse_blk.c"
+#include "i_parse_blk.h"
 #include "mem_util.h"
 
 //#define REPORT_EVAL
@@ -459,6 +459,7 @@ void boron_compileArgProgram( BoronThread* bt, const UCell* specC,
         ac.bp.rules  = _argRules;
         ac.bp.report = _argRuleHandler;
         ac.bp.rflag  = 0;
+        ac.bp.base   = ac.bp.it;
         ac.bin = prog;
         ac.stackMapN = bodyN;
         ur_ctxInit( &ac.sval, 0 );
@@ -96,11 +96,25 @@ emit_column:
                     si.end = tmp.used;
                 }
 
-                dlen = si.end - si.it;
-                if( dlen > limit )
+                if( UTF8_SERIES(si.buf) )
                 {
-                    dlen = limit;
-                    si.end = si.it + limit;
+                    dlen = ur_strCharIndex( ut, si.buf, si.end ) -
+                           ur_strCharIndex( ut, si.buf, si.it );
+                    if( dlen > limit )
+                    {
+                        dlen = limit;
+                        si.end = ur_strCharPos( ut, si.buf,
+                                ur_strCharIndex( ut, si.buf, si.it ) + limit );
+                    }
+                }
+                else
+                {
+                    dlen = si.end - si.it;
+                    if( dlen > limit )
+                    {
+                        dlen = limit;
+                        si.end = si.it + limit;
+                    }
                 }
 
                 if( colWidth < 0 )
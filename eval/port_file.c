@@ -19,6 +19,7 @@
 
 
 #include "boron.h"
+#include "os.h"
 
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -42,12 +43,26 @@
 #define ssize_t int
 #else
 #include <unistd.h>
+#include <sys/uio.h>
+#endif
+
+#if defined(__linux__) && ! defined(NO_ASYNC_FILE)
+#define ASYNC_FILE
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
 #endif
 
 
 #define FD  used
 
 
+#ifdef ASYNC_FILE
+static int afile_open( UThread*, int fd, int opt, UCell* res );
+#endif
+
+
 static int file_open( UThread* ut, const UPortDevice* pdev, const UCell* from,
                       int opt, UCell* res )
 {
@@ -85,6 +100,10 @@ static int file_open( UThread* ut, const UPortDevice* pdev, const UCell* from,
         fd = open( path, flags, S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH );
         if( fd == -1 )
             return ur_error( ut, UR_ERR_ACCESS, strerror( errno ) );
+#ifdef ASYNC_FILE
+        if( opt & UR_PORT_NOWAIT )
+            return afile_open( ut, fd, opt, res );
+#endif
     }
     else
     {
@@ -124,6 +143,26 @@ static int file_read( UThread* ut, UBuffer* port, UCell* dest, int len )
 }
 
 
+/*
+  Check that a block to be written to a port holds only binary! & string!
+  values.
+
+  \return UR_OK or UR_THROW.
+*/
+int boron_checkWriteBlock( UThread* ut, const UCell* blkC )
+{
+    UBlockIt bi;
+    ur_blockIt( ut, &bi, blkC );
+    ur_foreach( bi )
+    {
+        if( ! ur_is(bi.it, UT_BINARY) && ! ur_is(bi.it, UT_STRING) )
+            return ur_error( ut, UR_ERR_TYPE,
+                             "write expected block of binary!/string!" );
+    }
+    return UR_OK;
+}
+
+
 int boron_sliceMem( UThread* ut, const UCell* cell, const void** ptr )
 {
     int len = 0;
@@ -160,11 +199,97 @@ int boron_sliceMem( UThread* ut, const UCell* cell, const void** ptr )
 }
 
 
+#ifndef _WIN32
+#define IOV_BATCH   64
+
+/*
+  Write each binary!/string! of a block with as few system calls as possible.
+*/
+static int file_writeBlock( UThread* ut, UBuffer* port, const UCell* data )
+{
+    struct iovec iov[ IOV_BATCH ];
+    struct iovec* vp;
+    const void* buf;
+    UBlockIt bi;
+    ssize_t len;
+    ssize_t count;
+    int n = 0;
+
+    ur_blockIt( ut, &bi, data );
+    while( 1 )
+    {
+        if( n == IOV_BATCH || (bi.it == bi.end && n) )
+        {
+            len = 0;
+            for( vp = iov; vp != iov + n; ++vp )
+                len += vp->iov_len;
+
+            vp = iov;
+            while( 1 )
+            {
+                count = writev( port->FD, vp, n );
+                if( count < 0 )
+                    return ur_error( ut, UR_ERR_ACCESS, strerror( errno ) );
+                if( count == len )
+                    break;
+
+                // Partial write; skip what was done and try again.
+                len -= count;
+                while( (size_t) count >= vp->iov_len )
+                {
+                    count -= vp->iov_len;
+                    ++vp;
+                    --n;
+                }
+                vp->iov_base = (char*) vp->iov_base + count;
+                vp->iov_len -= count;
+            }
+            n = 0;
+        }
+        if( bi.it == bi.end )
+            break;
+
+        len = boron_sliceMem( ut, bi.it, &buf );
+        if( len )
+        {
+            iov[ n ].iov_base = (void*) buf;
+            iov[ n ].iov_len  = len;
+            ++n;
+        }
+        ++bi.it;
+    }
+    return UR_OK;
+}
+#endif
+
+
 static int file_write( UThread* ut, UBuffer* port, const UCell* data )
 {
     const void* buf;
     ssize_t count;
-    ssize_t len = boron_sliceMem( ut, data, &buf );
+    ssize_t len;
+
+    if( ur_is(data, UT_BLOCK) )
+    {
+        if( ! boron_checkWriteBlock( ut, data ) )
+            return UR_THROW;
+#ifdef _WIN32
+        {
+        UBlockIt bi;
+        ur_blockIt( ut, &bi, data );
+        ur_foreach( bi )
+        {
+            if( file_write( ut, port, bi.it ) != UR_OK )
+                return UR_THROW;
+        }
+        }
+        return UR_OK;
+#else
+        return file_writeBlock( ut, port, data );
+#endif
+    }
+
+    len = boron_sliceMem( ut, data, &buf );
     if( len )
     {
         count = write( port->FD, buf, len );
@@ -216,6 +341,677 @@ static int file_waitFD( UBuffer* port )
 #endif
 
 
+#ifdef ASYNC_FILE
+//----------------------------------------------------------------------------
+// Asynchronous file port
+/*
+  A file opened with /nowait reads ahead and writes in the background using
+  io_uring.  Wait is signaled through an eventfd when an operation completes.
+  Read blocks until the read-ahead data has arrived unless wait was called
+  on the port since the last read, in which case it returns none if the
+  data is not yet ready.
+
+  Reads are ordered after any pending writes, and a write after a seek is
+  ordered after those before it.
+
+  If io_uring is not available the operations are handed to a worker thread
+  (when built with CONFIG_THREAD), or else done immediately when issued.
+  Either way they report through the eventfd so scripts behave the same.
+*/
+
+
+#define AFILE_READ_LEN  0x10000
+#define AFILE_WRITES    7
+#define AFILE_ENTRIES   8       // One read and AFILE_WRITES.
+
+enum AsyncOpState
+{
+    AF_IDLE,
+    AF_BUSY,
+    AF_DONE
+};
+
+typedef struct
+{
+    struct iovec iov;
+    int64_t  offset;
+    int32_t  result;        // Byte count or -errno.
+    int32_t  state;         // AsyncOpState
+}
+AsyncOp;
+
+typedef struct
+{
+    int fd;                 // Zero if io_uring is not used.
+    unsigned* sqHead;
+    unsigned* sqTail;
+    unsigned* sqMask;
+    unsigned* sqArray;
+    unsigned* cqHead;
+    unsigned* cqTail;
+    unsigned* cqMask;
+    struct io_uring_sqe* sqes;
+    struct io_uring_cqe* cqes;
+    void*  sqMap;
+    void*  cqMap;
+    size_t sqMapLen;
+    size_t cqMapLen;
+    size_t sqesLen;
+}
+URing;
+
+#ifdef CONFIG_THREAD
+typedef struct
+{
+    AsyncOp* op;
+    int32_t  arg;           // Opcode when queued, result when done.
+}
+AsyncJob;
+
+typedef struct
+{
+    OSThread thread;
+    OSMutex  mutex;
+    OSCond   jobCond;       // Signaled when a job is queued or on quit.
+    OSCond   doneCond;      // Signaled when a job is done.
+    AsyncJob jobs[ AFILE_ENTRIES ];
+    AsyncJob done[ AFILE_ENTRIES ];
+    int jobHead;
+    int jobCount;
+    int doneCount;
+    int quit;
+    int running;            // Set when the thread was started.
+}
+AsyncWorker;
+#endif
+
+typedef struct
+{
+    const UPortDevice* dev;
+    int fd;
+    int eventFd;
+    int readable;
+    int error;              // Errno of a failed write to report.
+    int polled;             // Set by waitFD; read will not block.
+    int drain;              // Order next operation after pending ones.
+    int64_t pos;            // File offset of next read-ahead or write.
+    int32_t readUsed;       // Bytes of read-ahead already returned.
+    int32_t writesBusy;
+    AsyncOp rd;
+    AsyncOp wr[ AFILE_WRITES ];
+    URing ring;
+#ifdef CONFIG_THREAD
+    AsyncWorker worker;
+#endif
+}
+AsyncFile;
+
+
+extern UPortDevice port_fileAsync;
+
+#define AFILE(port)     ur_ptr(AsyncFile, port)
+
+
+static int _uringSetup( URing* ring, int eventFd )
+{
+    struct io_uring_params par;
+    uint8_t* sq;
+    uint8_t* cq;
+    int fd;
+
+    memset( &par, 0, sizeof(par) );
+    fd = syscall( __NR_io_uring_setup, AFILE_ENTRIES, &par );
+    if( fd < 0 )
+        return 0;
+
+    ring->sqMapLen = par.sq_off.array + par.sq_entries * sizeof(unsigned);
+    ring->cqMapLen = par.cq_off.cqes +
+                     par.cq_entries * sizeof(struct io_uring_cqe);
+    ring->sqesLen  = par.sq_entries * sizeof(struct io_uring_sqe);
+
+    sq = mmap( 0, ring->sqMapLen, PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING );
+    if( sq == MAP_FAILED )
+        goto fail_sq;
+    cq = mmap( 0, ring->cqMapLen, PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING );
+    if( cq == MAP_FAILED )
+        goto fail_cq;
+    ring->sqes = mmap( 0, ring->sqesLen, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES );
+    if( ring->sqes == MAP_FAILED )
+        goto fail_sqes;
+
+    if( syscall( __NR_io_uring_register, fd, IORING_REGISTER_EVENTFD,
+                 &eventFd, 1 ) < 0 )
+    {
+        munmap( ring->sqes, ring->sqesLen );
+        goto fail_sqes;
+    }
+
+    ring->fd      = fd;
+    ring->sqMap   = sq;
+    ring->cqMap   = cq;
+    ring->sqHead  = (unsigned*) (sq + par.sq_off.head);
+    ring->sqTail  = (unsigned*) (sq + par.sq_off.tail);
+    ring->sqMask  = (unsigned*) (sq + par.sq_off.ring_mask);
+    ring->sqArray = (unsigned*) (sq + par.sq_off.array);
+    ring->cqHead  = (unsigned*) (cq + par.cq_off.head);
+    ring->cqTail  = (unsigned*) (cq + par.cq_off.tail);
+    ring->cqMask  = (unsigned*) (cq + par.cq_off.ring_mask);
+    ring->cqes    = (struct io_uring_cqe*) (cq + par.cq_off.cqes);
+    return 1;
+
+fail_sqes:
+    munmap( cq, ring->cqMapLen );
+fail_cq:
+    munmap( sq, ring->sqMapLen );
+fail_sq:
+    close( fd );
+    return 0;
+}
+
+
+static void _uringFree( URing* ring )
+{
+    if( ring->fd )
+    {
+        munmap( ring->sqes, ring->sqesLen );
+        munmap( ring->cqMap, ring->cqMapLen );
+        munmap( ring->sqMap, ring->sqMapLen );
+        close( ring->fd );
+        ring->fd = 0;
+    }
+}
+
+
+static void _afComplete( AsyncFile* af, AsyncOp* op, int32_t result )
+{
+    if( op == &af->rd )
+    {
+        op->result = result;
+        op->state  = AF_DONE;
+    }
+    else
+    {
+        if( result != (int32_t) op->iov.iov_len && ! af->error )
+            af->error = (result < 0) ? -result : EIO;
+        memFree( op->iov.iov_base );
+        op->iov.iov_base = 0;
+        op->state = AF_IDLE;
+        --af->writesBusy;
+    }
+}
+
+
+static int32_t _afTransfer( int fd, const AsyncOp* op, int opcode )
+{
+    ssize_t n;
+    if( opcode == IORING_OP_READV )
+        n = pread( fd, op->iov.iov_base, op->iov.iov_len, op->offset );
+    else
+        n = pwrite( fd, op->iov.iov_base, op->iov.iov_len, op->offset );
+    return (n < 0) ? -errno : (int32_t) n;
+}
+
+
+#ifdef CONFIG_THREAD
+/*
+  Worker thread used when io_uring is not available.  Jobs are done one at
+  a time in the order queued, which keeps reads after earlier writes.
+  A job is left in the queue until done so that _afSubmit never overfills
+  the done list.
+*/
+static void* _afWorkerThread( void* arg )
+{
+    AsyncFile* af = (AsyncFile*) arg;
+    AsyncWorker* w = &af->worker;
+    AsyncJob job;
+
+    mutexLock( w->mutex );
+    for(;;)
+    {
+        while( ! w->jobCount && ! w->quit )
+            condWaitF( w->jobCond, w->mutex );
+        if( ! w->jobCount )
+            break;
+        job = w->jobs[ w->jobHead ];
+        mutexUnlock( w->mutex );
+
+        job.arg = _afTransfer( af->fd, job.op, job.arg );
+
+        mutexLock( w->mutex );
+        w->jobHead = (w->jobHead + 1) % AFILE_ENTRIES;
+        --w->jobCount;
+        w->done[ w->doneCount++ ] = job;
+        condSignal( w->doneCond );
+        eventfd_write( af->eventFd, 1 );
+    }
+    mutexUnlock( w->mutex );
+    return NULL;
+}
+
+
+static void _afWorkerStart( AsyncFile* af )
+{
+    AsyncWorker* w = &af->worker;
+
+    if( mutexInitF( w->mutex ) )
+        return;
+    condInit( w->jobCond );
+    condInit( w->doneCond );
+    if( pthread_create( &w->thread, 0, _afWorkerThread, af ) != 0 )
+    {
+        condFree( w->doneCond );
+        condFree( w->jobCond );
+        mutexFree( w->mutex );
+        return;
+    }
+    w->running = 1;
+}
+
+
+/*
+  Stop the worker thread.  All jobs must be done & reaped.
+*/
+static void _afWorkerStop( AsyncFile* af )
+{
+    AsyncWorker* w = &af->worker;
+    if( w->running )
+    {
+        mutexLock( w->mutex );
+        w->quit = 1;
+        condSignal( w->jobCond );
+        mutexUnlock( w->mutex );
+        pthread_join( w->thread, NULL );
+        condFree( w->doneCond );
+        condFree( w->jobCond );
+        mutexFree( w->mutex );
+        w->running = 0;
+    }
+}
+#endif
+
+
+static void _afReap( AsyncFile*, int block );
+
+
+/*
+  Start a read or write of op->iov at op->offset.
+*/
+static void _afSubmit( AsyncFile* af, AsyncOp* op, int opcode )
+{
+    URing* ring = &af->ring;
+    int drain = af->drain;
+
+    op->state = AF_BUSY;
+    af->drain = 0;
+    if( op == &af->rd && af->writesBusy )
+        drain = 1;
+
+    if( ring->fd )
+    {
+        struct io_uring_sqe* sqe;
+        unsigned tail = *ring->sqTail;
+        unsigned i = tail & *ring->sqMask;
+
+        sqe = ring->sqes + i;
+        memset( sqe, 0, sizeof(*sqe) );
+        sqe->opcode    = opcode;
+        sqe->flags     = drain ? IOSQE_IO_DRAIN : 0;
+        sqe->fd        = af->fd;
+        sqe->off       = op->offset;
+        sqe->addr      = (uintptr_t) &op->iov;
+        sqe->len       = 1;
+        sqe->user_data = (uintptr_t) op;
+        ring->sqArray[ i ] = i;
+        __atomic_store_n( ring->sqTail, tail + 1, __ATOMIC_RELEASE );
+
+        if( syscall( __NR_io_uring_enter, ring->fd, 1, 0, 0, NULL, 0 ) == 1 )
+            return;
+        // Submit failed; do it the slow way.
+        __atomic_store_n( ring->sqTail, tail, __ATOMIC_RELEASE );
+
+        // Earlier operations may still be in flight on the ring.
+        if( drain )
+        {
+            while( (op == &af->rd) ? af->writesBusy : af->writesBusy > 1 )
+                _afReap( af, 1 );
+        }
+    }
+#ifdef CONFIG_THREAD
+    else if( af->worker.running )
+    {
+        AsyncWorker* w = &af->worker;
+        AsyncJob* job;
+
+        mutexLock( w->mutex );
+        job = w->jobs + (w->jobHead + w->jobCount) % AFILE_ENTRIES;
+        job->op  = op;
+        job->arg = opcode;
+        ++w->jobCount;
+        condSignal( w->jobCond );
+        mutexUnlock( w->mutex );
+        return;
+    }
+#endif
+
+    _afComplete( af, op, _afTransfer( af->fd, op, opcode ) );
+    eventfd_write( af->eventFd, 1 );
+}
+
+
+/*
+  Handle any completed operations.  If block is set then wait for at least
+  one to finish.
+*/
+static void _afReap( AsyncFile* af, int block )
+{
+    URing* ring = &af->ring;
+    struct io_uring_cqe* cqe;
+    eventfd_t count;
+    unsigned head, tail;
+
+    eventfd_read( af->eventFd, &count );    // Reset, as the fd is non-blocking.
+    if( ! ring->fd )
+    {
+#ifdef CONFIG_THREAD
+        AsyncWorker* w = &af->worker;
+        AsyncJob done[ AFILE_ENTRIES ];
+        int i, n;
+
+        if( ! w->running )
+            return;
+        mutexLock( w->mutex );
+        if( block )
+        {
+            while( ! w->doneCount )
+                condWaitF( w->doneCond, w->mutex );
+        }
+        n = w->doneCount;
+        memcpy( done, w->done, n * sizeof(AsyncJob) );
+        w->doneCount = 0;
+        mutexUnlock( w->mutex );
+
+        for( i = 0; i < n; ++i )
+            _afComplete( af, done[i].op, done[i].arg );
+#endif
+        return;
+    }
+
+    if( block )
+        syscall( __NR_io_uring_enter, ring->fd, 0, 1, IORING_ENTER_GETEVENTS,
+                 NULL, 0 );
+
+    head = *ring->cqHead;
+    tail = __atomic_load_n( ring->cqTail, __ATOMIC_ACQUIRE );
+    while( head != tail )
+    {
+        cqe = ring->cqes + (head & *ring->cqMask);
+        _afComplete( af, (AsyncOp*) (uintptr_t) cqe->user_data, cqe->res );
+        ++head;
+    }
+    __atomic_store_n( ring->cqHead, head, __ATOMIC_RELEASE );
+}
+
+
+static void _afReadAhead( AsyncFile* af )
+{
+    af->rd.offset = af->pos;
+    af->readUsed = 0;
+    _afSubmit( af, &af->rd, IORING_OP_READV );
+}
+
+
+/*
+  Wait for any read-ahead and discard its data.
+*/
+static void _afDropRead( AsyncFile* af )
+{
+    while( af->rd.state == AF_BUSY )
+        _afReap( af, 1 );
+    if( af->rd.state == AF_DONE )
+    {
+        if( af->rd.result > 0 )
+            af->pos = af->rd.offset + af->readUsed;
+        af->rd.state = AF_IDLE;
+    }
+}
+
+
+static int afile_open( UThread* ut, int fd, int opt, UCell* res )
+{
+    UBuffer* port;
+    AsyncFile* af;
+
+    af = (AsyncFile*) memAlloc( sizeof(AsyncFile) );
+    memset( af, 0, sizeof(AsyncFile) );
+    af->fd = fd;
+    af->readable = ! (opt & UR_PORT_WRITE) || (opt & UR_PORT_READ);
+    af->eventFd = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+    if( af->eventFd < 0 )
+    {
+        memFree( af );
+        close( fd );
+        return ur_error( ut, UR_ERR_ACCESS, strerror( errno ) );
+    }
+    if( af->readable )
+    {
+        af->rd.iov.iov_base = memAlloc( AFILE_READ_LEN );
+        af->rd.iov.iov_len  = AFILE_READ_LEN;
+    }
+    if( ! _uringSetup( &af->ring, af->eventFd ) )
+    {
+#ifdef CONFIG_THREAD
+        _afWorkerStart( af );
+#endif
+    }
+
+    port = boron_makePort( ut, &port_fileAsync, af, res );
+    port->FD = fd;
+    return UR_OK;
+}
+
+
+static void afile_close( UBuffer* port )
+{
+    AsyncFile* af = AFILE(port);
+    if( af )
+    {
+        while( af->rd.state == AF_BUSY || af->writesBusy )
+            _afReap( af, 1 );
+        _uringFree( &af->ring );
+#ifdef CONFIG_THREAD
+        _afWorkerStop( af );
+#endif
+        close( af->eventFd );
+        close( af->fd );
+        if( af->rd.iov.iov_base )
+            memFree( af->rd.iov.iov_base );
+        memFree( af );
+        port->ptr.v = 0;
+    }
+}
+
+
+static int _afError( UThread* ut, AsyncFile* af )
+{
+    int err = af->error;
+    af->error = 0;
+    return ur_error( ut, UR_ERR_ACCESS, "async write %s", strerror( err ) );
+}
+
+
+static int afile_read( UThread* ut, UBuffer* port, UCell* dest, int len )
+{
+    AsyncFile* af = AFILE(port);
+    UBuffer* buf;
+    int avail;
+
+    _afReap( af, 0 );
+    if( af->error )
+        return _afError( ut, af );
+
+    if( af->readable && af->rd.state == AF_IDLE )
+        _afReadAhead( af );
+    if( af->polled )
+        af->polled = 0;
+    else
+    {
+        // Without a wait the script expects read to block as with a
+        // normal file; loops such as read/lines take none to mean EOF.
+        while( af->rd.state == AF_BUSY )
+            _afReap( af, 1 );
+        if( af->error )
+            return _afError( ut, af );
+    }
+    if( af->rd.state != AF_DONE )
+    {
+        ur_setId(dest, UT_NONE);
+        return UR_OK;
+    }
+
+    if( af->rd.result <= 0 )
+    {
+        af->rd.state = AF_IDLE;
+        if( af->rd.result < 0 )
+            return ur_error( ut, UR_ERR_ACCESS, strerror( -af->rd.result ) );
+        ur_setId(dest, UT_NONE);
+        return UR_OK;
+    }
+
+    avail = af->rd.result - af->readUsed;
+    if( len > avail )
+        len = avail;
+    buf = ur_buffer( dest->series.buf );
+    memCpy( buf->ptr.b + buf->used,
+            (uint8_t*) af->rd.iov.iov_base + af->readUsed, len );
+    buf->used += len;
+
+    af->readUsed += len;
+    if( af->readUsed == af->rd.result )
+    {
+        af->pos = af->rd.offset + af->rd.result;
+        _afReadAhead( af );
+    }
+    return UR_OK;
+}
+
+
+static int afile_write( UThread* ut, UBuffer* port, const UCell* data )
+{
+    AsyncFile* af = AFILE(port);
+    AsyncOp* op;
+    uint8_t* mem;
+    const void* src;
+    int len;
+
+    _afReap( af, 0 );
+    if( af->error )
+        return _afError( ut, af );
+
+    // Copy data so the script can modify it while the write is pending.
+    if( ur_is(data, UT_BLOCK) )
+    {
+        UBlockIt bi;
+        if( ! boron_checkWriteBlock( ut, data ) )
+            return UR_THROW;
+        len = 0;
+        ur_blockIt( ut, &bi, data );
+        ur_foreach( bi )
+            len += boron_sliceMem( ut, bi.it, &src );
+        if( ! len )
+            return UR_OK;
+        mem = memAlloc( len );
+        len = 0;
+        ur_blockIt( ut, &bi, data );
+        ur_foreach( bi )
+        {
+            int n = boron_sliceMem( ut, bi.it, &src );
+            memCpy( mem + len, src, n );
+            len += n;
+        }
+    }
+    else
+    {
+        len = boron_sliceMem( ut, data, &src );
+        if( ! len )
+            return UR_OK;
+        mem = memAlloc( len );
+        memCpy( mem, src, len );
+    }
+
+    _afDropRead( af );
+    while( af->writesBusy == AFILE_WRITES )
+        _afReap( af, 1 );
+    for( op = af->wr; op->state != AF_IDLE; ++op )
+        ;
+
+    op->iov.iov_base = mem;
+    op->iov.iov_len  = len;
+    op->offset = af->pos;
+    af->pos += len;
+    ++af->writesBusy;
+    _afSubmit( af, op, IORING_OP_WRITEV );
+    return UR_OK;
+}
+
+
+static int afile_seek( UThread* ut, UBuffer* port, UCell* pos, int where )
+{
+    AsyncFile* af = AFILE(port);
+    struct stat info;
+
+    if( ! ur_is(pos, UT_INT) )
+        return ur_error( ut, UR_ERR_TYPE, "file seek expected int!" );
+
+    _afDropRead( af );
+    switch( where )
+    {
+        case UR_PORT_HEAD:
+            af->pos = ur_int(pos);
+            break;
+        case UR_PORT_TAIL:
+            if( fstat( af->fd, &info ) == -1 )
+                return ur_error( ut, UR_ERR_ACCESS, strerror( errno ) );
+            af->pos = info.st_size + ur_int(pos);
+            break;
+        case UR_PORT_SKIP:
+        default:
+            af->pos += ur_int(pos);
+            break;
+    }
+    if( af->pos < 0 )
+        af->pos = 0;
+    if( af->writesBusy )
+        af->drain = 1;      // The next write may overlap a pending one.
+    return UR_OK;
+}
+
+
+static int afile_waitFD( UBuffer* port )
+{
+    AsyncFile* af = AFILE(port);
+    if( ! af )
+        return -1;
+    _afReap( af, 0 );
+    af->polled = 1;
+    if( af->readable && af->rd.state == AF_IDLE )
+        _afReadAhead( af );
+    if( af->rd.state == AF_DONE || af->error )
+        eventfd_write( af->eventFd, 1 );
+    return af->eventFd;
+}
+
+
+UPortDevice port_fileAsync =
+{
+    file_open, afile_close, afile_read, afile_write, afile_seek,
+    afile_waitFD, AFILE_READ_LEN
+};
+#endif
+
+
 UPortDevice port_file =
 {
     file_open, file_close, file_read, file_write, file_seek,
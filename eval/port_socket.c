@@ -652,17 +652,113 @@ static int socket_accept( UThread* ut, UBuffer* port, UCell* dest, int part )
 
 
 extern int boron_sliceMem( UThread* ut, const UCell* cell, const void** ptr );
+extern int boron_checkWriteBlock( UThread* ut, const UCell* blkC );
+
+#ifndef __linux__
+#define MSG_NOSIGNAL    0
+#endif
+
+
+#ifndef _WIN32
+#define IOV_BATCH   64
+
+/*
+  Send a block of binary! & string! values on a TCP socket without joining
+  them first.
+*/
+static int socket_writeBlock( UThread* ut, UBuffer* port, const UCell* data )
+{
+    struct iovec iov[ IOV_BATCH ];
+    struct msghdr msg;
+    const void* buf;
+    UBlockIt bi;
+    ssize_t len;
+    ssize_t count;
+    int n = 0;
+
+    memset( &msg, 0, sizeof(msg) );
+    ur_blockIt( ut, &bi, data );
+    while( port->FD > -1 )
+    {
+        if( n == IOV_BATCH || (bi.it == bi.end && n) )
+        {
+            len = 0;
+            for( count = 0; count < n; ++count )
+                len += iov[ count ].iov_len;
+
+            msg.msg_iov = iov;
+            while( 1 )
+            {
+                msg.msg_iovlen = n;
+                count = sendmsg( port->FD, &msg, MSG_NOSIGNAL );
+                if( count == -1 )
+                {
+                    ur_error( ut, UR_ERR_ACCESS, "send %s", SOCKET_ERR );
+
+                    // An error occured; the socket must not be used again.
+                    closesocket( port->FD );
+                    port->FD = -1;
+                    return UR_THROW;
+                }
+                if( count == len )
+                    break;
+
+                // Partial send; skip what was done and try again.
+                len -= count;
+                while( (size_t) count >= msg.msg_iov->iov_len )
+                {
+                    count -= msg.msg_iov->iov_len;
+                    ++msg.msg_iov;
+                    --n;
+                }
+                msg.msg_iov->iov_base = (char*) msg.msg_iov->iov_base + count;
+                msg.msg_iov->iov_len -= count;
+            }
+            n = 0;
+        }
+        if( bi.it == bi.end )
+            break;
+
+        len = boron_sliceMem( ut, bi.it, &buf );
+        if( len )
+        {
+            iov[ n ].iov_base = (void*) buf;
+            iov[ n ].iov_len  = len;
+            ++n;
+        }
+        ++bi.it;
+    }
+    return UR_OK;
+}
+#endif
 
 
 static int socket_write( UThread* ut, UBuffer* port, const UCell* data )
 {
     const void* buf;
     int n;
-    ssize_t len = boron_sliceMem( ut, data, &buf );
+    ssize_t len;
 
-#ifndef __linux__
-#define MSG_NOSIGNAL    0
+    if( ur_is(data, UT_BLOCK) )
+    {
+        UBlockIt bi;
+        if( ! boron_checkWriteBlock( ut, data ) )
+            return UR_THROW;
+#ifndef _WIN32
+        if( port->TCP )
+            return socket_writeBlock( ut, port, data );
 #endif
+        // Each value is sent separately (as its own UDP datagram).
+        ur_blockIt( ut, &bi, data );
+        ur_foreach( bi )
+        {
+            if( ! socket_write( ut, port, bi.it ) )
+                return UR_THROW;
+        }
+        return UR_OK;
+    }
+
+    len = boron_sliceMem( ut, data, &buf );
 
     if( port->FD > -1 && len )
     {
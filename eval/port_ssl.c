@@ -273,6 +273,7 @@ retry:
 
 
 extern int boron_sliceMem( UThread* ut, const UCell* cell, const void** ptr );
+extern int boron_checkWriteBlock( UThread* ut, const UCell* blkC );
 
 
 static int ssl_write( UThread* ut, UBuffer* port, const UCell* data )
@@ -282,6 +283,20 @@ static int ssl_write( UThread* ut, UBuffer* port, const UCell* data )
     int len;
     int n;
 
+    if( ur_is(data, UT_BLOCK) )
+    {
+        UBlockIt bi;
+        if( ! boron_checkWriteBlock( ut, data ) )
+            return UR_THROW;
+        ur_blockIt( ut, &bi, data );
+        ur_foreach( bi )
+        {
+            if( ! ssl_write( ut, port, bi.it ) )
+                return UR_THROW;
+        }
+        return UR_OK;
+    }
+
     len = boron_sliceMem( ut, data, &buf );
 
     if( port->FD > -1 && len )
@@ -63,9 +63,18 @@ CFUNC_PUB(cfunc_random)
 
     if( ur_isSeriesType(type) )
     {
+        const UBuffer* buf = ur_bufferSer(a1);
         int len = boron_seriesEnd( ut, a1 );
         *res = *a1;
-        if( len > 0 )
+        if( UTF8_SERIES(buf) )
+        {
+            len = ur_strCharIndex( ut, buf, len ) -
+                  ur_strCharIndex( ut, buf, a1->series.it );
+            if( len > 0 )
+                res->series.it = boron_utf8Step( ut, buf, a1->series.it,
+                                                 genrand_int32() % len );
+        }
+        else if( len > 0 )
             res->series.it += genrand_int32() % (len - a1->series.it);
         return UR_OK;
     }
@@ -24,6 +24,8 @@
 #define OPT_SORT_CASE   0x01
 #define OPT_SORT_GROUP  0x02
 #define OPT_SORT_FIELD  0x04
+#define OPT_SORT_STABLE 0x08
+#define OPT_SORT_KEY    0x10
 
 
 struct CompareField
@@ -196,6 +198,79 @@ static int _compareField( struct CompareField* cf,
 }
 
 
+/*
+  Evaluate the key function once for each group of elements and store the
+  results in a new block.
+
+  The element is passed to the function through a get-word! bound to a
+  temporary block so that it is not evaluated as an argument.
+
+  \param blkC   Block to sort.
+  \param funC   Key function (func! or cfunc!).  This must be held.
+  \param group  Number of elements per group.  The key is taken from the
+                first element in each group.
+  \param count  Number of groups.
+  \param bufN   Indices of the temporary call & keys blocks.
+  \param hold   Holds for bufN.  If UR_OK is returned then the caller must
+                release these.
+
+  \return UR_OK or UR_THROW.
+*/
+static UStatus _sortKeys( UThread* ut, const UCell* blkC, const UCell* funC,
+                          int group, int count, UIndex* bufN, UIndex* hold )
+{
+    UBlockIt bi;
+    UBuffer* buf;
+    UCell* call;
+    UCell* key;
+    int i;
+
+    ur_genBuffers( ut, 2, bufN );           // gc!
+    ur_blkInit( ur_buffer( bufN[1] ), UT_BLOCK, count );
+    hold[1] = ur_hold( bufN[1] );
+    buf = ur_buffer( bufN[0] );
+    ur_blkInit( buf, UT_BLOCK, 3 );
+    hold[0] = ur_hold( bufN[0] );
+
+    call = buf->ptr.cell;
+    buf->used = 3;
+    ur_setId(call, UT_NONE);
+    call[1] = *funC;
+    ur_setId(call + 2, UT_GETWORD);
+    ur_setBinding(call + 2, UR_BIND_THREAD);
+    call[2].word.ctx   = bufN[0];
+    call[2].word.index = 0;
+    call[2].word.atom  = UR_ATOM_X;
+
+    for( i = 0; i < count; ++i )
+    {
+        // The source block may have been modified by the key function.
+        ur_blockIt( ut, &bi, blkC );
+        if( bi.it + i * group >= bi.end )
+        {
+            ur_error( ut, UR_ERR_SCRIPT,
+                      "sort series modified by key function" );
+            goto fail;
+        }
+        *call = bi.it[ i * group ];
+
+        buf = ur_buffer( bufN[1] );
+        key = buf->ptr.cell + i;
+        ur_setId(key, UT_NONE);
+        buf->used = i + 1;
+
+        if( ! boron_eval1( ut, call + 1, call + 3, key ) )
+            goto fail;
+    }
+    return UR_OK;
+
+fail:
+    ur_release( hold[0] );
+    ur_release( hold[1] );
+    return UR_THROW;
+}
+
+
 /*-cf-
     sort
         set         series
@@ -204,8 +279,16 @@ static int _compareField( struct CompareField* cf,
             size    int!
         /field      Sort on specified context words or block indices.
             which   block!
+        /stable     Keep the original order of elements which compare equal.
+        /key        Sort by the result of a function called once per element.
+            func    func!/cfunc!
     return: New series with sorted elements.
     group: series
+
+    When /key is used the function is called with each element (or the
+    first element of each group) and the returned keys are compared rather
+    than the elements themselves.  The /field option is then applied to
+    the keys.
 */
 CFUNC(cfunc_sort)
 {
@@ -219,6 +302,8 @@ CFUNC(cfunc_sort)
         UBuffer* blk;
         uint32_t* ip;
         uint32_t* iend;
+        UIndex keyN[2];
+        UIndex hold[2];
         int group;
         int len;
         int indexLen;
@@ -241,10 +326,7 @@ CFUNC(cfunc_sort)
             indexLen = len;
         }
 
-        blk = ur_makeBlockCell( ut, type, len, res );   // gc!
-
-        qs.index    = ((uint32_t*) (blk->ptr.cell + len)) - indexLen;
-        qs.data     = (uint8_t*) bi.it;
+        ur_makeBlockCell( ut, type, len, res );         // gc!
         qs.elemSize = sizeof(UCell);
 
         if( fld.opt & OPT_SORT_FIELD )
@@ -262,9 +344,44 @@ CFUNC(cfunc_sort)
                                 ur_compareCase : ur_compare);
         }
 
-        ip = qs.index;
-        iend = ip + quickSortIndex( &qs, 0, len, group );
+        if( fld.opt & OPT_SORT_KEY )
+        {
+            if( ! _sortKeys( ut, a1, CFUNC_OPT_ARG(5), group, indexLen,
+                             keyN, hold ) )
+                return UR_THROW;
+
+            // Sort the keys then gather the groups they were made from.
+            blk = ur_buffer( res->series.buf );
+            ip = qs.index = ((uint32_t*) (blk->ptr.cell + len)) - indexLen;
+            qs.data = (uint8_t*) ur_buffer( keyN[1] )->ptr.cell;
+            if( fld.opt & OPT_SORT_STABLE )
+                iend = ip + mergeSortIndex( &qs, 0, indexLen, 1,
+                                            ip - indexLen );
+            else
+                iend = ip + quickSortIndex( &qs, 0, indexLen, 1 );
+            ur_release( hold[0] );
+            ur_release( hold[1] );
+
+            for( ; ip != iend; ++ip )
+                *ip *= group;
+            ip = qs.index;
+        }
+        else
+        {
+            blk = ur_buffer( res->series.buf );
+            ip = qs.index = ((uint32_t*) (blk->ptr.cell + len)) - indexLen;
+            qs.data = (uint8_t*) bi.it;
+            if( fld.opt & OPT_SORT_STABLE )
+                iend = ip + mergeSortIndex( &qs, 0, len, group,
+                                            ip - indexLen );
+            else
+                iend = ip + quickSortIndex( &qs, 0, len, group );
+        }
 
+        ur_blockIt( ut, &bi, a1 );
+        if( (bi.end - bi.it) < len )
+            return ur_error( ut, UR_ERR_SCRIPT,
+                             "sort series modified by key function" );
         len = qs.elemSize * group;
         while( ip != iend )
         {
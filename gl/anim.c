@@ -976,6 +976,7 @@ static UStatus anim_parseSpec( UThread* ut, AnimInit* init, const UCell* blkC,
     sp.bp.report = _animRuleHandler;
     sp.bp.rflag  = 0;
     ur_blockIt( ut, (UBlockIt*) &sp.bp.it, blkC );
+    sp.bp.base = sp.bp.it;
 
     // Pre-parse pass to determine anim_alloc ftype.
     for( it = sp.bp.it; it != sp.bp.end; ++it )
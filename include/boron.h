@@ -33,6 +33,7 @@ enum BoronDataType
     UT_CFUNC,
     UT_AFUNC,
     UT_PORT,
+    UT_MATCHER,
     UT_BORON_COUNT
 };
 
@@ -291,6 +291,9 @@ struct UBuffer
 
 /* Buffer flags */
 #define UR_STRING_ENC_UP    0x01
+#define UR_BLOCK_INDEXED    0x02
+#define UR_BUF_MAPPED       0x04    // Binary/string data is a mapped file.
+#define UR_STRING_INDEXED   0x08    // UTF-8 string has a character index.
 
 
 typedef struct UEnv         UEnv;
@@ -321,6 +324,9 @@ struct UThread
     const UDatatype** types;
     const UCell* (*wordCell)( UThread*, const UCell* );
     UCell* (*wordCellM)( UThread*, const UCell* );
+    void*       parseCache;         // Compiled string parse rules.
+    void*       parseBlockCache;    // Compiled block parse rules.
+    void*       strIndex;           // UTF-8 string character indexes.
 };
 
 #define UR_MAIN_CONTEXT     1
@@ -392,6 +398,17 @@ typedef struct
 UBlockItM;
 
 
+typedef struct
+{
+    UBuffer input;      // Partial input not yet tokenized.
+    UIndex  blkN;       // Block to append completed values to.
+    int32_t lines;
+    int32_t retryLen;
+    int     enc;
+}
+UTokenizer;
+
+
 typedef struct
 {
     const UBuffer* ctx;
@@ -459,6 +476,12 @@ enum UrlanFindOption
     UR_FIND_CASE
 };
 
+enum UrlanParseOption
+{
+    UR_PARSE_CASE = 1,
+    UR_PARSE_MEMO = 2
+};
+
 typedef struct
 {
     UDatatype dt;
@@ -533,6 +556,10 @@ void     ur_appendTrace( UThread*, UIndex blkN, UIndex it );
 UIndex   ur_tokenize( UThread*, const char* it, const char* end, UCell* res );
 UStatus  ur_tokenizeB( UThread*, UIndex blkN, int inputEncoding,
                        const uint8_t* start, const uint8_t* end );
+void     ur_tokenizeInit( UTokenizer*, int inputEncoding, UIndex blkN );
+void     ur_tokenizeFree( UTokenizer* );
+UStatus  ur_tokenizeFeed( UThread*, UTokenizer*,
+                          const uint8_t* it, const uint8_t* end );
 UStatus  ur_serialize( UThread*, UIndex blkN, UCell* res );
 UStatus  ur_unserialize( UThread*, const uint8_t* start, const uint8_t* end,
                          UCell* res );
@@ -579,6 +606,8 @@ void     ur_binAppendArray( UBuffer*, const USeriesIter* si );
 const char* ur_binAppendBase( UBuffer* buf, const char* it, const char* end,
                               enum UrlanBinaryEncoding enc );
 void     ur_binFree( UBuffer* );
+int      ur_binInitMapped( UBuffer*, const char* filename );
+void     ur_binUnmap( UBuffer*, int size );
 void     ur_binSlice( UThread*, UBinaryIter*, const UCell* cell );
 UStatus  ur_binSliceM( UThread*, UBinaryIterM*, const UCell* cell );
 void     ur_binToStr( UBuffer*, int encoding );
@@ -614,9 +643,19 @@ UIndex   ur_strFind( const USeriesIter*, const USeriesIter*, int matchCase );
 UIndex   ur_strFindRev( const USeriesIter*, const USeriesIter*, int matchCase );
 UIndex   ur_strMatch( const USeriesIter*, const USeriesIter*, int matchCase );
 int      ur_strChar( const UBuffer*, UIndex pos );
+UIndex   ur_strCharIndex( UThread*, const UBuffer*, UIndex pos );
+UIndex   ur_strCharPos( UThread*, const UBuffer*, UIndex index );
+UIndex   ur_matcherFind( const UBuffer* mat, const UBuffer* input,
+                         UIndex start, UIndex end, int opt,
+                         int* matchLen, int* matchPat );
+int      ur_matcherMatch( const UBuffer* mat, const UBuffer* input,
+                          UIndex start, UIndex end );
+extern UDatatype dt_matcher;
+#define  ur_isMatcher(ut,c)  ((ut)->types[ ur_type(c) ] == &dt_matcher)
 char*    ur_cstring( const UBuffer*, UBuffer* bin, UIndex start, UIndex end );
 #define  ur_strFree ur_arrFree
 #define  ur_strIsUcs2(buf)  ((buf)->form == UR_ENC_UCS2)
+#define  ur_strIsUtf8(buf)  ((buf)->form == UR_ENC_UTF8)
 
 UIndex   ur_makeBlock( UThread*, int size );
 UBuffer* ur_makeBlockCell( UThread*, int type, int size, UCell* cell );
@@ -631,6 +670,9 @@ void     ur_blkSlice( UThread*, UBlockIter*, const UCell* cell );
 UStatus  ur_blkSliceM( UThread*, UBlockIterM*, const UCell* cell );
 void     ur_blkCollectType( UThread*, const UCell* blkCell,
                             uint32_t typeMask, UBuffer* dest, int unique );
+UStatus  ur_blkIndex( UThread*, const UCell* blkC, int skip );
+UIndex   ur_blkFindIndexed( UThread*, const USeriesIter*, const UCell* val,
+                            int opt );
 #define  ur_blkFree ur_arrFree
 
 int      ur_pathResolve( UThread*, UBlockIt* pi, UCell* tmp, UCell** lastCell );
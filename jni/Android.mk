@@ -19,6 +19,7 @@ LOCAL_SRC_FILES := urlan/hashmap.c \
     urlan/string.c \
     urlan/context.c \
     urlan/gc.c \
+    urlan/matcher.c \
     urlan/serialize.c \
     urlan/tokenize.c \
     urlan/vector.c \
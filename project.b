@@ -108,6 +108,7 @@ lib-spec: [
         %string.c
         %context.c
         %gc.c
+        %matcher.c
         %serialize.c
         %tokenize.c
         %vector.c
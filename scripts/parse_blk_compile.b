@@ -75,6 +75,8 @@ foreach it [    ; Matches ParseBlockInstruction from i_parse_blk.h
     PB_ToLitWord
     PB_ThruT
     PB_ThruTs
+    PB_Call
+    PB_Word
 ][
     set it ++ enum
 ]
@@ -19,6 +19,17 @@
 
 
 #include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#define USE_SSE2
+#define LOADU(p)    _mm_loadu_si128( (const __m128i*) (p) )
+#if defined(__x86_64__) || defined(__i386__)
+#include <tmmintrin.h>
+#define USE_SSSE3
+#endif
+#endif
 
 
 /*
@@ -34,8 +45,37 @@ const T* find_ ## T( const T* it, const T* end, T val ) { \
     return 0; \
 }
 
-FIND(uint8_t)
+const uint8_t* find_uint8_t( const uint8_t* it, const uint8_t* end,
+                             uint8_t val )
+{
+    return (const uint8_t*) memchr( it, val, end - it );
+}
+
+#ifdef USE_SSE2
+const uint16_t* find_uint16_t( const uint16_t* it, const uint16_t* end,
+                               uint16_t val )
+{
+    __m128i vv = _mm_set1_epi16( val );
+    int mask;
+
+    while( end - it >= 8 )
+    {
+        mask = _mm_movemask_epi8( _mm_cmpeq_epi16( LOADU(it), vv ) );
+        if( mask )
+            return it + (__builtin_ctz( mask ) >> 1);
+        it += 8;
+    }
+    while( it != end )
+    {
+        if( *it == val )
+            return it;
+        ++it;
+    }
+    return 0;
+}
+#else
 FIND(uint16_t)
+#endif
 FIND(uint32_t)
 
 
@@ -52,8 +92,54 @@ const T* find_last_ ## T( const T* it, const T* end, T val ) { \
     return 0; \
 }
 
+#ifdef USE_SSE2
+const uint8_t* find_last_uint8_t( const uint8_t* it, const uint8_t* end,
+                                  uint8_t val )
+{
+    __m128i vv = _mm_set1_epi8( val );
+    int mask;
+
+    while( end - it >= 16 )
+    {
+        end -= 16;
+        mask = _mm_movemask_epi8( _mm_cmpeq_epi8( LOADU(end), vv ) );
+        if( mask )
+            return end + 31 - __builtin_clz( mask );
+    }
+    while( it != end )
+    {
+        --end;
+        if( *end == val )
+            return end;
+    }
+    return 0;
+}
+
+const uint16_t* find_last_uint16_t( const uint16_t* it, const uint16_t* end,
+                                    uint16_t val )
+{
+    __m128i vv = _mm_set1_epi16( val );
+    int mask;
+
+    while( end - it >= 8 )
+    {
+        end -= 8;
+        mask = _mm_movemask_epi8( _mm_cmpeq_epi16( LOADU(end), vv ) );
+        if( mask )
+            return end + ((31 - __builtin_clz( mask )) >> 1);
+    }
+    while( it != end )
+    {
+        --end;
+        if( *end == val )
+            return end;
+    }
+    return 0;
+}
+#else
 FIND_LAST(uint8_t)
 FIND_LAST(uint16_t)
+#endif
 FIND_LAST(uint32_t)
 
 
@@ -61,8 +147,8 @@ FIND_LAST(uint32_t)
   Returns first occurance of any character in cset or 0 if none are found.
   csetLen is the number of bytes in cset.
 */
-#define FIND_CHARSET(T) \
-const T* find_charset_ ## T( const T* it, const T* end, \
+#define FIND_CHARSET(N,T) \
+const T* N( const T* it, const T* end, \
     const uint8_t* cset, int csetLen ) { \
     T n; \
     int index; \
@@ -76,8 +162,123 @@ const T* find_charset_ ## T( const T* it, const T* end, \
     return 0; \
 }
 
-FIND_CHARSET(uint8_t)
-FIND_CHARSET(uint16_t)
+FIND_CHARSET(find_charset_uint16_t,uint16_t)
+
+/*
+  Build nibble lookup tables for a charset.  Byte n of the first 16 holds
+  a bit for each character with low nibble n and high nibble 0-7, and the
+  second 16 do the same for high nibbles 8-15.
+*/
+void charset_tables( const uint8_t* cset, int csetLen, uint8_t* tables )
+{
+    int n;
+
+    memset( tables, 0, 32 );
+    if( csetLen > 32 )
+        csetLen = 32;
+    for( n = 0; n < csetLen * 8; ++n )
+    {
+        if( cset[n >> 3] & (1 << (n & 7)) )
+            tables[ (n >> 7) * 16 + (n & 15) ] |= 1 << ((n >> 4) & 7);
+    }
+}
+
+
+#ifdef USE_SSSE3
+/*
+  Return mask with a bit set for each of the 16 bytes at it which are in
+  the charset.
+*/
+__attribute__((target("ssse3")))
+static inline int _charsetMask16( const uint8_t* it, __m128i vlo, __m128i vhi )
+{
+    const __m128i vbit = _mm_setr_epi8( 1, 2, 4, 8, 16, 32, 64, -128,
+                                        1, 2, 4, 8, 16, 32, 64, -128 );
+    const __m128i v15 = _mm_set1_epi8( 15 );
+    __m128i in, lo, hi, row, sel;
+
+    in  = LOADU( it );
+    lo  = _mm_and_si128( in, v15 );
+    hi  = _mm_and_si128( _mm_srli_epi16( in, 4 ), v15 );
+    sel = _mm_cmplt_epi8( hi, _mm_set1_epi8( 8 ) );
+    row = _mm_or_si128( _mm_and_si128( sel, _mm_shuffle_epi8( vlo, lo ) ),
+                        _mm_andnot_si128( sel, _mm_shuffle_epi8( vhi, lo ) ) );
+    row = _mm_and_si128( row, _mm_shuffle_epi8( vbit, hi ) );
+    return _mm_movemask_epi8( _mm_cmpeq_epi8( row, _mm_setzero_si128() ) )
+           ^ 0xffff;
+}
+
+
+static FIND_CHARSET(_scanCharset8,uint8_t)
+
+__attribute__((target("ssse3")))
+static const uint8_t* _scanCharsetSSSE3( const uint8_t* it, const uint8_t* end,
+                                         const uint8_t* cset, int csetLen )
+{
+    uint8_t tables[32];
+    __m128i vlo, vhi;
+    int mask;
+
+    charset_tables( cset, csetLen, tables );
+    vlo = LOADU( tables );
+    vhi = LOADU( tables + 16 );
+
+    while( end - it >= 16 )
+    {
+        mask = _charsetMask16( it, vlo, vhi );
+        if( mask )
+            return it + __builtin_ctz( mask );
+        it += 16;
+    }
+    return _scanCharset8( it, end, cset, csetLen );
+}
+
+const uint8_t* find_charset_uint8_t( const uint8_t* it, const uint8_t* end,
+                                     const uint8_t* cset, int csetLen )
+{
+    // Building the tables is only worthwhile for longer strings.
+    if( end - it >= 64 && __builtin_cpu_supports( "ssse3" ) )
+        return _scanCharsetSSSE3( it, end, cset, csetLen );
+    return _scanCharset8( it, end, cset, csetLen );
+}
+
+
+__attribute__((target("ssse3")))
+static uint64_t _charsetMask64SSSE3( const uint8_t* it, const uint8_t* tables )
+{
+    __m128i vlo = LOADU( tables );
+    __m128i vhi = LOADU( tables + 16 );
+    return  (uint64_t) _charsetMask16( it,      vlo, vhi ) |
+           ((uint64_t) _charsetMask16( it + 16, vlo, vhi ) << 16) |
+           ((uint64_t) _charsetMask16( it + 32, vlo, vhi ) << 32) |
+           ((uint64_t) _charsetMask16( it + 48, vlo, vhi ) << 48);
+}
+#else
+FIND_CHARSET(find_charset_uint8_t,uint8_t)
+#endif
+
+
+/*
+  Return mask with bit n set if byte n of the 64 bytes at it is in the
+  charset described by tables (see charset_tables).
+*/
+uint64_t charset_mask64( const uint8_t* it, const uint8_t* tables )
+{
+    uint64_t mask = 0;
+    int n, i;
+
+#ifdef USE_SSSE3
+    if( __builtin_cpu_supports( "ssse3" ) )
+        return _charsetMask64SSSE3( it, tables );
+#endif
+    for( i = 0; i < 64; ++i )
+    {
+        n = it[i];
+        if( tables[ (n >> 7) * 16 + (n & 15) ] & (1 << ((n >> 4) & 7)) )
+            mask |= ((uint64_t) 1) << i;
+    }
+    return mask;
+}
 
 
 /*
@@ -105,9 +306,6 @@ FIND_LAST_CHARSET(uint16_t)
 
 /*
   Returns first occurance of pattern or 0 if it is not found.
-
-  TODO: Look at using a faster search algorithm such as Boyer-Moore or grep
-        source.
 */
 #define FIND_PATTERN(N,T,P) \
 const T* find_pattern_ ## N( const T* it, const T* end, \
@@ -131,8 +329,93 @@ const T* find_pattern_ ## N( const T* it, const T* end, \
     return 0; \
 }
 
+#ifdef USE_SSE2
+/*
+  Candidate positions are found by comparing the first and last pattern
+  elements against 16 bytes of input at a time.  Only those positions are
+  then checked against the whole pattern.
+*/
+const uint8_t* find_pattern_8( const uint8_t* it, const uint8_t* end,
+                               const uint8_t* pit, const uint8_t* pend )
+{
+    const uint8_t* stop;
+    __m128i vfirst, vlast;
+    int plen = pend - pit;
+    int mask;
+
+    if( plen < 2 )
+        return find_uint8_t( it, end, *pit );
+    if( end - it < plen )
+        return 0;
+    stop = end - plen + 1;      // End of possible match starts.
+
+    vfirst = _mm_set1_epi8( pit[0] );
+    vlast  = _mm_set1_epi8( pit[plen - 1] );
+    while( stop - it >= 16 )
+    {
+        mask = _mm_movemask_epi8( _mm_and_si128(
+                    _mm_cmpeq_epi8( LOADU(it), vfirst ),
+                    _mm_cmpeq_epi8( LOADU(it + plen - 1), vlast ) ) );
+        while( mask )
+        {
+            const uint8_t* cp = it + __builtin_ctz( mask );
+            if( memcmp( cp + 1, pit + 1, plen - 2 ) == 0 )
+                return cp;
+            mask &= mask - 1;
+        }
+        it += 16;
+    }
+    for( ; it != stop; ++it )
+    {
+        if( *it == *pit && memcmp( it + 1, pit + 1, plen - 1 ) == 0 )
+            return it;
+    }
+    return 0;
+}
+
+const uint16_t* find_pattern_16( const uint16_t* it, const uint16_t* end,
+                                 const uint16_t* pit, const uint16_t* pend )
+{
+    const uint16_t* stop;
+    __m128i vfirst, vlast;
+    int plen = pend - pit;
+    int mask;
+
+    if( plen < 2 )
+        return find_uint16_t( it, end, *pit );
+    if( end - it < plen )
+        return 0;
+    stop = end - plen + 1;
+
+    vfirst = _mm_set1_epi16( pit[0] );
+    vlast  = _mm_set1_epi16( pit[plen - 1] );
+    while( stop - it >= 8 )
+    {
+        mask = _mm_movemask_epi8( _mm_and_si128(
+                    _mm_cmpeq_epi16( LOADU(it), vfirst ),
+                    _mm_cmpeq_epi16( LOADU(it + plen - 1), vlast ) ) );
+        while( mask )
+        {
+            int i = __builtin_ctz( mask );
+            const uint16_t* cp = it + (i >> 1);
+            if( memcmp( cp + 1, pit + 1, (plen - 2) * sizeof(uint16_t) ) == 0 )
+                return cp;
+            mask &= ~(3 << i);
+        }
+        it += 8;
+    }
+    for( ; it != stop; ++it )
+    {
+        if( *it == *pit &&
+            memcmp( it + 1, pit + 1, (plen - 1) * sizeof(uint16_t) ) == 0 )
+            return it;
+    }
+    return 0;
+}
+#else
 FIND_PATTERN(8,uint8_t,uint8_t)
 FIND_PATTERN(16,uint16_t,uint16_t)
+#endif
 FIND_PATTERN(8_16,uint8_t,uint16_t)
 FIND_PATTERN(16_8,uint16_t,uint8_t)
 
@@ -160,6 +443,335 @@ MATCH_PATTERN(8_16,uint8_t,uint16_t)
 MATCH_PATTERN(16_8,uint16_t,uint8_t)
 
 
+/*
+  Returns pointer to the first byte which is not ASCII or is equal to stop.
+  Pass 0x80 as stop to find only non-ASCII bytes.
+*/
+const uint8_t* span_ascii( const uint8_t* it, const uint8_t* end,
+                           uint8_t stop )
+{
+#ifdef USE_SSE2
+    __m128i vs = _mm_set1_epi8( stop );
+    __m128i va, vb;
+    uint32_t mask;
+
+    while( end - it >= 32 )
+    {
+        va = LOADU(it);
+        vb = LOADU(it + 16);
+        mask = (uint32_t) _mm_movemask_epi8( _mm_or_si128( va,
+                                  _mm_cmpeq_epi8( va, vs ) ) ) |
+               (uint32_t) _mm_movemask_epi8( _mm_or_si128( vb,
+                                  _mm_cmpeq_epi8( vb, vs ) ) ) << 16;
+        if( mask )
+            return it + __builtin_ctz( mask );
+        it += 32;
+    }
+    if( end - it >= 16 )
+    {
+        va = LOADU(it);
+        mask = _mm_movemask_epi8( _mm_or_si128( va,
+                                  _mm_cmpeq_epi8( va, vs ) ) );
+        if( mask )
+            return it + __builtin_ctz( mask );
+        it += 16;
+    }
+#endif
+    while( it != end && *it < 0x80 && *it != stop )
+        ++it;
+    return it;
+}
+
+
+/*
+  Copy ASCII bytes to 16-bit characters up to the first non-ASCII byte or
+  stop.  Returns number of characters copied.
+*/
+int copy_ascii_8_16( uint16_t* dest, const uint8_t* src, const uint8_t* end,
+                     uint8_t stop )
+{
+    const uint8_t* start = src;
+#ifdef USE_SSE2
+    __m128i vs = _mm_set1_epi8( stop );
+    __m128i zero = _mm_setzero_si128();
+    __m128i va;
+
+    while( end - src >= 16 )
+    {
+        va = LOADU(src);
+        if( _mm_movemask_epi8( _mm_or_si128( va, _mm_cmpeq_epi8( va, vs ) ) ) )
+            break;
+        _mm_storeu_si128( (__m128i*) dest,     _mm_unpacklo_epi8( va, zero ) );
+        _mm_storeu_si128( (__m128i*) (dest+8), _mm_unpackhi_epi8( va, zero ) );
+        src  += 16;
+        dest += 16;
+    }
+#endif
+    while( src != end && *src < 0x80 && *src != stop )
+        *dest++ = *src++;
+    return src - start;
+}
+
+
+/*
+  Copy 16-bit ASCII characters to bytes up to the first character above
+  0x7f.  Returns number of characters copied.
+*/
+int copy_ascii_16_8( uint8_t* dest, const uint16_t* src, const uint16_t* end )
+{
+    const uint16_t* start = src;
+#ifdef USE_SSE2
+    __m128i hi = _mm_set1_epi16( (short) 0xff80 );
+    __m128i zero = _mm_setzero_si128();
+    __m128i va, vb;
+
+    while( end - src >= 16 )
+    {
+        va = LOADU(src);
+        vb = LOADU(src + 8);
+        if( _mm_movemask_epi8( _mm_cmpeq_epi16( _mm_and_si128(
+                _mm_or_si128( va, vb ), hi ), zero ) ) != 0xffff )
+            break;
+        _mm_storeu_si128( (__m128i*) dest, _mm_packus_epi16( va, vb ) );
+        src  += 16;
+        dest += 16;
+    }
+#endif
+    while( src != end && *src < 0x80 )
+        *dest++ = (uint8_t) *src++;
+    return src - start;
+}
+
+
+#define IS_UPPER_LATIN1(c) \
+    (((unsigned int) (c) - 'A') < 26 || \
+     (((unsigned int) (c) - 0xC0) < 31 && (c) != 0xD7))
+#define IS_LOWER_LATIN1(c) \
+    (((unsigned int) (c) - 'a') < 26 || \
+     (((unsigned int) (c) - 0xE0) < 31 && (c) != 0xF7))
+#define LOWER_LATIN1(c)     (IS_UPPER_LATIN1(c) ? (c) + 32 : (c))
+
+#ifdef USE_SSE2
+/*
+  Unsigned range tests of lo <= c < lo + n for each lane.
+*/
+#define RANGE_8(v,lo,n) \
+    _mm_cmplt_epi8( _mm_add_epi8( v, _mm_set1_epi8( (char) (0x80 - (lo)) ) ), \
+                    _mm_set1_epi8( (char) ((n) - 0x80) ) )
+#define RANGE_16(v,lo,n) \
+    _mm_cmplt_epi16( _mm_add_epi16( v, _mm_set1_epi16( (short) (0x8000 - (lo)) ) ), \
+                     _mm_set1_epi16( (short) ((n) - 0x8000) ) )
+
+/*
+  Return 0x20 in each lane holding an uppercase (or lowercase) Latin-1 letter.
+*/
+static inline __m128i _caseBit8( __m128i v, int lo )
+{
+    __m128i m = _mm_or_si128( RANGE_8( v, lo - 0xC0 + 'A', 26 ),
+                    _mm_andnot_si128( _mm_cmpeq_epi8( v,
+                                            _mm_set1_epi8( (char) (lo + 23) ) ),
+                                      RANGE_8( v, lo, 31 ) ) );
+    return _mm_and_si128( m, _mm_set1_epi8( 0x20 ) );
+}
+
+static inline __m128i _caseBit16( __m128i v, int lo )
+{
+    __m128i m = _mm_or_si128( RANGE_16( v, lo - 0xC0 + 'A', 26 ),
+                    _mm_andnot_si128( _mm_cmpeq_epi16( v,
+                                            _mm_set1_epi16( lo + 23 ) ),
+                                      RANGE_16( v, lo, 31 ) ) );
+    return _mm_and_si128( m, _mm_set1_epi16( 0x20 ) );
+}
+
+#define LOWER_BIT_8(v)  _caseBit8( v, 0xC0 )
+#define UPPER_BIT_8(v)  _caseBit8( v, 0xE0 )
+#define LOWER_BIT_16(v) _caseBit16( v, 0xC0 )
+#define UPPER_BIT_16(v) _caseBit16( v, 0xE0 )
+#endif
+
+
+/*
+  Convert Latin-1 characters to lowercase.
+*/
+void lowercase_latin1( uint8_t* it, uint8_t* end )
+{
+#ifdef USE_SSE2
+    __m128i va;
+
+    while( end - it >= 16 )
+    {
+        va = LOADU(it);
+        _mm_storeu_si128( (__m128i*) it, _mm_add_epi8( va, LOWER_BIT_8(va) ) );
+        it += 16;
+    }
+#endif
+    for( ; it != end; ++it )
+    {
+        if( IS_UPPER_LATIN1(*it) )
+            *it += 32;
+    }
+}
+
+
+/*
+  Convert Latin-1 characters to uppercase.  The two lowercase letters which
+  have no uppercase form in Latin-1 (0xB5 & 0xFF) are left unchanged.
+*/
+void uppercase_latin1( uint8_t* it, uint8_t* end )
+{
+#ifdef USE_SSE2
+    __m128i va;
+
+    while( end - it >= 16 )
+    {
+        va = LOADU(it);
+        _mm_storeu_si128( (__m128i*) it, _mm_sub_epi8( va, UPPER_BIT_8(va) ) );
+        it += 16;
+    }
+#endif
+    for( ; it != end; ++it )
+    {
+        if( IS_LOWER_LATIN1(*it) )
+            *it -= 32;
+    }
+}
+
+
+/*
+  Convert 16-bit characters to lowercase up to the first one which is not
+  in the Latin-1 range.  Returns pointer to that character or end.
+*/
+uint16_t* lowercase_latin1_16( uint16_t* it, uint16_t* end )
+{
+#ifdef USE_SSE2
+    __m128i hi = _mm_set1_epi16( (short) 0xff00 );
+    __m128i zero = _mm_setzero_si128();
+    __m128i va;
+
+    while( end - it >= 8 )
+    {
+        va = LOADU(it);
+        if( _mm_movemask_epi8( _mm_cmpeq_epi16( _mm_and_si128( va, hi ),
+                                                zero ) ) != 0xffff )
+            break;
+        _mm_storeu_si128( (__m128i*) it, _mm_add_epi16( va, LOWER_BIT_16(va) ) );
+        it += 8;
+    }
+#endif
+    for( ; it != end && *it < 0x100; ++it )
+    {
+        if( IS_UPPER_LATIN1(*it) )
+            *it += 32;
+    }
+    return it;
+}
+
+
+/*
+  Convert 16-bit characters to uppercase up to the first one whose uppercase
+  form is not in the Latin-1 range.  Returns pointer to that character or end.
+*/
+uint16_t* uppercase_latin1_16( uint16_t* it, uint16_t* end )
+{
+#ifdef USE_SSE2
+    __m128i hi = _mm_set1_epi16( (short) 0xff00 );
+    __m128i micro = _mm_set1_epi16( 0xB5 );
+    __m128i yuml = _mm_set1_epi16( 0xFF );
+    __m128i zero = _mm_setzero_si128();
+    __m128i va;
+
+    while( end - it >= 8 )
+    {
+        va = LOADU(it);
+        if( _mm_movemask_epi8( _mm_or_si128(
+                _mm_cmpeq_epi16( va, micro ),
+                _mm_or_si128( _mm_cmpeq_epi16( va, yuml ),
+                    _mm_xor_si128( _mm_cmpeq_epi16( _mm_and_si128( va, hi ),
+                                                    zero ),
+                                   _mm_cmpeq_epi16( zero, zero ) ) ) ) ) )
+            break;
+        _mm_storeu_si128( (__m128i*) it, _mm_sub_epi16( va, UPPER_BIT_16(va) ) );
+        it += 8;
+    }
+#endif
+    for( ; it != end && *it < 0xFF && *it != 0xB5; ++it )
+    {
+        if( IS_LOWER_LATIN1(*it) )
+            *it -= 32;
+    }
+    return it;
+}
+
+
+/*
+  Compare characters ignoring the case of Latin-1 letters.
+  Returns pointer to the first character in it which differs from itB, or end.
+*/
+const uint8_t* mismatch_ic_8( const uint8_t* it, const uint8_t* end,
+                              const uint8_t* itB )
+{
+#ifdef USE_SSE2
+    __m128i va, vb;
+    int mask;
+
+    while( end - it >= 16 )
+    {
+        va = LOADU(it);
+        vb = LOADU(itB);
+        va = _mm_add_epi8( va, LOWER_BIT_8(va) );
+        vb = _mm_add_epi8( vb, LOWER_BIT_8(vb) );
+        mask = _mm_movemask_epi8( _mm_cmpeq_epi8( va, vb ) ) ^ 0xffff;
+        if( mask )
+            return it + __builtin_ctz( mask );
+        it  += 16;
+        itB += 16;
+    }
+#endif
+    while( it != end && LOWER_LATIN1(*it) == LOWER_LATIN1(*itB) )
+    {
+        ++it;
+        ++itB;
+    }
+    return it;
+}
+
+
+/*
+  Compare 16-bit characters ignoring the case of Latin-1 letters.
+  Returns pointer to the first character in it which differs from itB, or end.
+
+  Characters outside Latin-1 are compared exactly, so the caller must check
+  the case of the returned character itself.
+*/
+const uint16_t* mismatch_ic_16( const uint16_t* it, const uint16_t* end,
+                                const uint16_t* itB )
+{
+#ifdef USE_SSE2
+    __m128i va, vb;
+    int mask;
+
+    while( end - it >= 8 )
+    {
+        va = LOADU(it);
+        vb = LOADU(itB);
+        va = _mm_add_epi16( va, LOWER_BIT_16(va) );
+        vb = _mm_add_epi16( vb, LOWER_BIT_16(vb) );
+        mask = _mm_movemask_epi8( _mm_cmpeq_epi16( va, vb ) ) ^ 0xffff;
+        if( mask )
+            return it + (__builtin_ctz( mask ) >> 1);
+        it  += 8;
+        itB += 8;
+    }
+#endif
+    while( it != end && LOWER_LATIN1(*it) == LOWER_LATIN1(*itB) )
+    {
+        ++it;
+        ++itB;
+    }
+    return it;
+}
+
+
 #define REVERSE(T) \
 void reverse_ ## T( T* it, T* end ) { \
     T tmp; \
@@ -25,6 +25,9 @@ const uint8_t* find_charset_uint8_t( const uint8_t* it, const uint8_t* end,
 const uint16_t* find_charset_uint16_t( const uint16_t* it, const uint16_t* end,
                                        const uint8_t* cset, int csetLen );
 
+void charset_tables( const uint8_t* cset, int csetLen, uint8_t* tables );
+uint64_t charset_mask64( const uint8_t* it, const uint8_t* tables );
+
 const uint8_t* find_last_charset_uint8_t( const uint8_t* it, const uint8_t* end,
                                           const uint8_t* cset, int csetLen );
 const uint16_t* find_last_charset_uint16_t( const uint16_t* it,
@@ -49,6 +52,21 @@ const uint16_t* match_pattern_8_16( const uint8_t* it, const uint8_t* end,
 const uint8_t* match_pattern_16_8( const uint16_t* it, const uint16_t* end,
                                    const uint8_t* pit, const uint8_t* pend );
 
+const uint8_t* span_ascii( const uint8_t* it, const uint8_t* end,
+                           uint8_t stop );
+int copy_ascii_8_16( uint16_t* dest, const uint8_t* src, const uint8_t* end,
+                     uint8_t stop );
+int copy_ascii_16_8( uint8_t* dest, const uint16_t* src, const uint16_t* end );
+
+void lowercase_latin1( uint8_t* it, uint8_t* end );
+void uppercase_latin1( uint8_t* it, uint8_t* end );
+uint16_t* lowercase_latin1_16( uint16_t* it, uint16_t* end );
+uint16_t* uppercase_latin1_16( uint16_t* it, uint16_t* end );
+const uint8_t* mismatch_ic_8( const uint8_t* it, const uint8_t* end,
+                              const uint8_t* itB );
+const uint16_t* mismatch_ic_16( const uint16_t* it, const uint16_t* end,
+                                const uint16_t* itB );
+
 void reverse_uint8_t( uint8_t* it, uint8_t* end );
 void reverse_uint16_t( uint16_t* it, uint16_t* end );
 void reverse_uint32_t( uint32_t* it, uint32_t* end );
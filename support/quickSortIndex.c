@@ -2,6 +2,7 @@
 
 
 //#include <stdio.h>
+#include <string.h>
 #include "quickSortIndex.h"
 
 
@@ -146,4 +147,91 @@ int quickSortIndex( const QuickSortIndex* qs, uint32_t begin, uint32_t end,
 }
 
 
+/*
+  Stable merge sort of index range [l, r).  The tmp array must be as large
+  as the index.
+*/
+static void msortIndex( const QuickSortIndex* qs, uint32_t* tmp,
+                        uint32_t l, uint32_t r )
+{
+    uint8_t* pivot;
+    uint8_t* data = qs->data;
+    uint32_t* index = qs->index;
+    uint32_t i, j, k;
+    uint32_t m;
+    uint32_t val;
+
+    if( (r - l) <= INSERT_SIZE )
+    {
+        // Insertion sorting on small series.  Equal elements are not moved
+        // past each other to keep the sort stable.
+        for( i = l + 1; i < r; ++i )
+        {
+            val = index[i];
+            pivot = data + (val * qs->elemSize);
+            for( j = i; j > l; --j )
+            {
+                if( ! isGT( VALUE(j - 1), pivot ) )
+                    break;
+                index[j] = index[j - 1];
+            }
+            index[j] = val;
+        }
+        return;
+    }
+
+    m = (l + r) / 2;
+    msortIndex( qs, tmp, l, m );
+    msortIndex( qs, tmp, m, r );
+
+    // Halves are already in order.
+    if( ! isGT( VALUE(m - 1), VALUE(m) ) )
+        return;
+
+    memcpy( tmp + l, index + l, (m - l) * sizeof(uint32_t) );
+
+    i = l;
+    j = m;
+    k = l;
+    while( i < m && j < r )
+    {
+        if( isGT( data + (tmp[i] * qs->elemSize), VALUE(j) ) )
+            index[k++] = index[j++];
+        else
+            index[k++] = tmp[i++];
+    }
+    while( i < m )
+        index[k++] = tmp[i++];
+}
+
+
+/*
+  Stable sort of an index of elements.
+
+  This is the same as quickSortIndex() but elements which compare equal
+  keep their original order.  The number of comparisons is also bounded
+  by O(n log n), which matters when the compare callback is expensive.
+
+  \param begin   First index.
+  \param end     Ending index (not included in the sort).
+  \param stride  Index increment.
+  \param tmp     Scratch array the same size as qs->index.
+
+  \return  Number of indicies set and sorted in qs->index.
+*/
+int mergeSortIndex( const QuickSortIndex* qs, uint32_t begin, uint32_t end,
+                    uint32_t stride, uint32_t* tmp )
+{
+    uint32_t icount;
+    uint32_t* ip = qs->index;
+
+    icount = (end - begin) / stride;
+    for( end = begin + icount * stride; begin < end; begin += stride )
+        *ip++ = begin;
+    if( icount > 1 )
+        msortIndex( qs, tmp, 0, icount );
+    return icount;
+}
+
+
 /*EOF*/
@@ -20,6 +20,9 @@ struct QuickSortIndex
 
 extern int quickSortIndex( const QuickSortIndex*,
                            uint32_t first, uint32_t last, uint32_t stride );
+extern int mergeSortIndex( const QuickSortIndex*,
+                           uint32_t first, uint32_t last, uint32_t stride,
+                           uint32_t* tmp );
 
 
 #endif
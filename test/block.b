@@ -102,3 +102,41 @@ probe a
 print "---- reverse"
 probe reverse [1 2 3 4]
 probe reverse/part [1 2 3 4 5] 3
+
+
+print "---- index-series"
+b: index-series [a 1 b 2 "Foo" 3 c 4 5.0 x 2 y int! z]
+probe find b 'c
+probe find b "foo"
+probe find/case b "foo"
+probe find b 5
+probe find b int!
+probe find/last b 2
+probe select b 'b
+probe find skip b 3 'b
+append b [q 9]
+probe find b 'q
+r: index-series/skip [a b b a c a] 2
+probe find r 'b
+probe find/last r 'a
+probe select r 'c
+probe select r 'x
+e: index-series ["a" "b" "target"]
+s: last e
+clear s
+append s "changed"
+probe reduce [find e "changed" find e "target"]
+
+
+print "---- tokenize"
+w: "abcdefghijklmnopqrstuvwxyz-0123456789-ABCDEFGHIJKL"
+s: join w w
+b: to-block rejoin [w ": " w { "} s {^^"} s {^^/" ^{} s "^^}}"]
+print size? b
+probe eq? w to-text first b
+probe eq? w to-text second b
+probe skip b 2
+probe to-block "a ; comment"
+probe to-block "a %"
+probe to-block "+"
+probe to-block "a /"
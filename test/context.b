@@ -73,3 +73,26 @@ probe try [
     do bind/secure [low: 2 high: read %/tmp/config] sc
 ]
 probe sc
+
+
+print "---- large context"
+spec: make block! 200
+loop [i 1 100] [append append spec to-set-word join "w" i i]
+lc: make context! spec
+print [lc/w1 lc/w64 lc/w100 in lc 'w0]
+lc2: make lc [w101: 'new w50: 'changed]
+print [lc2/w50 lc2/w101 lc2/w100 in lc 'w101]
+lc3: first unserialize serialize reduce [lc2]
+print [lc3/w1 lc3/w50 lc3/w101]
+
+
+print "---- shared shape"
+proto: context [a: 1 b: 2]
+i1: make proto [a: 10]
+i2: make proto [c: 3]
+i3: copy i1
+i3/b: 30
+print [proto/a proto/b i1/a i1/b i2/a i2/c i3/a i3/b]
+print [in proto 'c in i1 'c in i3 'c]
+set in i3 'a 'changed
+print [i1/a i3/a words-of i2]
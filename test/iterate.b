@@ -14,6 +14,8 @@ foreach [a b] "four" [
 foreach [a b] "hello" [
 	print [a b]
 ]
+foreach c "h^(20AC)y" [prin [c ' ']]
+print ""
 
 
 print "---- block foreach"
@@ -23,6 +25,8 @@ foreach [a b] [four words to iterate] [
 foreach [a b] [five words to iterate extra] [
 	print [a b]
 ]
+foreach w [one two three] [do join "ctx-grow-" [w ": 1"]  prin [w ' ']]
+print ""
 
 
 print "---- block forall"
@@ -58,6 +62,11 @@ probe map x {a-b-c;d-e} [
         x
     ]
 ]
+v: #[1 2 3 4]
+probe map n v [mul n 10]
+probe map x skip [1 2 3 4] 2 [to-string x]
+d: [1 2 3]
+probe map x d [if eq? x 1 [clear skip d 2] negate x]
 
 
 print "---- remove-each"
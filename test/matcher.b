@@ -0,0 +1,38 @@
+m: make matcher! ["he" "she" "his" "hers"]
+
+print "---- print"
+probe m
+print m
+probe matcher? m
+
+print "---- find"
+probe find "ushers" m
+probe find/pattern "ushers" m
+probe m/2
+probe find/last "ushers his" m
+probe find/pattern/last "ushers his" m
+probe find "xyz" m
+probe find/pattern "xyz" m
+probe try [find/pattern "xyz" "y"]
+probe find #{7573686973} m
+probe find {Rабочий she} m
+
+print "---- case"
+c: make matcher! [case "Foo" "foo"]
+probe find/pattern "xFOO Foo" c
+probe find "HIS" m
+
+print "---- parse"
+probe parse "hishe" [some m]
+probe parse "she sells his" [thru m " sells " m]
+a: none
+probe parse "abc hers" [to m a: "hers"]
+probe a
+
+print "---- replace"
+probe replace/all "he said she and his" m "X"
+probe replace "hers" m "X"
+
+print "---- errors"
+probe try [make matcher! ["a" ""]]
+probe try [make matcher! [1]]
@@ -32,6 +32,39 @@ print parse [person ["Janet" 38] "-x" 20.2 ] [some[
   | "-x" set x skip 
 ]]
 probe reduce [name age x]
+print parse [a [b]] ['a into ['b] into [skip]]
+
+
+print "---- block rules"
+count: 0
+print parse [a 1 "s" 2.5 b] [some [[int! | double!] (++ count) | skip]]
+print count
+print parse [x 1 2 y] ['x any int! 'y]
+print parse [x 'x] ['x 'x]
+print parse [1 2 3] [some int!]
+item: [word! | string!]
+list: copy []
+print parse [a "b" 3 c] [some [set v item (append list v) | int!]]
+probe list
+blk: [1 2 3 end]
+print parse blk [some [n: int! (if eq? 2 first n [remove n])] 'end]
+probe blk
+x: none
+print [parse [1] [set x word! | int!] x parse [a] ['a set x int!] x]
+r: copy [some int!]
+print parse [1 2] r
+poke r 2 'word!
+print [parse [1 2] r parse [a b] r]
+inner: copy [int! 'x]
+r: reduce ['some inner]
+print parse [1 x 2 x] r
+poke inner 2 to-lit-word 'y
+print [parse [1 x] r parse [1 y] r]
+ts: copy [int! | string!]
+r: reduce ['some ts]
+print parse [1 "a"] r
+poke ts 3 'word!
+print [parse [1 "a"] r parse [1 a] r]
 
 
 print "---- sanity checks"
@@ -39,6 +72,11 @@ ogs: "frog clog dog smog bog woggle toggle"
 print parse copy ogs [
     some [a: "smog" (clear a) | skip]
 ]
+x: none
+print parse [a b] [skip set x word!]
+probe x
+print [parse [a b] [skip thru 'b] parse [a b] [skip 1 skip]
+       parse [a b] [skip 1 word!]]
 
 
 print "---- string case"
@@ -58,3 +96,103 @@ parse str [thru "стол" some white a: to ',' :a]
 probe a
 parse str [to "Plasma" b: to #{2C20} :b]
 probe b
+
+
+print "---- dynamic rules"
+digit: charset "0123456789"
+word-rule: ["a"]
+count: 0
+print parse "aabab" [some [word-rule (++ count append word-rule [| "b"])]]
+print count
+rs: reduce [["a"] ["b"]]
+w: none
+print parse "abab" [some [(w: first rs rs: reverse rs) w]]
+num-rule: func [s /local r] [r: [some digit] parse s [r "x"]]
+print [num-rule "123x" num-rule "x"]
+umlaut: charset "ÄÖÜäöü"
+probe parse "Äöx €" [a: umlaut umlaut :a thru "€"]
+probe a
+
+
+print "---- parse memo"
+e: ["(" e ")" "x" | "(" e ")" | "a"]
+s: "((((a))))"
+print [parse s [e] parse/memo s [e]]
+be: ['p into [be] 'x | 'p into [be] | 'a]
+b: [a] loop 4 [b: reduce ['p b]]
+print [parse b [be] parse/memo b [be]]
+n: 0
+ab: ["a" (++ n) "b"]
+print [parse/memo "aab" [ab | ab | "a" ab] n]
+n: 0
+str: copy "axb"
+rm: ["x" (++ n remove skip str 2)]
+print [parse/memo str ["a" [rm "c" | rm]] n str]
+
+
+print "---- regular rules"
+alnum: charset "0123456789abcdefghijklmnopqrstuvwxyz"
+tok: [some [alnum | "-"]]
+toks: copy []
+parse "log-01 GET /x-2" [some [a: tok :a (append toks a) | skip]]
+probe toks
+print [parse "ab" ["a" | "ab"] parse "ab" ["ab" | "a"] parse "ab" [["a" | "ab"] "b"]]
+print [parse "aaa" [any "a" "a"] parse "aab" [2 "a" opt "a" 'b']]
+print [parse "ABc" ["abc"] parse/case "ABc" ["abc"] parse "ABc" ['A' 'B' 'c']]
+vowel: charset "ae"
+n: 0
+vr: [vowel]
+parse "aeiou" [some [vr (++ n) | 'i' (vowel: charset "iou")]]
+print n
+w: copy "ab"
+r: [w "!"]
+print parse "ab!" r
+change next w "x"
+print [parse "ax!" r parse "ab!" r]
+r: ["ab" some vowel]
+print parse "abio" r
+change r "cd"
+poke r 3 'alnum
+print [parse "cd12" r parse "abio" r]
+
+
+print "---- slice"
+kv: copy []
+print parse "key=value;x=12;" [some [
+    slice k to '=' '=' slice v to ';' ';' (append kv reduce [k v])
+]]
+probe kv
+print parse [a b 1 2 "x"] [slice w some word! slice i [some int!] slice s string!]
+probe reduce [w i s]
+print parse [a b 1] [some [slice w word! | break] int!]
+probe w
+print parse/binary #{01020304} [u8 slice b 2 u8]
+probe b
+print parse/binary #{0102} [u8 copy c 2]
+context [
+    slice: ["ab"]
+    print parse "ab" [slice]
+    slice: ['a 'b]
+    print parse [a b] [slice]
+    slice: [u8 u8]
+    print parse/binary #{0102} [slice]
+]
+print catch [parse "ab" ["ab" slice x]]
+print catch [parse [a] ['a slice x]]
+print catch [parse/binary #{01} [u8 slice x]]
+
+
+print "---- binary records"
+d: #{0001 FFFFFFFE 3F800000  0102 00000304 C0000000  AA}
+print parse/binary d [big-endian records r 2 [u16 i32 f32] u8]
+probe r
+print parse/binary d [records r any [big-endian 4 4 i8 skip u16 u16 u16]]
+probe r
+r: none
+print parse/binary #{0102030405} [records r 3 [little-endian u16]]
+probe r
+print parse/binary #{0102030405} [records r 2 [little-endian u16] u8]
+probe r
+print parse/binary #{0001 0002 0003 0004} [records r 2 [u16 big-endian u16]]
+probe r
+print catch [parse/binary d [records r 1 [u8 u16 2 skip skip 6]]]
@@ -15,3 +15,97 @@ while [read/part/into fp 20 str] [
 ]
 probe len
 close fp
+
+
+print "---- write block"
+f: %write-block.tmp
+write f reduce ["caf^(e9) " #{414243} "^(20ac)"]
+probe read f
+fp: open/new f
+write fp ["ab" #{0A} "cd"]
+probe try [write fp ["ef" 1]]
+close fp
+probe read/text f
+probe try [write f [1 2]]
+delete f
+
+
+print "---- load stream"
+f: %load-stream.tmp
+write f "a 1 [b^/c] ^"str^"^/{multi^/line} 2.5"
+fp: open f
+probe load/stream fp func [blk] [probe blk]
+close fp
+buf: make string! 200000
+loop 20000 [append buf "word 12 [x y] ^/"]
+write f buf
+fp: open f
+calls: count: 0
+load/stream fp func [blk /extern calls count] [
+    ++ calls
+    count: add count size? blk
+]
+close fp
+probe count
+probe gt? calls 1
+count: 0
+load/stream f func [blk /extern count] [count: add count size? blk]
+probe count
+probe error? try [load/stream "a b" :probe]
+delete %load-stream.tmp
+
+
+print "---- read mmap"
+f: %data-104
+m: read/mmap f
+probe eq? m read f
+probe find read/mmap/text f "Vidit"
+change m #{7468}
+append m "!"
+probe to-string skip m 98
+probe to-string slice m 4
+probe to-string slice read f 4
+
+
+print "---- read lines"
+lines: copy []
+probe read/lines %data-104 func [blk] [
+    foreach l blk [append lines copy l]
+    size? blk
+]
+probe lines
+fp: open %data-104
+read/part fp 10
+probe read/lines fp func [blk] [first blk]
+close fp
+
+
+print "---- open nowait"
+f: open/nowait %data-104
+acc: make binary! 0
+while [wait [f 1.0]  r: read/part f 40] [append acc r]
+close f
+probe eq? acc read %data-104
+o: open/nowait/new %async.tmp
+loop 3 [write o "abc"]
+head o  skip o 1
+write o #{58}
+close o
+probe read/text %async.tmp
+delete %async.tmp
+
+
+print "---- transfer"
+s: open %data-104
+d: open/new %transfer.tmp
+read/part s 10
+probe transfer/part s d 20
+probe transfer s d
+close s
+close d
+probe read/text %transfer.tmp
+delete %transfer.tmp
+f: open/nowait %data-104
+probe read/part f 11
+probe read/lines f func [blk] [first blk]
+close f
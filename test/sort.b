@@ -28,6 +28,20 @@ blkb: [
 probe sort/field copy blkb [3 1]
 probe sort/field copy blkb [3 1 /desc]
 
+
+print "---- sort stable"
+probe sort/stable [3 1 2 1 5 4 0]
+probe sort/stable/group [2 a 1 b 2 c 1 d 0 e] 2
+probe sort/stable/field copy blkb [3]
+
+
+print "---- sort key"
+probe sort/key [-3 1 -2 4] func [x] [abs x]
+probe sort/key/stable ["bb" "a" "cc" "d" "eee"] :size?
+probe sort/key/group [x 3 y 1 z 2] func [w] [select [x 9 y 8 z 7] w] 2
+probe sort/key/field copy ctxb func [c] [reduce [c/part c/size]] [1 2 /desc]
+probe sort/key [] :abs
+
 /*
 strb: [
     "a-8"
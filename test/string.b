@@ -52,6 +52,17 @@ probe b
 
 print "---- compare"
 probe equal? "str" "STR"
+probe equal? "Latin-1 text: ÀÉÎÕÜ, with accents" "latin-1 TEXT: àéîõü, WITH accents"
+probe equal? "^(391)^(392) and a longer ASCII tail" "^(3b1)^(3b2) AND A LONGER ascii TAIL"
+probe lt? "Sixteen or more letters B" "sixteen or more letters a"
+probe sort ["Élan" "elan" "Zeta" "alpha" "Beta" "èlan"]
+
+
+print "---- case"
+probe lowercase "Mixed Case ASCII & Latin-1 ÀÉÎÕÜ ×÷ ß"
+probe uppercase "Mixed Case ASCII & Latin-1 àéîõü ×÷ ß µÿ"
+probe lowercase "^(100)^(101)^(130) Ünicode ^(391)^(392)^(393) TEXT"
+probe uppercase "^(100)^(101) ünicode ^(3b1)^(3b2)^(3b3) text µÿ"
 
 
 print "---- do"
@@ -126,6 +137,19 @@ probe find sq "re"
 probe find/last sq "re"
 probe find/last/case sq "RE"
 
+long: "The quick brown fox jumps over the lazy dog; the quick brown end."
+probe index? find/case long "brown end"
+probe index? find/case long 'd'
+probe index? find/last/case long 'T'
+probe index? find/case slice long 40 "lazy"
+probe index? find long "THE QUICK"
+probe index? find/last long "THE QUICK"
+probe index? find/last/case long "The quick"
+aa: append make string! 200 "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaab"
+probe index? find aa "AAAAAAAAAAAAAAAAAAAAAb"
+probe index? find/last aa "aaab"
+probe find aa "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+
 ; Find does't work with utf8 series & latin1 value.
 ;probe find encode 'utf8 "Some Random Bits" "Random"
 
@@ -138,6 +162,7 @@ probe find c: "Not a path" sep
 probe find/last a sep
 probe find/last b sep
 probe find/last c sep
+probe index? find "................................................/." sep
 
 
 print "---- Invalid"
@@ -23,3 +23,59 @@ foreach [l s] strings [
     probe uppercase s
     probe lowercase s
 ]
+
+
+print "---- long runs"
+long: {The quick brown fox jumps over the lazy dog, ^-then naïve Ωmega ^/and the quick brown fox jumps over the lazy dog.}
+foreach s reduce [long  slice long 64  skip long 40] [
+    u: encode 'utf8 s
+    l: encode 'latin1 u
+    print [encoding? u size? u size? l equal? s encode 'ucs2 u]
+]
+probe to-string #{54686520717569636B2062726F776E20666F78206A756D7073206F766572C3A9}
+
+
+print "---- outside UCS-2"
+s: "a^(1f600)b^(20ac)"
+probe encoding? s
+probe append copy "x" s
+probe append copy "Жx" s
+probe encode 'latin1 s
+
+
+print "---- utf8 positions"
+s: "a^(1f600)b^(20ac)c"
+print [encoding? s size? s index? next next s size? next next s]
+probe reduce [pick s 2 second s last s first skip s 3 pick s -1 pick s 9]
+probe slice next s 2
+probe find s 'b'
+probe index? find s '^(20ac)'
+probe prev tail s
+poke s 2 'x'
+probe s
+poke s 1 '^(1f635)'
+probe s
+probe reverse copy s
+t: copy s
+insert next t "é"
+probe t
+probe change next t "^(1f600)^(1f600)"
+remove/part next t 2
+probe t
+probe remove prev tail t
+probe skip t -1
+probe head clear skip t 2
+foreach [a b] "^(1f600)x^(1f635)" [probe reduce [a b]]
+probe map c copy "a^(1f600)b" [either eq? c 'b' ['^(1f927)'] [c]]
+
+big: copy "^(1f600)"
+loop 600 [append big "ab^(1f600)"]
+print [size? big size? to-binary big index? tail big]
+probe reduce [pick big 1000 pick big 1001 pick big 1801 pick big 1802]
+probe index? skip big 1500
+remove big
+probe reduce [size? big pick big 1000 index? find skip big 1500 'b']
+change skip big 900 'Z'
+probe reduce [size? big pick big 901 copy slice skip big 899 4]
+change/part skip big 2 "wxyz" 1
+probe reduce [size? big pick big 6 index? find big 'z' pick big 1803]
@@ -78,6 +78,8 @@ void ur_arrInit( UBuffer* buf, int size, int count )
 */
 void ur_arrFree( UBuffer* buf )
 {
+    if( buf->flags & UR_BUF_MAPPED )
+        ur_binUnmap( buf, 0 );
     if( buf->ptr.b )
     {
         memFree( buf->ptr.b - FORWARD(buf->elemSize) );
@@ -109,6 +111,12 @@ void ur_arrReserve( UBuffer* buf, int count )
     if( avail < count )
         avail = (count < 8) ? 8 : count;
 
+    if( buf->flags & UR_BUF_MAPPED )
+    {
+        ur_binUnmap( buf, avail );      // Mapped strings have elemSize 1.
+        return;
+    }
+
     fwd = FORWARD(buf->elemSize);
 
     if( buf->ptr.b )
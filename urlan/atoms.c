@@ -152,6 +152,7 @@ static UAtom _internAtom( UThread* ut, UBuffer* atoms, UBuffer* names,
     UIndex   avail;
     AtomRec* table;
     AtomRec* node;
+    uint16_t* link;
 
 #if 0
     uint8_t rep[32];
@@ -177,7 +178,7 @@ static UAtom _internAtom( UThread* ut, UBuffer* atoms, UBuffer* names,
     node = table + (hash % avail);
     if( node->head == 0xffff )
     {
-        node->head = atoms->used;
+        link = &node->head;
     }
     else
     {
@@ -210,14 +211,15 @@ static UAtom _internAtom( UThread* ut, UBuffer* atoms, UBuffer* names,
 
             if( node->chain == 0xffff )
             {
-                node->chain = atoms->used;
+                link = &node->chain;
                 break;
             }
             node = table + node->chain;
         }
     }
 
-    // Nope, add new atom.
+    // Nope, add new atom.  The tables must not be modified if it won't fit
+    // or the hash chain will be left pointing at an unused entry.
 
     if( atoms->used == avail )
     {
@@ -227,13 +229,6 @@ static UAtom _internAtom( UThread* ut, UBuffer* atoms, UBuffer* names,
             ur_error( ut, UR_ERR_INTERNAL, "Atom table is full" );
         return UR_INVALID_ATOM;
     }
-    node = table + atoms->used;
-    ++atoms->used;
-
-    node->hash      = hash;
-    node->nameIndex = names->used;
-    node->nameLen   = len;
-
 #if 1
     if( (names->used + len + 1) > ur_avail(names) )
     {
@@ -245,6 +240,14 @@ static UAtom _internAtom( UThread* ut, UBuffer* atoms, UBuffer* names,
     ur_arrayReserve( names, sizeof(char), names->used + len + 1 );
 #endif
 
+    *link = atoms->used;
+    node = table + atoms->used;
+    ++atoms->used;
+
+    node->hash      = hash;
+    node->nameIndex = names->used;
+    node->nameLen   = len;
+
     cp = names->ptr.b + names->used;
     names->used += len + 1;
     while( str != end )
@@ -21,7 +21,7 @@
     type        UT_BINARY
     elemSize    Unused
     form        UR_BENC_*
-    flags       Unused
+    flags       UR_BUF_MAPPED
     used        Number of bytes used
     ptr.b       Data
     ptr.i[-1]   Number of bytes available
@@ -31,9 +31,19 @@
 #include "urlan.h"
 #include "os.h"
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 
 #define FORWARD     sizeof(int32_t)
 
+// For a mapped file the length of the mapping is kept in the page before
+// the data along with the available byte count.
+#define MAP_LEN(buf)    ((size_t*) ((buf)->ptr.b - 16))
+
 
 /** \defgroup dt_binary Datatype Binary
   \ingroup urlan
@@ -119,6 +129,8 @@ void ur_binInit( UBuffer* buf, int size )
 */
 void ur_binFree( UBuffer* buf )
 {
+    if( buf->flags & UR_BUF_MAPPED )
+        ur_binUnmap( buf, 0 );
     if( buf->ptr.b )
     {
         memFree( buf->ptr.b - FORWARD );
@@ -128,6 +140,118 @@ void ur_binFree( UBuffer* buf )
 }
 
 
+/**
+  Initialize buffer to type UT_BINARY and map the contents of a file into it.
+
+  The file is mapped privately, so changes to the buffer are not written
+  to the file.  The mapping is released by ur_binFree(), or replaced with
+  allocated memory by ur_binUnmap() if the buffer needs to grow.
+
+  \param buf        Uninitialized buffer.
+  \param filename   Name of file to map.
+
+  \return Non-zero if successful.  If the file cannot be mapped (or memory
+          mapping is not supported) zero is returned and buf is initialized
+          as an empty binary.
+*/
+int ur_binInitMapped( UBuffer* buf, const char* filename )
+{
+#ifdef _WIN32
+    (void) filename;
+    ur_binInit( buf, 0 );
+    return 0;
+#else
+    struct stat info;
+    uint8_t* mem;
+    size_t page;
+    size_t len;
+    int fd;
+
+    ur_binInit( buf, 0 );
+
+    fd = open( filename, O_RDONLY );
+    if( fd < 0 )
+        return 0;
+    if( fstat( fd, &info ) < 0 || ! S_ISREG(info.st_mode) ||
+        info.st_size < 1 || info.st_size > 0x7fffffff )
+        goto fail;
+    len  = info.st_size;
+    page = sysconf( _SC_PAGESIZE );
+
+    // Reserve an extra page before the file for the buffer header.
+    mem = (uint8_t*) mmap( 0, page + len, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+    if( mem == MAP_FAILED )
+        goto fail;
+    if( mmap( mem + page, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED,
+              fd, 0 ) == MAP_FAILED )
+    {
+        munmap( mem, page + len );
+        goto fail;
+    }
+    close( fd );
+
+    buf->ptr.b = mem + page;
+    buf->used  = len;
+    buf->flags = UR_BUF_MAPPED;
+    ur_avail(buf) = len;
+    *MAP_LEN(buf) = page + len;
+    return 1;
+
+fail:
+    close( fd );
+    return 0;
+#endif
+}
+
+
+/**
+  Copy the data of a mapped buffer into allocated memory and release the
+  mapping.  Does nothing if buf is not mapped.
+
+  This is done by ur_binReserve() & ur_arrReserve() when a mapped buffer
+  needs more memory, so it should rarely need to be called directly.
+
+  \param buf    Initialized binary or string buffer with a single byte
+                element size.
+  \param size   Number of bytes to reserve.  If zero, the data is not
+                copied and buf->ptr is set to zero.
+*/
+void ur_binUnmap( UBuffer* buf, int size )
+{
+#ifdef _WIN32
+    (void) buf;
+    (void) size;
+#else
+    uint8_t* mem;
+    size_t len;
+
+    if( ! (buf->flags & UR_BUF_MAPPED) )
+        return;
+
+    mem = buf->ptr.b;
+    len = *MAP_LEN(buf);
+    if( size > 0 )
+    {
+        if( size < buf->used )
+            size = buf->used;
+        buf->ptr.b = (uint8_t*) memAlloc( size + FORWARD );
+        assert( buf->ptr.b );
+        buf->ptr.b += FORWARD;
+        ur_avail(buf) = size;
+        memCpy( buf->ptr.b, mem, buf->used );
+    }
+    else
+    {
+        buf->ptr.b = 0;
+        buf->used = 0;
+    }
+    munmap( mem - sysconf( _SC_PAGESIZE ), len );
+    buf->flags &= ~UR_BUF_MAPPED;
+#endif
+}
+
+
 /**
   Allocates enough memory to hold size bytes.
   buf->used is not changed.
@@ -149,6 +273,12 @@ void ur_binReserve( UBuffer* buf, int size )
     if( avail < size )
         avail = (size < 8) ? 8 : size;
 
+    if( buf->flags & UR_BUF_MAPPED )
+    {
+        ur_binUnmap( buf, avail );
+        return;
+    }
+
     if( buf->ptr.b )
         mem = (uint8_t*) memRealloc( buf->ptr.b - FORWARD, avail + FORWARD );
     else
@@ -301,7 +431,7 @@ const char* ur_binAppendBase( UBuffer* buf, const char* it, const char* end,
             high = 0;
             while( it != end )
             {
-                c = *it++;
+                c = (uint8_t) *it++;
                 if( ur_bitIsSet(charset_hex, c) )
                 {
                     byte |= hexNibble(c);
@@ -330,7 +460,7 @@ const char* ur_binAppendBase( UBuffer* buf, const char* it, const char* end,
             high = 0x80;
             while( it != end )
             {
-                c = *it++;
+                c = (uint8_t) *it++;
                 if( c == '0' || c == '1' )
                 {
                     if( c == '1' )
@@ -362,7 +492,7 @@ const char* ur_binAppendBase( UBuffer* buf, const char* it, const char* end,
             high = 0;
             while( it != end )
             {
-                c = *it++;
+                c = (uint8_t) *it++;
                 if( ur_bitIsSet(charset_base64, c) )
                 {
                     if( c == '=' )
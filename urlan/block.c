@@ -21,10 +21,22 @@
     type        UT_BLOCK, UT_PAREN, etc.
     elemSize    16, sizeof(UCell)
     form        Unused
-    flags       Unused
+    flags       UR_BLOCK_INDEXED
     used        Number of cells used
     ptr.cell    Cells
     ptr.i[-1]   Number of cells available
+    ptr.i[-2]   Offset of index buffer if UR_BLOCK_INDEXED is set
+
+  Index buffer members (see ur_blkIndex):
+    type        UT_VECTOR
+    form        UR_VEC_I32
+    used        Number of int32_t used
+    ptr.i[0]    Hash table mask
+    ptr.i[1]    Skip (record size)
+    ptr.i[2]    Number of block cells indexed
+    ptr.i[3..]  Hash table of first positions followed by next position
+                for each indexed record.  All lists are in ascending order
+                and terminated by -1.
 */
 
 
@@ -317,6 +329,231 @@ void ur_blkCollectType( UThread* ut, const UCell* blkCell,
 }
 
 
+//----------------------------------------------------------------------------
+
+
+#define IDX_MASK    0
+#define IDX_SKIP    1
+#define IDX_COUNT   2
+#define IDX_TABLE   3
+#define IDX_END     -1
+#define INDEX_OFFSET(buf)   (buf)->ptr.i32[-2]
+
+
+/*
+  Hash a cell for the block index.
+
+  Any two values which are ur_equal() must produce the same hash, so numbers
+  are hashed as doubles.
+
+  Series values are not indexed since their contents can be changed
+  without modifying the block.
+
+  \return Non-zero if the value can be indexed.
+*/
+static int _indexHash( const UCell* cell, uint32_t* hash )
+{
+    uint32_t h = 5381;
+    const uint8_t* bp;
+    const uint8_t* bend;
+    double d;
+
+    switch( ur_type(cell) )
+    {
+        case UT_CHAR:
+        case UT_INT:
+            d = (double) ur_int(cell);
+            goto hash_double;
+
+        case UT_DOUBLE:
+        case UT_TIME:
+        case UT_DATE:
+            d = ur_double(cell);
+hash_double:
+            if( d == 0.0 )
+                d = 0.0;        // Same hash for -0.0.
+            bp = (const uint8_t*) &d;
+            bend = bp + sizeof(double);
+            goto hash_bytes;
+
+        case UT_WORD:
+        case UT_LITWORD:
+        case UT_SETWORD:
+        case UT_GETWORD:
+        case UT_OPTION:
+            // Words named after datatypes are equal to datatype! values.
+            if( ur_atom(cell) < UT_MAX )
+                return 0;
+            h = ur_atom(cell) * 2654435761u;
+            break;
+
+        default:
+            return 0;
+    }
+    *hash = h;
+    return 1;
+
+hash_bytes:
+    while( bp != bend )
+        h = (33 * h) + *bp++;
+    *hash = h;
+    return 1;
+}
+
+
+/**
+  Build a hash index for a block so that find & select do not need to
+  do a linear search.
+
+  The index is dropped when the block is next modified (when the buffer is
+  fetched with ur_bufferSerM()), so it is only useful for blocks which
+  are searched many times between changes.
+
+  Only numbers, dates, chars & words are put in the index.  Finding other
+  values is still done with a linear search.
+
+  If skip is greater than one then only the first value of each record of
+  that size (starting at the block head) is indexed, and find only matches
+  at those positions.
+
+  \param blkC   Block to index.  The buffer must not be shared.
+  \param skip   Record size.
+
+  \return UR_OK or UR_THROW.
+*/
+UStatus ur_blkIndex( UThread* ut, const UCell* blkC, int skip )
+{
+    UBuffer* blk;
+    UBuffer* ibuf;
+    const UCell* cells;
+    int32_t* table;
+    int32_t* next;
+    UIndex idxN;
+    UIndex pos;
+    uint32_t hash;
+    int count;
+    int size;
+
+    if( ! ur_bufferSerM(blkC) )
+        return UR_THROW;
+    if( skip < 1 )
+        skip = 1;
+
+    ibuf = ur_genBuffers( ut, 1, &idxN );       // gc!
+    blk  = ur_buffer( blkC->series.buf );
+    count = (blk->used + skip - 1) / skip;
+
+    size = 8;
+    while( size < count * 2 )
+        size <<= 1;
+
+    ur_vecInit( ibuf, UR_VEC_I32, 0, IDX_TABLE + size + count );
+    ibuf->used = IDX_TABLE + size + count;
+    table = ibuf->ptr.i32;
+    table[ IDX_MASK ]  = size - 1;
+    table[ IDX_SKIP ]  = skip;
+    table[ IDX_COUNT ] = blk->used;
+    table += IDX_TABLE;
+    next = table + size;
+    memSet( table, 0xff, size * sizeof(int32_t) );
+
+    if( ! blk->ptr.cell )
+        return UR_OK;
+
+    // Insert in reverse so that lists are in ascending order.
+    cells = blk->ptr.cell;
+    for( pos = (count - 1) * skip; pos >= 0; pos -= skip )
+    {
+        if( _indexHash( cells + pos, &hash ) )
+        {
+            hash &= size - 1;
+            next[ pos / skip ] = table[ hash ];
+            table[ hash ] = pos;
+        }
+    }
+
+    INDEX_OFFSET(blk) = idxN - blkC->series.buf;
+    blk->flags |= UR_BLOCK_INDEXED;
+    return UR_OK;
+}
+
+
+/*
+  Return index buffer of a block with UR_BLOCK_INDEXED set.
+  The index buffer is always in the same store as the block.
+*/
+#define INDEX_BUF(blk)  ((blk) + INDEX_OFFSET(blk))
+
+
+/**
+  Mark the index buffer of a block for the garbage collector.
+*/
+void ur_blkMarkIndex( UThread* ut, UBuffer* blk )
+{
+    ur_markBuffer( ut, (blk - ut->dataStore.ptr.buf) + INDEX_OFFSET(blk) );
+}
+
+
+/**
+  Find value in an indexed block.
+
+  This is called by the block find method when UR_BLOCK_INDEXED is set.
+
+  \param si     Block slice to search.
+  \param val    Value to find.
+  \param opt    UrlanFindOption mask.
+
+  \return Cell position of value or -1 if not found.
+*/
+UIndex ur_blkFindIndexed( UThread* ut, const USeriesIter* si,
+                          const UCell* val, int opt )
+{
+    const UBuffer* blk = si->buf;
+    const int32_t* table = INDEX_BUF(blk)->ptr.i32;
+    const int32_t* next;
+    int (*equal)(UThread*, const UCell*, const UCell*) =
+        (opt & UR_FIND_CASE) ? ur_equalCase : ur_equal;
+    UIndex pos;
+    UIndex found = -1;
+    int skip = table[ IDX_SKIP ];
+    uint32_t hash;
+
+    if( table[ IDX_COUNT ] != blk->used || ! _indexHash( val, &hash ) )
+    {
+        // Value is not in index; check each record.
+        pos = si->it + skip - 1;
+        pos -= pos % skip;
+        for( ; pos < si->end; pos += skip )
+        {
+            if( equal( ut, val, blk->ptr.cell + pos ) )
+            {
+                found = pos;
+                if( ! (opt & UR_FIND_LAST) )
+                    break;
+            }
+        }
+        return found;
+    }
+
+    next = table + IDX_TABLE + table[ IDX_MASK ] + 1;
+    pos = table[ IDX_TABLE + (hash & table[ IDX_MASK ]) ];
+    for( ; pos != IDX_END; pos = next[ pos / skip ] )
+    {
+        if( pos < si->it )
+            continue;
+        if( pos >= si->end )
+            break;
+        if( equal( ut, val, blk->ptr.cell + pos ) )
+        {
+            found = pos;
+            if( ! (opt & UR_FIND_LAST) )
+                break;
+        }
+    }
+    return found;
+}
+
+
 /** @} */ 
 
 
@@ -25,6 +25,19 @@
     used        Number of words used (sorted + unsorted)
     ptr.cell    Cell values
     ptr.i[-1]   Number of words available
+    ptr.i[-2]   Non-zero if the shape is borrowed from a shared context
+    ptr.b[-16]  Pointer to CtxShape
+
+  The words of a context are kept in a CtxShape, which holds the UAtomEntry
+  search table followed, for large contexts, by an open addressing hash
+  table of UAtomEntry which is used instead of the sorted search table.
+  For hashed contexts the sorted count is the number of entries which have
+  been inserted into the hash.
+
+  Contexts which are cloned from one another share the same shape until
+  a word is added, so only the value cells are allocated per instance.
+  A shape may only be modified when its reference count is one.  Shapes of
+  contexts in the shared environment are borrowed without being counted.
 */
 
 
@@ -33,8 +46,26 @@
 
 
 #define SEARCH_LEN      2
-#define ENTRIES(buf)    ((UAtomEntry*) (buf->ptr.cell + ur_avail(buf)))
-#define FORWARD         8
+#define FORWARD         16
+#define HASH_MIN        64
+#define HASH_ATOM(a)    (((uint32_t) (a)) * 2654435761u)
+
+#define SHAPE(buf)      (*((CtxShape**) ((buf)->ptr.b - FORWARD)))
+#define BORROWED(buf)   (buf)->ptr.i32[-2]
+#define WRITABLE(buf)   (! BORROWED(buf) && SHAPE(buf)->refs == 1)
+#define ENTRIES(buf)    ((UAtomEntry*) (SHAPE(buf) + 1))
+#define HTABLE(buf)     (ENTRIES(buf) + SHAPE(buf)->avail)
+#define HASHED(buf)     SHAPE(buf)->hashMask
+
+
+typedef struct
+{
+    int32_t     refs;       // Number of contexts using this shape.
+    int32_t     avail;      // Number of entries available.
+    uint32_t    hashMask;   // Zero if there is no hash table.
+    int32_t     _pad;
+}
+CtxShape;
 
 
 typedef struct
@@ -123,14 +154,87 @@ UBuffer* ur_makeContextCell( UThread* ut, int size, UCell* cell )
 }
 
 
-/**
-  Allocates enough memory to hold size words.
-  buf->used is not changed.
+/*
+  Insert any entries past the sorted count into the hash table.
+*/
+static void _ctxHashInsert( UBuffer* ctx )
+{
+    UAtomEntry* table = HTABLE(ctx);
+    const UAtomEntry* it  = ENTRIES(ctx) + CC(ctx)->sorted;
+    const UAtomEntry* end = ENTRIES(ctx) + ctx->used;
+    uint32_t mask = HASHED(ctx);
+    uint32_t i;
 
-  \param buf    Initialized context buffer.
-  \param size   Number of words to reserve.
+    for( ; it != end; ++it )
+    {
+        i = HASH_ATOM(it->atom) & mask;
+        while( table[i].atom != UR_INVALID_ATOM )
+            i = (i + 1) & mask;
+        table[i] = *it;
+    }
+    CC(ctx)->sorted = ctx->used;
+}
+
+
+static void _shapeRelease( CtxShape* sh )
+{
+    if( --sh->refs == 0 )
+        memFree( sh );
+}
+
+
+/*
+  Give the context a new shape of its own which holds as many entries as
+  there are cells available.  Any existing entries are copied.
 */
-void ur_ctxReserve( UBuffer* buf, int size )
+static void _ctxOwnShape( UBuffer* buf )
+{
+    CtxShape* sh;
+    CtxShape* old = SHAPE(buf);
+    int na = ur_avail(buf);
+    int hsize = 0;
+
+    if( na >= HASH_MIN )
+    {
+        hsize = HASH_MIN * 2;
+        while( hsize < na * 2 )
+            hsize <<= 1;
+    }
+
+    sh = (CtxShape*) memAlloc( sizeof(CtxShape) +
+                               sizeof(UAtomEntry) * (na + hsize) );
+    assert( sh );
+    sh->refs  = 1;
+    sh->avail = na;
+    sh->hashMask = hsize ? hsize - 1 : 0;
+    sh->_pad  = 0;
+    SHAPE(buf) = sh;
+
+    if( old )
+    {
+        if( buf->used )
+            memCpy( sh + 1, old + 1, buf->used * sizeof(UAtomEntry) );
+        if( old->hashMask )
+            CC(buf)->sorted = 0;
+        if( BORROWED(buf) )
+            BORROWED(buf) = 0;
+        else
+            _shapeRelease( old );
+    }
+
+    if( hsize )
+    {
+        memSet( HTABLE(buf), 0xff, sizeof(UAtomEntry) * hsize );
+        CC(buf)->sorted = 0;
+        _ctxHashInsert( buf );
+    }
+}
+
+
+/*
+  Allocate enough memory to hold size value cells.  The shape is not changed.
+*/
+static void _ctxReserveCells( UBuffer* buf, int size )
 {
     uint8_t* mem;
     int avail;
@@ -145,27 +249,70 @@ void ur_ctxReserve( UBuffer* buf, int size )
     if( na < size )
         na = (size < 4) ? 4 : size;
 
-    mem = (uint8_t*) memAlloc( FORWARD +
-                               (sizeof(UAtomEntry) + sizeof(UCell)) * na  );
+    mem = (uint8_t*) memAlloc( FORWARD + sizeof(UCell) * na );
     assert( mem );
 
     if( buf->ptr.b )
     {
+        memCpy( mem, buf->ptr.b - FORWARD, FORWARD );
         if( buf->used )
-        {
-            uint8_t* dest = mem + FORWARD;
-            memCpy( dest, buf->ptr.cell, buf->used * sizeof(UCell) );
-            dest += na * sizeof(UCell);
-            memCpy( dest, ENTRIES(buf), buf->used * sizeof(UAtomEntry) );
-        }
+            memCpy( mem + FORWARD, buf->ptr.cell, buf->used * sizeof(UCell) );
         memFree( buf->ptr.b - FORWARD );
     }
+    else
+    {
+        *((CtxShape**) mem) = 0;
+        ((int32_t*) (mem + FORWARD))[-2] = 0;
+    }
 
     buf->ptr.b = mem + FORWARD;
     ur_avail(buf) = na;
 }
 
 
+/**
+  Allocates enough memory to hold size words.
+  buf->used is not changed.
+
+  \param buf    Initialized context buffer.
+  \param size   Number of words to reserve.
+*/
+void ur_ctxReserve( UBuffer* buf, int size )
+{
+    _ctxReserveCells( buf, size );
+    if( ! SHAPE(buf) || SHAPE(buf)->avail < size )
+        _ctxOwnShape( buf );
+}
+
+
+/*
+  Return non-zero if the shape of src must be borrowed rather than counted.
+*/
+static int _ctxBorrowShape( UThread* ut, const UBuffer* src )
+{
+    const UBuffer* store = &ut->env->sharedStore;
+    return BORROWED(src) ||
+           (src >= store->ptr.buf && src < store->ptr.buf + store->used);
+}
+
+
+/*
+  Make new context ctx use shape sh with size words.
+*/
+static void _ctxShareShape( UBuffer* ctx, CtxShape* sh, int size, int sorted,
+                            int borrow )
+{
+    _ctxReserveCells( ctx, size );
+    SHAPE(ctx) = sh;
+    CC(ctx)->sorted = sorted;
+    ctx->used = size;
+    if( borrow )
+        BORROWED(ctx) = 1;
+    else
+        ++sh->refs;
+}
+
+
 /*
   Copy cells and clone any child blocks.
 
@@ -223,16 +370,15 @@ UBuffer* ur_ctxClone( UThread* ut, const UBuffer* src, UCell* cell )
     {
         // Save src members; src will be invalid after ur_makeContextCell.
         UCell* srcCells = src->ptr.cell;
-        UAtomEntry* srcEntries = ENTRIES(src);
+        CtxShape* sh = SHAPE(src);
         int sorted = CC(src)->sorted;
         int size = src->used;
+        int borrow = _ctxBorrowShape( ut, src );
 
-        UBuffer* nc = ur_makeContextCell( ut, size, cell );     // gc!
+        UBuffer* nc = ur_makeContextCell( ut, 0, cell );        // gc!
         UIndex hold = ur_hold( cell->context.buf );
 
-        memCpy( ENTRIES(nc), srcEntries, size * sizeof(UAtomEntry) );
-        CC(nc)->sorted = sorted;
-        nc->used = size;
+        _ctxShareShape( nc, sh, size, sorted, borrow );
         ur_deepCopyCells( ut, nc->ptr.cell, srcCells, size );   // gc!
 
         nc = ur_buffer( cell->context.buf );        // Re-aquire
@@ -256,20 +402,22 @@ UBuffer* ur_ctxClone( UThread* ut, const UBuffer* src, UCell* cell )
 */
 UBuffer* ur_ctxMirror( UThread* ut, const UBuffer* src, UCell* cell )
 {
-    // Save src members; src will be invalid after ur_makeContextCell.
-    UCell* srcCells = src->ptr.cell;
-    UAtomEntry* srcEntries = ENTRIES(src);
-    int sorted = CC(src)->sorted;
-    int size = src->used;
-
-    UBuffer* nc = ur_makeContextCell( ut, size, cell );     // gc!
+    if( src->used )
+    {
+        // Save src members; src will be invalid after ur_makeContextCell.
+        UCell* srcCells = src->ptr.cell;
+        CtxShape* sh = SHAPE(src);
+        int sorted = CC(src)->sorted;
+        int size = src->used;
+        int borrow = _ctxBorrowShape( ut, src );
 
-    memCpy( ENTRIES(nc), srcEntries, size * sizeof(UAtomEntry) );
-    CC(nc)->sorted = sorted;
-    nc->used = size;
-    memCpy( nc->ptr.cell, srcCells, size * sizeof(UCell) );
+        UBuffer* nc = ur_makeContextCell( ut, 0, cell );    // gc!
 
-    return nc;
+        _ctxShareShape( nc, sh, size, sorted, borrow );
+        memCpy( nc->ptr.cell, srcCells, size * sizeof(UCell) );
+        return nc;
+    }
+    return ur_makeContextCell( ut, 0, cell );
 }
 
 
@@ -317,6 +465,8 @@ void ur_ctxFree( UBuffer* buf )
 {
     if( buf->ptr.b )
     {
+        if( SHAPE(buf) && ! BORROWED(buf) )
+            _shapeRelease( SHAPE(buf) );
         memFree( buf->ptr.b - FORWARD );
         buf->ptr.b = 0;
     }
@@ -395,6 +545,8 @@ int ur_ctxAppendWord( UBuffer* ctx, UAtom atom )
 
     wrdN = ctx->used;
     ur_ctxReserve( ctx, wrdN + 1 );
+    if( ! WRITABLE(ctx) )
+        _ctxOwnShape( ctx );
     ++ctx->used;
 
     ur_setId( ctx->ptr.cell + wrdN, UT_UNSET );
@@ -403,6 +555,9 @@ int ur_ctxAppendWord( UBuffer* ctx, UAtom atom )
     went->atom  = atom;
     went->index = wrdN;
 
+    if( HASHED(ctx) && CC(ctx)->sorted == wrdN )
+        _ctxHashInsert( ctx );
+
     return wrdN;
 }
 
@@ -500,6 +655,10 @@ void ur_atomsSort( UAtomEntry* entries, int low, int high )
   If the context is already sorted then nothing is done.
   Each time new words are appended to the context it will become un-sorted.
 
+  Large contexts use a hash table rather than a sorted table, and words are
+  normally hashed as they are appended.  For these ur_ctxSort() only hashes
+  any entries which were added directly to the search table.
+
   \param ctx    Initialized context buffer.
 
   \return The ctx argument.
@@ -510,6 +669,13 @@ UBuffer* ur_ctxSort( UBuffer* ctx )
     if( used > SEARCH_LEN && CC(ctx)->sorted != used )
     {
       //printf( "KR ctxSort %p %d,%d\n", (void*) ctx, used, CC(ctx)->sorted );
+        if( BORROWED(ctx) )
+            _ctxOwnShape( ctx );
+        if( HASHED(ctx) )
+        {
+            _ctxHashInsert( ctx );
+            return ctx;
+        }
         ur_atomsSort( ENTRIES(ctx), 0, used - 1 );
         CC(ctx)->sorted = used;
     }
@@ -522,6 +688,13 @@ UBuffer* ur_ctxSortU( UBuffer* ctx, int unsorted )
     int used = ctx->used;
     if( used > SEARCH_LEN && (CC(ctx)->sorted + unsorted) < used )
     {
+        if( BORROWED(ctx) )
+            _ctxOwnShape( ctx );
+        if( HASHED(ctx) )
+        {
+            _ctxHashInsert( ctx );
+            return ctx;
+        }
       //printf( "KR ctxSort %p %d,%d\n", (void*) ctx, used, CC(ctx)->sorted );
         ur_atomsSort( ENTRIES(ctx), 0, used - 1 );
         CC(ctx)->sorted = used;
@@ -557,8 +730,7 @@ const UBuffer* ur_sortedContext( UThread* ut, const UCell* cell )
             ur_error(ut, UR_ERR_INTERNAL, "Shared context %d is not sorted", n);
             return 0;
         }
-        ur_atomsSort( ENTRIES(ctx), 0, used - 1 );
-        CC(ctx)->sorted = used;
+        ur_ctxSort( ctx );
     }
     return ctx;
 }
@@ -583,7 +755,21 @@ int ur_ctxLookup( const UBuffer* ctx, UAtom atom )
 
     went = ENTRIES(ctx);
     sorted = CC(ctx)->sorted;
-    i = ur_atomsSearch( went, sorted, atom );
+    if( HASHED(ctx) )
+    {
+        const UAtomEntry* table = HTABLE(ctx);
+        uint32_t mask = HASHED(ctx);
+        uint32_t h = HASH_ATOM(atom) & mask;
+        i = -1;
+        while( table[h].atom != UR_INVALID_ATOM )
+        {
+            if( table[h].atom == atom )
+                return table[h].index;
+            h = (h + 1) & mask;
+        }
+    }
+    else
+        i = ur_atomsSearch( went, sorted, atom );
     if( i < 0 && ctx->used > sorted )
     {
         const UAtomEntry* it  = went + sorted;
@@ -723,6 +723,32 @@ void char_toString( UThread* ut, const UCell* cell, UBuffer* str, int depth )
     (void) ut;
     (void) depth;
 
+    if( ur_int(cell) > 0xffff )
+    {
+        // Outside UCS-2; only a UTF-8 string can hold it directly.
+        int32_t c = ur_int(cell);
+        if( str->form == UR_ENC_UTF8 )
+        {
+            ur_strAppendChar( str, '\'' );
+            ur_strAppendChar( str, c );
+            ur_strAppendChar( str, '\'' );
+        }
+        else
+        {
+            ur_strAppendCStr( str, "'^(" );
+            if( c > 0xfffff )
+                ur_strAppendChar( str, _hexDigits[ (c >> 20) & 0xf ] );
+            for( n = 16; ; n -= 4 )
+            {
+                ur_strAppendChar( str, _hexDigits[ (c >> n) & 0xf ] );
+                if( ! n )
+                    break;
+            }
+            ur_strAppendCStr( str, ")'" );
+        }
+        return;
+    }
+
     if( n > 127 )
     {
         if( str->form == UR_ENC_UCS2 )
@@ -2342,6 +2368,12 @@ check_find:
             it = find_charset_uint8_t( ba, bb, bbuf->ptr.b, bbuf->used );
         goto check_find;
     }
+    else if( ur_isMatcher( ut, val ) )
+    {
+        int len, pat;
+        return ur_matcherFind( ur_bufferSer(val), buf, si->it, si->end,
+                               opt, &len, &pat );
+    }
     return -1;
 }
 
@@ -2712,19 +2744,28 @@ int string_make( UThread* ut, const UCell* from, UCell* res )
 }
 
  
-#define COMPARE_IC(T) \
+/*
+  The mismatch_ic functions fold Latin-1 letters with SIMD; only the
+  characters where they stop need the full case conversion.
+*/
+#define COMPARE_IC(T,N) \
 int compare_ic_ ## T( const T* it, const T* end, \
         const T* itB, const T* endB ) { \
+    const T* pos; \
     int ca, cb; \
     int lenA = end - it; \
     int lenB = endB - itB; \
-    while( it < end && itB < endB ) { \
-        ca = ur_charLowercase( *it++ ); \
+    if( lenB < lenA ) \
+        end = it + lenB; \
+    while( (pos = mismatch_ic_ ## N( it, end, itB )) != end ) { \
+        itB += pos - it; \
+        ca = ur_charLowercase( *pos ); \
         cb = ur_charLowercase( *itB++ ); \
         if( ca > cb ) \
             return 1; \
         if( ca < cb ) \
             return -1; \
+        it = pos + 1; \
     } \
     if( lenA > lenB ) \
         return 1; \
@@ -2733,8 +2774,8 @@ int compare_ic_ ## T( const T* it, const T* end, \
     return 0; \
 }
 
-COMPARE_IC(uint8_t)
-COMPARE_IC(uint16_t)
+COMPARE_IC(uint8_t,8)
+COMPARE_IC(uint16_t,16)
 
 
 int string_compare( UThread* ut, const UCell* a, const UCell* b, int test )
@@ -2927,13 +2968,93 @@ void string_toText( UThread* ut, const UCell* cell, UBuffer* str, int depth )
 }
 
 
+/*
+  The UTF-8 methods below drop the character index of the string after
+  modifying it, as one may have been built after ur_bufferSeriesM() was
+  called (e.g. to convert a /part count).
+*/
+#define UTF8_UNINDEX(buf)   (buf)->flags &= ~UR_STRING_INDEXED
+
+
+/*
+  Return the byte length of the UTF-8 character at position n, or zero if n
+  is at the end.
+*/
+static int _utf8CharLen( const UBuffer* buf, UIndex n )
+{
+    UIndex end = n;
+    if( end < buf->used )
+    {
+        while( ++end < buf->used && (buf->ptr.b[ end ] & 0xc0) == 0x80 )
+            ;
+    }
+    return end - n;
+}
+
+
+/*
+  Insert a character into a UTF-8 string.
+
+  \return Byte length of the inserted character.
+*/
+static int _utf8InsertChar( UBuffer* buf, UIndex n, int c )
+{
+    uint8_t enc[ 4 ];
+    UIndex saveUsed = buf->used;
+    int len;
+
+    // Encode at the end then move into place.
+    ur_strAppendChar( buf, c );
+    len = buf->used - saveUsed;
+    memCpy( enc, buf->ptr.b + saveUsed, len );
+    buf->used = saveUsed;
+    ur_arrExpand( buf, n, len );
+    memCpy( buf->ptr.b + n, enc, len );
+    UTF8_UNINDEX( buf );
+    return len;
+}
+
+
+/*
+  Insert part of a string into another, converting it to the encoding of
+  buf.  This is used when the encoded length of the characters is not known
+  beforehand (i.e. when one of the strings is UTF-8).
+*/
+static void _strInsertConv( UBuffer* buf, UIndex index,
+                            const UBuffer* src, UIndex it, UIndex end )
+{
+    UIndex saveUsed = buf->used;
+
+    // Append then rotate the new characters into place.
+    ur_strAppend( buf, src, it, end );
+    UTF8_UNINDEX( buf );
+    if( index < saveUsed && buf->used > saveUsed )
+    {
+        if( ur_strIsUcs2(buf) )
+        {
+            uint16_t* cp = buf->ptr.u16;
+            reverse_uint16_t( cp + index, cp + saveUsed );
+            reverse_uint16_t( cp + saveUsed, cp + buf->used );
+            reverse_uint16_t( cp + index, cp + buf->used );
+        }
+        else
+        {
+            uint8_t* cp = buf->ptr.b;
+            reverse_uint8_t( cp + index, cp + saveUsed );
+            reverse_uint8_t( cp + saveUsed, cp + buf->used );
+            reverse_uint8_t( cp + index, cp + buf->used );
+        }
+    }
+    UTF8_UNINDEX( buf );
+}
+
+
 void string_pick( const UBuffer* buf, UIndex n, UCell* res )
 {
     if( n > -1 && n < buf->used )
     {
         ur_setId(res, UT_CHAR);
-        ur_int(res) = ur_strIsUcs2(buf) ? buf->ptr.u16[ n ]
-                                        : buf->ptr.b[ n ];
+        ur_int(res) = ur_strChar( buf, n );
     }
     else
         ur_setId(res, UT_NONE);
@@ -2948,6 +3069,11 @@ void string_poke( UBuffer* buf, UIndex n, const UCell* val )
         {
             if( ur_strIsUcs2(buf) )
                 buf->ptr.u16[ n ] = ur_int(val);
+            else if( ur_strIsUtf8(buf) )
+            {
+                ur_arrErase( buf, n, _utf8CharLen( buf, n ) );
+                _utf8InsertChar( buf, n, ur_int(val) );
+            }
             else
                 buf->ptr.b[ n ] = ur_int(val);
         }
@@ -3000,6 +3126,21 @@ int string_insert( UThread* ut, UBuffer* buf, UIndex index,
         int len;
 
         ur_seriesSlice( ut, &si, val );
+        if( ur_strIsUtf8(buf) || ur_strIsUtf8(si.buf) )
+        {
+            if( ur_strIsUtf8(si.buf) && part < si.end - si.it )
+            {
+                len = ur_strCharPos( ut, si.buf, part +
+                                     ur_strCharIndex( ut, si.buf, si.it ) );
+                if( len < si.end )
+                    si.end = len;
+            }
+            else if( part < si.end - si.it )
+                si.end = si.it + part;
+            _strInsertConv( buf, index, si.buf, si.it, si.end );
+            return UR_OK;
+        }
+
         len = si.end - si.it;
         if( len > part )
             len = part;
@@ -3016,6 +3157,11 @@ int string_insert( UThread* ut, UBuffer* buf, UIndex index,
     }
     else if( type == UT_CHAR )
     {
+        if( ur_strIsUtf8(buf) )
+        {
+            _utf8InsertChar( buf, index, ur_int(val) );
+            return UR_OK;
+        }
         ur_arrExpand( buf, index, 1 );
         if( ur_strIsUcs2(buf) )
             buf->ptr.u16[ index ] = ur_int(val);
@@ -3034,13 +3180,37 @@ int string_insert( UThread* ut, UBuffer* buf, UIndex index,
 
   \return  si->it is placed at end of change and si->buf.used may be modified.
 */
-static void ur_strChange( USeriesIterM* si, USeriesIter* ri, UIndex part )
+static void ur_strChange( UThread* ut, USeriesIterM* si, USeriesIter* ri,
+                          UIndex part )
 {
     UBuffer* buf;
     UIndex newUsed;
     int rlen = ri->end - ri->it;
 
-    if( rlen > 0 )
+    if( rlen > 0 && (ur_strIsUtf8(si->buf) || ur_strIsUtf8(ri->buf)) )
+    {
+        // Encoded lengths differ so remove the old characters & insert.
+        buf = si->buf;
+        if( part < 1 )
+        {
+            // Overwrite as many characters as are in the replacement.
+            if( ur_strIsUtf8(ri->buf) )
+                rlen = ur_strCharIndex( ut, ri->buf, ri->end ) -
+                       ur_strCharIndex( ut, ri->buf, ri->it );
+            part = ur_strIsUtf8(buf) ?
+                ur_strCharPos( ut, buf, rlen +
+                               ur_strCharIndex( ut, buf, si->it ) ) - si->it :
+                rlen;
+        }
+        if( part > buf->used - si->it )
+            part = buf->used - si->it;
+        ur_arrErase( buf, si->it, part );
+
+        newUsed = buf->used;
+        _strInsertConv( buf, si->it, ri->buf, ri->it, ri->end );
+        si->it += buf->used - newUsed;
+    }
+    else if( rlen > 0 )
     {
         buf = si->buf;
         if( part > 0 )
@@ -3080,7 +3250,16 @@ int string_change( UThread* ut, USeriesIterM* si, const UCell* val,
     USeriesIter siV;
     int type = ur_type(val);
 
-    if( type == UT_CHAR )
+    if( type == UT_CHAR && ur_strIsUtf8(si->buf) )
+    {
+        UBuffer* buf = si->buf;
+        UIndex len = (part > 0) ? part : _utf8CharLen( buf, si->it );
+        if( len > buf->used - si->it )
+            len = buf->used - si->it;
+        ur_arrErase( buf, si->it, len );
+        si->it += _utf8InsertChar( buf, si->it, ur_int(val) );
+    }
+    else if( type == UT_CHAR )
     {
         UBuffer* buf = si->buf;
         if( si->it == buf->used )
@@ -3098,7 +3277,7 @@ int string_change( UThread* ut, USeriesIterM* si, const UCell* val,
     else if( ur_isStringType(type) )
     {
         ur_seriesSlice( ut, &siV, val );
-        ur_strChange( si, &siV, part );
+        ur_strChange( ut, si, &siV, part );
     }
     else
     {
@@ -3111,7 +3290,7 @@ int string_change( UThread* ut, USeriesIterM* si, const UCell* val,
         siV.it  = 0;
         siV.end = tmp.used;
 
-        ur_strChange( si, &siV, part );
+        ur_strChange( ut, si, &siV, part );
         ur_strFree( &tmp );
     }
     return UR_OK;
@@ -3121,18 +3300,46 @@ int string_change( UThread* ut, USeriesIterM* si, const UCell* val,
 void string_remove( UThread* ut, USeriesIterM* si, UIndex part )
 {
     (void) ut;
-    ur_arrErase( si->buf, si->it, (part > 0) ? part : 1 );
+    if( ur_strIsUtf8(si->buf) )
+    {
+        if( part < 1 )
+            part = _utf8CharLen( si->buf, si->it );
+        UTF8_UNINDEX( si->buf );
+    }
+    else if( part < 1 )
+        part = 1;
+    ur_arrErase( si->buf, si->it, part );
 }
 
 
 void string_reverse( const USeriesIterM* si )
 {
-    const UBuffer* buf = si->buf;
-    assert( buf->form != UR_ENC_UTF8 );
+    UBuffer* buf = si->buf;
     if( ur_strIsUcs2(buf) )
         reverse_uint16_t( buf->ptr.u16 + si->it, buf->ptr.u16 + si->end );
     else
-        reverse_uint8_t( buf->ptr.b + si->it, buf->ptr.b + si->end );
+    {
+        uint8_t* it  = buf->ptr.b + si->it;
+        uint8_t* end = buf->ptr.b + si->end;
+        reverse_uint8_t( it, end );
+        if( ur_strIsUtf8(buf) )
+        {
+            // Put the bytes of each multi-byte character back in order.
+            uint8_t* seq;
+            UTF8_UNINDEX( buf );
+            for( ; it != end; ++it )
+            {
+                if( (*it & 0xc0) == 0x80 )
+                {
+                    for( seq = it; it != end && (*it & 0xc0) == 0x80; ++it )
+                        ;
+                    if( it == end )
+                        break;
+                    reverse_uint8_t( seq, it + 1 );
+                }
+            }
+        }
+    }
 }
 
 
@@ -3163,6 +3370,13 @@ int string_find( UThread* ut, const USeriesIter* si, const UCell* val, int opt )
             const UBuffer* bbuf = ur_bufferSer(val);
             return find( buf, si->it, si->end, bbuf->ptr.b, bbuf->used );
         }
+
+    }
+    if( ur_isMatcher( ut, val ) )
+    {
+        int len, pat;
+        return ur_matcherFind( ur_bufferSer(val), buf, si->it, si->end,
+                               opt, &len, &pat );
     }
     return -1;
 }
@@ -3174,7 +3388,13 @@ const UCell* string_select( UThread* ut, const UCell* cell, const UCell* sel,
     if( ur_is(sel, UT_INT) )
     {
         const UBuffer* buf = ur_bufferSer(cell);
-        string_pick( buf, cell->series.it + ur_int(sel) - 1, tmp );
+        UIndex n = ur_int(sel) - 1;
+        if( ur_strIsUtf8(buf) )
+            n = ur_strCharPos( ut, buf,
+                               n + ur_strCharIndex( ut, buf, cell->series.it ) );
+        else
+            n += cell->series.it;
+        string_pick( buf, n, tmp );
         return tmp;
     }
     ur_error( ut, UR_ERR_SCRIPT, "string select expected int!" );
@@ -3301,8 +3521,8 @@ int block_make( UThread* ut, const UCell* from, UCell* res )
     else if( ur_is(from, UT_STRING) )
     {
         USeriesIter si;
+        ur_makeBlockCell( ut, UT_BLOCK, 0, res );   // gc!
         ur_seriesSlice( ut, &si, from );
-        ur_makeBlockCell( ut, UT_BLOCK, 0, res );
         if( si.it == si.end )
         {
             return UR_OK;
@@ -3567,11 +3787,16 @@ void block_toText( UThread* ut, const UCell* cell, UBuffer* str, int depth )
 }
 
 
+extern void ur_blkMarkIndex( UThread*, UBuffer* );
+
 void block_markBuf( UThread* ut, UBuffer* buf )
 {
     int t;
     UCell* it  = buf->ptr.cell;
     UCell* end = it + buf->used;
+
+    if( buf->flags & UR_BLOCK_INDEXED )
+        ur_blkMarkIndex( ut, buf );
     while( it != end )
     {
         t = ur_type(it);
@@ -3770,6 +3995,9 @@ int block_find( UThread* ut, const USeriesIter* si, const UCell* val, int opt )
     int (*equal)(UThread*, const UCell*, const UCell*) =
         (opt & UR_FIND_CASE) ? ur_equalCase : ur_equal;
 
+    if( buf->flags & UR_BLOCK_INDEXED )
+        return ur_blkFindIndexed( ut, si, val, opt );
+
     bi.it  = buf->ptr.cell + si->it;
     bi.end = buf->ptr.cell + si->end;
 
@@ -176,6 +176,10 @@ static void _destroyDataStore( UEnv* env, UBuffer* store )
 }
 
 
+extern void ur_parseStringFreeCache( UThread* );
+extern void ur_parseBlockFreeCache( UThread* );
+extern void ur_strFreeIndexCache( UThread* );
+
 /*
    Free memory used by UThread.
 
@@ -185,6 +189,9 @@ static void _destroyDataStore( UEnv* env, UBuffer* store )
 static void _threadFree( UThread* ut )
 {
     ut->env->threadFunc( ut, UR_THREAD_FREE );
+    ur_parseStringFreeCache( ut );
+    ur_parseBlockFreeCache( ut );
+    ur_strFreeIndexCache( ut );
     _destroyDataStore( ut->env, &ut->dataStore );
     ur_arrFree( &ut->stack );
     ur_arrFree( &ut->holds );
@@ -548,6 +555,9 @@ void ur_freezeEnv( UThread* ut )
 
     env->threadFunc( ut, UR_THREAD_FREEZE );
 
+    ur_parseStringFreeCache( ut );
+    ur_parseBlockFreeCache( ut );
+    ur_strFreeIndexCache( ut );
     ur_recycle( ut );
 
     env->sharedStore = ut->dataStore;
@@ -704,7 +714,10 @@ UBuffer* ur_genBuffers( UThread* ut, int count, UIndex* index )
     if( ut->freeBufCount < count )
     {
 #ifdef GEN_FREE
-        int newCount = count + GEN_FREE;
+        // The reserve grows with the store so that the time spent in
+        // ur_recycle stays proportional to the number of buffers made.
+        int genFree = GEN_FREE + (store->used >> 2);
+        int newCount = count + genFree;
 #else
 #define newCount    count
 #endif
@@ -721,8 +734,8 @@ UBuffer* ur_genBuffers( UThread* ut, int count, UIndex* index )
                 *index++ = id++;
 #ifdef GEN_FREE
             next = store->ptr.buf + id;
-            ut->freeBufCount += GEN_FREE;
-            end += GEN_FREE;
+            ut->freeBufCount += genFree;
+            end += genFree;
             while( id < end )
             {
                 next->type  = UT_UNSET;
@@ -1314,6 +1327,7 @@ const UBuffer* ur_bufferSeries( const UThread* ut, const UCell* cell )
 */
 UBuffer* ur_bufferSeriesM( UThread* ut, const UCell* cell )
 {
+    UBuffer* buf;
     UIndex n = cell->series.buf;
     if( ur_isShared(n) )
     {
@@ -1321,7 +1335,12 @@ UBuffer* ur_bufferSeriesM( UThread* ut, const UCell* cell )
                   ur_atomCStr( ut, ut->sharedStoreBuf[-n].type ) );
         return 0;
     }
-    return ut->dataStore.ptr.buf + n;
+    buf = ut->dataStore.ptr.buf + n;
+    if( ur_isBlockType( buf->type ) )
+        buf->flags &= ~UR_BLOCK_INDEXED;    // Index is invalid once modified.
+    else if( ur_isStringType( buf->type ) )
+        buf->flags &= ~UR_STRING_INDEXED;
+    return buf;
 }
 
 
@@ -16,18 +16,30 @@ static inline int bitIsSet64( const uint8_t* mem, uint32_t n )
   \param pc    Parse rule.
   \param it    Current input position.
 
+  The PB_Call handler may change the input buffer, in which case it must
+  update par->base & par->end.  If it sets par->end to par->base then no
+  further input will be matched.
+
   \returns non-zero if end of rule reached.
 */
 int ur_parseBlockI( UBlockParser* par, const uint8_t* pc, const UCell* it )
 {
     const uint8_t* bset;
     const uint8_t* next = 0;
+    const UCell* base = par->base;
     const UCell* start = it;
     const UCell* sit;
     int n, t;
 
     // TODO: Handle repeating of any operation (e.g. 4 skip, 2 to 3 of rule).
 
+#define REBASE \
+    if( base != par->base ) { \
+        it    = par->base + (it - base); \
+        start = par->base + (start - base); \
+        base  = par->base; \
+    }
+
 next_op:
     switch( *pc++ )
     {
@@ -53,13 +65,15 @@ next_op:
             goto next_op;
 
         case PB_Skip:
-            if( it == par->end )
+            if( it >= par->end )
                 goto fail;
             ++it;
             goto next_op;
 
         case PB_LitWord:
             n = par->atoms[ *pc++ ];
+            if( it >= par->end )
+                goto fail;
             t = ur_type(it);
             if( ur_isWordType(t) && ur_atom(it) == n )
             {
@@ -69,71 +83,94 @@ next_op:
             goto fail;
 
         case PB_Rule:
-            if( ! ur_parseBlockI( par, par->rules + *pc++, it ) )
+            n = ur_parseBlockI( par, par->rules + *pc++, it );
+            REBASE
+            if( ! n )
                 goto fail;
             it = par->it;
             goto next_op;
 
         case PB_Type:
-            if( ur_type(it) != *pc++ )
+            if( it >= par->end || ur_type(it) != *pc++ )
                 goto fail;
             ++it;
             goto next_op;
 
         case PB_Typeset:
             bset = par->rules + *pc++;
-            if( ! bitIsSet64(bset, ur_type(it)) )
+            if( it >= par->end || ! bitIsSet64(bset, ur_type(it)) )
                 goto fail;
             ++it;
             goto next_op;
 
         case PB_OptR:
-            if( ur_parseBlockI( par, par->rules + *pc++, it ) )
-                it = par->it;
+            bset = par->rules + *pc++;
+            if( it < par->end )
+            {
+                n = ur_parseBlockI( par, bset, it );
+                REBASE
+                if( n )
+                    it = par->it;
+            }
             goto next_op;
 
         case PB_OptT:
-            if( ur_type(it) == *pc++ )
+            if( it < par->end && ur_type(it) == *pc )
                 ++it;
+            ++pc;
             goto next_op;
 
         case PB_OptTs:
             bset = par->rules + *pc++;
-            if( bitIsSet64(bset, ur_type(it)) )
+            if( it < par->end && bitIsSet64(bset, ur_type(it)) )
                 ++it;
             goto next_op;
 
         case PB_AnyR:
             bset = par->rules + *pc++;
-            while( it != par->end && ur_parseBlockI( par, bset, it ) )
+            while( it < par->end )
+            {
+                n = ur_parseBlockI( par, bset, it );
+                REBASE
+                if( ! n )
+                    break;
                 it = par->it;
+            }
             goto next_op;
 
         case PB_AnyT:
             n = *pc++;
-            while( it != par->end && ur_type(it) == n )
+            while( it < par->end && ur_type(it) == n )
                 ++it;
             goto next_op;
 
         case PB_AnyTs:
             bset = par->rules + *pc++;
-            while( it != par->end && bitIsSet64(bset, ur_type(it)) )
+            while( it < par->end && bitIsSet64(bset, ur_type(it)) )
                 ++it;
             goto next_op;
 
         case PB_SomeR:
-            sit = it;
+            t = 0;
             bset = par->rules + *pc++;
-            while( it != par->end && ur_parseBlockI( par, bset, it ) )
+            while( it < par->end )
+            {
+                n = ur_parseBlockI( par, bset, it );
+                REBASE
+                if( ! n )
+                    break;
+                if( par->it != it )
+                    t = 1;
                 it = par->it;
-            if( sit == it )
+            }
+            if( ! t )
                 goto fail;
             goto next_op;
 
         case PB_SomeT:
             sit = it;
             n = *pc++;
-            while( it != par->end && ur_type(it) == n )
+            while( it < par->end && ur_type(it) == n )
                 ++it;
             if( sit == it )
                 goto fail;
@@ -142,7 +179,7 @@ next_op:
         case PB_SomeTs:
             sit = it;
             bset = par->rules + *pc++;
-            while( it != par->end && bitIsSet64(bset, ur_type(it)) )
+            while( it < par->end && bitIsSet64(bset, ur_type(it)) )
                 ++it;
             if( sit == it )
                 goto fail;
@@ -150,7 +187,7 @@ next_op:
 
         case PB_ToT:
             n = *pc++;
-            while( it != par->end )
+            while( it < par->end )
             {
                 if( ur_type(it) == n )
                     goto next_op;
@@ -160,7 +197,7 @@ next_op:
 
         case PB_ToTs:
             bset = par->rules + *pc++;
-            while( it != par->end )
+            while( it < par->end )
             {
                 if( bitIsSet64(bset, ur_type(it)) )
                     goto next_op;
@@ -170,7 +207,7 @@ next_op:
 
         case PB_ToLitWord:
             n = par->atoms[ *pc++ ];
-            while( it != par->end )
+            while( it < par->end )
             {
                 t = ur_type(it);
                 if( ur_isWordType(t) && ur_atom(it) == n )
@@ -181,7 +218,7 @@ next_op:
 
         case PB_ThruT:
             n = *pc++;
-            while( it != par->end )
+            while( it < par->end )
             {
                 if( ur_type(it) == n )
                 {
@@ -194,7 +231,7 @@ next_op:
 
         case PB_ThruTs:
             bset = par->rules + *pc++;
-            while( it != par->end )
+            while( it < par->end )
             {
                 if( bitIsSet64(bset, ur_type(it)) )
                 {
@@ -204,6 +241,26 @@ next_op:
                 ++it;
             }
             goto fail;
+
+        case PB_Call:
+            sit = par->call( par, *pc++, it );
+            REBASE
+            if( ! sit )
+                goto fail;
+            it = sit;
+            goto next_op;
+
+        case PB_Word:
+            n = par->atoms[ *pc++ ];
+            if( it >= par->end )
+                goto fail;
+            t = ur_type(it);
+            if( (t == UT_WORD || t == UT_LITWORD) && ur_atom(it) == n )
+            {
+                ++it;
+                goto next_op;
+            }
+            goto fail;
     }
 
     par->it = it;
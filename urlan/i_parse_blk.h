@@ -36,7 +36,9 @@ enum ParseBlockInstruction
     PB_ToTs,        // rules offset of 64-bit mask
     PB_ToLitWord,   // atoms index
     PB_ThruT,       // Datatype
-    PB_ThruTs       // rules offset of 64-bit mask
+    PB_ThruTs,      // rules offset of 64-bit mask
+    PB_Call,        // call handler index
+    PB_Word         // atoms index (word! or lit-word! only)
 };
 
 
@@ -51,6 +53,8 @@ struct UBlockParser
     const UCell* end;
     void (*report)(UBlockParser*, int, const UCell*, const UCell*);
     int rflag;
+    const UCell* base;      // Input buffer start; may be moved by call.
+    const UCell* (*call)(UBlockParser*, int, const UCell*);
 };
 
 
@@ -0,0 +1,629 @@
+/*
+  This file is part of the Urlan datatype system.
+
+  Urlan is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Urlan is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with Urlan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+  UBuffer members:
+    type        Matcher! datatype id (see ur_isMatcher)
+    elemSize    Unused
+    form        Unused
+    flags       Unused
+    used        Number of patterns
+    ptr.v       MatchTable
+
+  A matcher! is an Aho-Corasick automaton built from a set of string
+  patterns.  The trie nodes are stored in breadth-first order so that the
+  edges of each node are contiguous and sorted by character.  Transitions
+  from the root for characters below 256 use a dense table.
+
+  The pattern characters are kept (unfolded) after the edges so the matcher
+  can be printed and the matched pattern returned.
+*/
+
+
+#include <string.h>
+#include "urlan.h"
+#include "os.h"
+#include "unset.h"
+
+
+typedef struct
+{
+    int32_t edge;       // First edge.
+    int32_t edgeCount;
+    int32_t fail;       // Node of the longest proper suffix in the trie.
+    int32_t out;        // Pattern ending at this node or -1.
+    int32_t dict;       // Next node on the fail chain with an out, or 0.
+}
+MatchNode;
+
+typedef struct
+{
+    uint16_t c;
+    uint16_t _pad;
+    int32_t  node;
+}
+MatchEdge;
+
+typedef struct
+{
+    int32_t nodeCount;
+    int32_t edgeCount;
+    int32_t patCount;
+    int32_t maxLen;
+    int32_t matchCase;
+    int32_t root[256];  // Dense root transitions (0 is no transition).
+}
+MatchTable;
+
+#define NODES(mt)       ((MatchNode*) ((mt) + 1))
+#define EDGES(mt)       ((MatchEdge*) (NODES(mt) + (mt)->nodeCount))
+#define PAT_START(mt)   ((int32_t*) (EDGES(mt) + (mt)->edgeCount))
+#define PAT_CHARS(mt)   ((uint16_t*) (PAT_START(mt) + (mt)->patCount + 1))
+#define PAT_LEN(mt,n)   (PAT_START(mt)[(n)+1] - PAT_START(mt)[n])
+
+
+/*
+  Return the child of node n for character c, or zero if there is none.
+*/
+static int _matchGoto( const MatchTable* mt, int n, int c )
+{
+    const MatchNode* node;
+    const MatchEdge* edge;
+    int lo, hi, mid;
+
+    if( n == 0 && c < 256 )
+        return mt->root[ c ];
+
+    node = NODES(mt) + n;
+    edge = EDGES(mt) + node->edge;
+    lo = 0;
+    hi = node->edgeCount;
+    while( lo < hi )
+    {
+        mid = (lo + hi) >> 1;
+        if( edge[mid].c == c )
+            return edge[mid].node;
+        if( edge[mid].c < c )
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return 0;
+}
+
+
+typedef struct
+{
+    int32_t  child;
+    int32_t  sibling;
+    int32_t  out;
+    uint16_t c;
+}
+TrieNode;
+
+
+static int _patternChar( const USeriesIter* si, UIndex i )
+{
+    if( ur_strIsUcs2(si->buf) )
+        return si->buf->ptr.u16[ i ];
+    return si->buf->ptr.b[ i ];
+}
+
+
+/*
+  Build the automaton from a block of strings.
+
+  Returns MatchTable pointer or zero if the block contains an invalid
+  pattern.
+*/
+static MatchTable* _buildMatcher( UThread* ut, UBlockIt* bi, int matchCase )
+{
+    USeriesIter si;
+    MatchTable* mt;
+    MatchNode* nodes;
+    MatchEdge* edges;
+    TrieNode* trie;
+    int32_t* order;
+    int32_t* patStart;
+    uint16_t* pchars;
+    const UCell* it;
+    int patCount = 0;
+    int charCount = 0;
+    int nodeCount;
+    int maxLen = 0;
+    int len, i, c, n, t, q, e;
+
+
+    for( it = bi->it; it != bi->end; ++it )
+    {
+        if( ! ur_is(it, UT_STRING) )
+        {
+            ur_error( ut, UR_ERR_TYPE, "make matcher! expected string!" );
+            return 0;
+        }
+        len = (it->series.end > -1 ? it->series.end
+                                   : ur_bufferSer(it)->used) - it->series.it;
+        if( len < 1 )
+        {
+            ur_error( ut, UR_ERR_SCRIPT, "make matcher! pattern is empty" );
+            return 0;
+        }
+        if( maxLen < len )
+            maxLen = len;
+        charCount += len;
+        ++patCount;
+    }
+
+
+    // Build a linked trie with siblings sorted by character.
+
+    trie = (TrieNode*) memAlloc( sizeof(TrieNode) * (charCount + 1) );
+    trie[0].child = trie[0].sibling = -1;
+    trie[0].out = -1;
+    nodeCount = 1;
+
+    for( i = 0, it = bi->it; it != bi->end; ++it, ++i )
+    {
+        ur_seriesSlice( ut, &si, it );
+        n = 0;
+        for( ; si.it != si.end; ++si.it )
+        {
+            int32_t* link = &trie[n].child;
+
+            c = _patternChar( &si, si.it );
+            if( ! matchCase )
+                c = ur_charLowercase( c );
+            while( *link > -1 && trie[*link].c < c )
+                link = &trie[*link].sibling;
+            if( *link > -1 && trie[*link].c == c )
+            {
+                n = *link;
+                continue;
+            }
+            t = nodeCount++;
+            trie[t].child   = -1;
+            trie[t].sibling = *link;
+            trie[t].out     = -1;
+            trie[t].c       = c;
+            *link = n = t;
+        }
+        if( trie[n].out < 0 )
+            trie[n].out = i;    // Duplicates keep the first index.
+    }
+
+
+    mt = (MatchTable*) memAlloc( sizeof(MatchTable) +
+                                 sizeof(MatchNode) * nodeCount +
+                                 sizeof(MatchEdge) * (nodeCount - 1) +
+                                 sizeof(int32_t) * (patCount + 1) +
+                                 sizeof(uint16_t) * charCount );
+    memset( mt, 0, sizeof(MatchTable) );
+    mt->nodeCount = nodeCount;
+    mt->edgeCount = nodeCount - 1;
+    mt->patCount  = patCount;
+    mt->maxLen    = maxLen;
+    mt->matchCase = matchCase;
+
+    nodes = NODES(mt);
+    edges = EDGES(mt);
+
+
+    // Lay out the nodes in breadth-first order.  The position of a trie
+    // node in the queue is its final index.
+
+    order = (int32_t*) memAlloc( sizeof(int32_t) * nodeCount );
+    order[0] = 0;
+    n = 1;
+    e = 0;
+    for( q = 0; q < nodeCount; ++q )
+    {
+        t = order[q];
+        nodes[q].edge = e;
+        nodes[q].out  = trie[t].out;
+        for( t = trie[t].child; t > -1; t = trie[t].sibling )
+        {
+            edges[e].c     = trie[t].c;
+            edges[e]._pad  = 0;
+            edges[e].node  = n;
+            if( q == 0 && trie[t].c < 256 )
+                mt->root[ trie[t].c ] = n;
+            order[n++] = t;
+            ++e;
+        }
+        nodes[q].edgeCount = e - nodes[q].edge;
+    }
+    memFree( order );
+    memFree( trie );
+
+
+    // Fail links follow breadth-first order, so the fail node of a child
+    // is always resolved before the child.
+
+    nodes[0].fail = 0;
+    nodes[0].dict = 0;
+    for( q = 0; q < nodeCount; ++q )
+    {
+        const MatchEdge* eit = edges + nodes[q].edge;
+        const MatchEdge* eend = eit + nodes[q].edgeCount;
+        for( ; eit != eend; ++eit )
+        {
+            int f = 0;
+            if( q )
+            {
+                f = nodes[q].fail;
+                while( 1 )
+                {
+                    t = _matchGoto( mt, f, eit->c );
+                    if( t || ! f )
+                    {
+                        f = t;
+                        break;
+                    }
+                    f = nodes[f].fail;
+                }
+            }
+            n = eit->node;
+            nodes[n].fail = f;
+            nodes[n].dict = (nodes[f].out > -1) ? f : nodes[f].dict;
+        }
+    }
+
+
+    // Keep the original pattern characters.
+
+    patStart = PAT_START(mt);
+    pchars   = PAT_CHARS(mt);
+    len = 0;
+    for( i = 0, it = bi->it; it != bi->end; ++it, ++i )
+    {
+        patStart[i] = len;
+        ur_seriesSlice( ut, &si, it );
+        for( ; si.it != si.end; ++si.it )
+            pchars[ len++ ] = _patternChar( &si, si.it );
+    }
+    patStart[i] = len;
+
+    return mt;
+}
+
+
+/*
+  Return start of leftmost-longest match (or rightmost if last is set)
+  or -1 if no pattern is found.
+*/
+#define MATCH_SCAN(T) \
+static UIndex _matchScan_ ## T( const MatchTable* mt, const T* cp, \
+                                UIndex start, UIndex end, int last, \
+                                int* matchLen, int* matchPat ) { \
+    const MatchNode* nodes = NODES(mt); \
+    UIndex best = -1; \
+    UIndex pos; \
+    UIndex i; \
+    int fold = ! mt->matchCase; \
+    int bestPat = -1; \
+    int n = 0; \
+    int c, g, m; \
+    for( i = start; i < end; ++i ) { \
+        c = cp[i]; \
+        if( fold ) \
+            c = ur_charLowercase( c ); \
+        while( ! (g = _matchGoto( mt, n, c )) && n ) \
+            n = nodes[n].fail; \
+        n = g; \
+        if( n ) { \
+            m = (nodes[n].out > -1) ? n : nodes[n].dict; \
+            if( m ) { \
+                if( last ) { \
+                    while( nodes[m].dict ) \
+                        m = nodes[m].dict; \
+                } \
+                pos = i + 1 - PAT_LEN(mt, nodes[m].out); \
+                if( best < 0 || (last ? pos >= best : pos <= best) ) { \
+                    best = pos; \
+                    bestPat = nodes[m].out; \
+                } \
+            } \
+        } \
+        if( ! last && best > -1 && (i + 2 - mt->maxLen) > best ) \
+            break; \
+    } \
+    if( best > -1 ) { \
+        *matchLen = PAT_LEN(mt, bestPat); \
+        *matchPat = bestPat; \
+    } \
+    return best; \
+}
+
+MATCH_SCAN(uint8_t)
+MATCH_SCAN(uint16_t)
+
+
+/*
+  Return length of longest pattern matching at start or zero.
+*/
+#define MATCH_ANCHOR(T) \
+static int _matchAnchor_ ## T( const MatchTable* mt, const T* cp, \
+                               UIndex start, UIndex end ) { \
+    const MatchNode* nodes = NODES(mt); \
+    UIndex i; \
+    int fold = ! mt->matchCase; \
+    int bestLen = 0; \
+    int n = 0; \
+    int c; \
+    for( i = start; i < end; ++i ) { \
+        c = cp[i]; \
+        if( fold ) \
+            c = ur_charLowercase( c ); \
+        if( ! (n = _matchGoto( mt, n, c )) ) \
+            break; \
+        if( nodes[n].out > -1 ) \
+            bestLen = i + 1 - start; \
+    } \
+    return bestLen; \
+}
+
+MATCH_ANCHOR(uint8_t)
+MATCH_ANCHOR(uint16_t)
+
+
+#define ucs2Input(buf)  ((buf)->type != UT_BINARY && ur_strIsUcs2(buf))
+
+/**
+  Find the first occurrence of any matcher pattern in a string or binary.
+  If several patterns start at the same position the longest is used.
+
+  \param mat        Matcher buffer.
+  \param input      String or binary buffer.
+  \param start      Start index in input.
+  \param end        End index in input.
+  \param opt        UR_FIND_LAST to find the rightmost match.
+  \param matchLen   Set to the length of the match when found.
+  \param matchPat   Set to the (zero-based) pattern index when found.
+
+  \return Index of match in input or -1 if not found.
+*/
+UIndex ur_matcherFind( const UBuffer* mat, const UBuffer* input,
+                       UIndex start, UIndex end, int opt,
+                       int* matchLen, int* matchPat )
+{
+    const MatchTable* mt = (const MatchTable*) mat->ptr.v;
+    int last = opt & UR_FIND_LAST;
+    if( ucs2Input(input) )
+        return _matchScan_uint16_t( mt, input->ptr.u16, start, end,
+                                    last, matchLen, matchPat );
+    return _matchScan_uint8_t( mt, input->ptr.b, start, end,
+                               last, matchLen, matchPat );
+}
+
+
+/**
+  Match the longest matcher pattern at the start of a string or binary.
+
+  \param mat        Matcher buffer.
+  \param input      String or binary buffer.
+  \param start      Start index in input.
+  \param end        End index in input.
+
+  \return Length of matched pattern or zero if no pattern matches.
+*/
+int ur_matcherMatch( const UBuffer* mat, const UBuffer* input,
+                     UIndex start, UIndex end )
+{
+    const MatchTable* mt = (const MatchTable*) mat->ptr.v;
+    if( ucs2Input(input) )
+        return _matchAnchor_uint16_t( mt, input->ptr.u16, start, end );
+    return _matchAnchor_uint8_t( mt, input->ptr.b, start, end );
+}
+
+
+//----------------------------------------------------------------------------
+
+
+/*
+  The matcher! datatype is registered by the application (Boron adds it
+  after its own types), so the id is found in the datatype table.
+*/
+static int _matcherType( UThread* ut )
+{
+    const UDatatype** it  = ut->types;
+    const UDatatype** end = it + ur_datatypeCount( ut );
+    for( ; it != end; ++it )
+    {
+        if( *it == &dt_matcher )
+            break;
+    }
+    return it - ut->types;
+}
+
+
+/*
+  make matcher! ["foo" "bar"]
+  make matcher! [case "Foo" "Bar"]
+*/
+static int matcher_make( UThread* ut, const UCell* from, UCell* res )
+{
+    if( ur_is(from, UT_BLOCK) )
+    {
+        UBlockIt bi;
+        UBuffer* buf;
+        MatchTable* mt;
+        UIndex bufN;
+        int matchCase = 0;
+
+        ur_blockIt( ut, &bi, from );
+        if( bi.it != bi.end && ur_is(bi.it, UT_WORD) &&
+            ! strcmp( ur_wordCStr( bi.it ), "case" ) )
+        {
+            matchCase = 1;
+            ++bi.it;
+        }
+
+        mt = _buildMatcher( ut, &bi, matchCase );
+        if( ! mt )
+            return UR_THROW;
+
+        buf = ur_genBuffers( ut, 1, &bufN );    // gc!
+        buf->type  = _matcherType( ut );
+        buf->elemSize = 0;
+        buf->form  = 0;
+        buf->flags = 0;
+        buf->used  = mt->patCount;
+        buf->ptr.v = mt;
+
+        ur_setId( res, buf->type );
+        ur_setSeries( res, bufN, 0 );
+        return UR_OK;
+    }
+    return ur_error( ut, UR_ERR_TYPE, "make matcher! expected block!" );
+}
+
+
+static int matcher_compare( UThread* ut, const UCell* a, const UCell* b,
+                            int test )
+{
+    (void) ut;
+    switch( test )
+    {
+        case UR_COMPARE_SAME:
+        case UR_COMPARE_EQUAL:
+        case UR_COMPARE_EQUAL_CASE:
+            if( ur_type(a) == ur_type(b) )
+                return a->series.buf == b->series.buf;
+            break;
+    }
+    return 0;
+}
+
+
+/*
+  Integer selects a pattern.
+*/
+static const UCell* matcher_select( UThread* ut, const UCell* cell,
+                                    const UCell* sel, UCell* tmp )
+{
+    const MatchTable* mt = (const MatchTable*) ur_bufferSer(cell)->ptr.v;
+    int n;
+
+    if( ur_is(sel, UT_INT) )
+    {
+        n = ur_int(sel) - 1;
+        if( n >= 0 && n < mt->patCount )
+        {
+            const uint16_t* cp = PAT_CHARS(mt) + PAT_START(mt)[n];
+            int len = PAT_LEN(mt, n);
+            int enc = UR_ENC_LATIN1;
+            UBuffer* str;
+            int i;
+
+            for( i = 0; i < len; ++i )
+            {
+                if( cp[i] > 255 )
+                {
+                    enc = UR_ENC_UCS2;
+                    break;
+                }
+            }
+
+            str = ur_makeStringCell( ut, enc, len, tmp );   // gc!
+            if( enc == UR_ENC_UCS2 )
+                memcpy( str->ptr.u16, cp, len * sizeof(uint16_t) );
+            else
+                for( i = 0; i < len; ++i )
+                    str->ptr.b[ i ] = cp[i];
+            str->used = len;
+            return tmp;
+        }
+        ur_setId( tmp, UT_NONE );
+        return tmp;
+    }
+    ur_error( ut, UR_ERR_SCRIPT, "matcher select expected int!" );
+    return 0;
+}
+
+
+static void matcher_print( const MatchTable* mt, UBuffer* str )
+{
+    const uint16_t* pchars = PAT_CHARS(mt);
+    const int32_t* patStart = PAT_START(mt);
+    int i, j, c;
+
+    if( mt->matchCase )
+        ur_strAppendCStr( str, "case " );
+    for( i = 0; i < mt->patCount; ++i )
+    {
+        if( i )
+            ur_strAppendChar( str, ' ' );
+        ur_strAppendChar( str, '"' );
+        for( j = patStart[i]; j < patStart[i+1]; ++j )
+        {
+            c = pchars[j];
+            switch( c )
+            {
+                case '\t': ur_strAppendCStr( str, "^-" ); break;
+                case '\n': ur_strAppendCStr( str, "^/" ); break;
+                case '"':  ur_strAppendCStr( str, "^\"" ); break;
+                case '^':  ur_strAppendCStr( str, "^^" ); break;
+                default:   ur_strAppendChar( str, c ); break;
+            }
+        }
+        ur_strAppendChar( str, '"' );
+    }
+}
+
+
+static void matcher_toString( UThread* ut, const UCell* cell, UBuffer* str,
+                              int depth )
+{
+    (void) depth;
+    ur_strAppendCStr( str, "make matcher! [" );
+    matcher_print( (const MatchTable*) ur_bufferSer(cell)->ptr.v, str );
+    ur_strAppendChar( str, ']' );
+}
+
+
+static void matcher_toText( UThread* ut, const UCell* cell, UBuffer* str,
+                            int depth )
+{
+    (void) depth;
+    matcher_print( (const MatchTable*) ur_bufferSer(cell)->ptr.v, str );
+}
+
+
+static void matcher_destroy( UBuffer* buf )
+{
+    if( buf->ptr.v )
+    {
+        memFree( buf->ptr.v );
+        buf->ptr.v = 0;
+    }
+}
+
+
+extern void binary_mark( UThread* ut, UCell* cell );
+extern void binary_toShared( UCell* cell );
+
+UDatatype dt_matcher =
+{
+    "matcher!",
+    matcher_make,           matcher_make,           unset_copy,
+    matcher_compare,        unset_operate,          matcher_select,
+    matcher_toString,       matcher_toText,
+    unset_recycle,          binary_mark,            matcher_destroy,
+    unset_markBuf,          binary_toShared,        unset_bind
+};
+
+
+//EOF
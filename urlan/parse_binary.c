@@ -57,9 +57,13 @@ typedef struct
     uint8_t  exception;
     uint8_t  bigEndian;
     BitPipe  bp;
+    UAtom    atoms[2];      // records, slice
 }
 BinaryParser;
 
+#define ATOM_RECORDS    pe->atoms[0]
+#define ATOM_SLICE      pe->atoms[1]
+
 
 /*
   bitCount must be 1 to PIPE_BITS-8.
@@ -109,6 +113,472 @@ static uint64_t uintValue( const uint8_t* in, int bits, int bigEndian )
 }
 
 
+/*
+  Slice is only a keyword when followed by a word so that rules can still
+  be named slice.
+*/
+static int _isSliceWord( const BinaryParser* pe, const UCell* rit,
+                         const UCell* rend )
+{
+    ++rit;
+    return ur_atom(rit - 1) == ATOM_SLICE && rit != rend &&
+           ur_is(rit, UT_WORD) && ur_atom(rit) != UR_ATOM_BAR;
+}
+
+
+//----------------------------------------------------------------------------
+// Record layouts
+/*
+  The rule "records dest count layout" decodes count fixed size records into
+  a block of vector! columns, one for each field in the layout block.
+
+  The layout is compiled into a table of field offsets and then each column
+  is filled with a single strided loop over the input.  The byte swapping
+  in these loops is simple enough for the compiler to vectorize.
+*/
+
+
+#define RECORD_FIELD_MAX    64
+#define RECORD_DEPTH_MAX    8
+
+enum RecordFieldType
+{
+    RF_U8,
+    RF_I8,
+    RF_U16,
+    RF_I16,
+    RF_U32,
+    RF_I32,
+    RF_F32,
+    RF_F64,
+    RF_BITS
+};
+
+typedef struct
+{
+    uint32_t offset;        // Bit offset from start of record.
+    uint8_t  type;          // RecordFieldType
+    uint8_t  bits;
+    uint8_t  bigEndian;
+    uint8_t  form;          // UrlanVectorType of column.
+}
+RecordField;
+
+typedef struct
+{
+    RecordField field[ RECORD_FIELD_MAX ];
+    uint32_t fieldCount;
+    uint32_t bits;          // Size of record.
+    int bigEndian;
+}
+RecordLayout;
+
+
+static const uint8_t _recordTypeBits[] = { 8, 8, 16, 16, 32, 32, 32, 64 };
+
+static const uint8_t _recordTypeForm[] =
+{
+    UR_VEC_U16, UR_VEC_I16, UR_VEC_U16, UR_VEC_I16,
+    UR_VEC_U32, UR_VEC_I32, UR_VEC_F32, UR_VEC_F64
+};
+
+
+static UStatus _addRecordField( UThread* ut, RecordLayout* rl, int type,
+                                int bits )
+{
+    RecordField* rf;
+
+    if( rl->fieldCount == RECORD_FIELD_MAX )
+        return ur_error( PARSE_ERR, "records layout has over %d fields",
+                         RECORD_FIELD_MAX );
+    if( type != RF_BITS && (rl->bits & 7) )
+        return ur_error( PARSE_ERR, "records field is not byte aligned" );
+
+    rf = rl->field + rl->fieldCount++;
+    rf->offset    = rl->bits;
+    rf->type      = type;
+    rf->bits      = bits;
+    rf->bigEndian = rl->bigEndian;
+    if( type == RF_BITS )
+        rf->form = (bits > 16) ? UR_VEC_U32 : UR_VEC_U16;
+    else
+        rf->form = _recordTypeForm[ type ];
+    rl->bits += bits;
+    return UR_OK;
+}
+
+
+static UStatus _compileRecord( UThread* ut, RecordLayout* rl,
+                               const UCell* it, const UCell* end, int depth )
+{
+    const UCell* val;
+    UBlockIt bi;
+    int type;
+
+    if( depth > RECORD_DEPTH_MAX )
+        return ur_error( PARSE_ERR, "records layout nested too deeply" );
+
+    for( ; it != end; ++it )
+    {
+        switch( ur_type(it) )
+        {
+            case UT_INT:
+                if( ur_int(it) < 1 || ur_int(it) > 32 )
+                    return ur_error( PARSE_ERR,
+                                     "records bit-field size must be 1 to 32" );
+                if( ! _addRecordField( ut, rl, RF_BITS, ur_int(it) ) )
+                    return UR_THROW;
+                break;
+
+            case UT_WORD:
+                switch( ur_atom(it) )
+                {
+                    case UR_ATOM_U8:  type = RF_U8;  goto add_field;
+                    case UR_ATOM_I8:  type = RF_I8;  goto add_field;
+                    case UR_ATOM_U16: type = RF_U16; goto add_field;
+                    case UR_ATOM_I16: type = RF_I16; goto add_field;
+                    case UR_ATOM_U32: type = RF_U32; goto add_field;
+                    case UR_ATOM_I32: type = RF_I32; goto add_field;
+                    case UR_ATOM_F32: type = RF_F32; goto add_field;
+                    case UR_ATOM_F64: type = RF_F64;
+add_field:
+                        if( ! _addRecordField( ut, rl, type,
+                                               _recordTypeBits[ type ] ) )
+                            return UR_THROW;
+                        break;
+
+                    case UR_ATOM_U64:
+                        return ur_error( PARSE_ERR,
+                                         "records does not handle u64 fields" );
+
+                    case UR_ATOM_SKIP:
+                        // The interpreter skips whole input bytes, which
+                        // only matches the layout between byte fields.
+                        if( rl->bits & 7 )
+                            return ur_error( PARSE_ERR,
+                                        "records field is not byte aligned" );
+                        rl->bits += 8;
+                        break;
+
+                    case UR_ATOM_BIG_ENDIAN:
+                        rl->bigEndian = 1;
+                        break;
+
+                    case UR_ATOM_LITTLE_ENDIAN:
+                        rl->bigEndian = 0;
+                        break;
+
+                    default:
+                        if( ! (val = ur_wordCell( ut, it )) )
+                            return UR_THROW;
+                        if( ! ur_is(val, UT_BLOCK) )
+                            goto bad_value;
+                        ur_blockIt( ut, &bi, val );
+                        if( ! _compileRecord( ut, rl, bi.it, bi.end, depth+1 ) )
+                            return UR_THROW;
+                        break;
+                }
+                break;
+
+            case UT_BLOCK:
+                ur_blockIt( ut, &bi, it );
+                if( ! _compileRecord( ut, rl, bi.it, bi.end, depth + 1 ) )
+                    return UR_THROW;
+                break;
+
+            default:
+bad_value:
+                return ur_error( PARSE_ERR, "records layout does not handle %s",
+                                 ur_atomCStr( ut, ur_type(it) ) );
+        }
+    }
+    return UR_OK;
+}
+
+
+#ifdef __BIG_ENDIAN__
+#define HOST_BIG_ENDIAN 1
+#else
+#define HOST_BIG_ENDIAN 0
+#endif
+
+static inline uint16_t _swap16( uint16_t n )
+{
+    return (n >> 8) | (n << 8);
+}
+
+static inline uint32_t _swap32( uint32_t n )
+{
+    return (n >> 24) | ((n >> 8) & 0xff00) | ((n << 8) & 0xff0000) | (n << 24);
+}
+
+static inline uint64_t _swap64( uint64_t n )
+{
+    return ((uint64_t) _swap32( (uint32_t) n ) << 32) |
+           _swap32( (uint32_t) (n >> 32) );
+}
+
+
+/*
+  Fill column from count records of stride bytes.
+*/
+static void _decodeColumn( const RecordField* rf, const uint8_t* in,
+                           uint32_t stride, UIndex first, UIndex end,
+                           UBuffer* col )
+{
+    UIndex i;
+    int swap = (rf->bigEndian != HOST_BIG_ENDIAN);
+
+    in += rf->offset >> 3;
+
+    switch( rf->type )
+    {
+        case RF_U8:
+        {
+            uint16_t* out = col->ptr.u16;
+            for( i = first; i < end; ++i, in += stride )
+                out[i] = *in;
+        }
+            break;
+
+        case RF_I8:
+        {
+            int16_t* out = col->ptr.i16;
+            for( i = first; i < end; ++i, in += stride )
+                out[i] = (int8_t) *in;
+        }
+            break;
+
+        case RF_U16:
+        case RF_I16:
+        {
+            uint16_t* out = col->ptr.u16;
+            uint16_t n;
+            if( swap )
+            {
+                for( i = first; i < end; ++i, in += stride )
+                {
+                    memcpy( &n, in, 2 );
+                    out[i] = _swap16( n );
+                }
+            }
+            else
+            {
+                for( i = first; i < end; ++i, in += stride )
+                    memcpy( out + i, in, 2 );
+            }
+        }
+            break;
+
+        case RF_U32:
+        case RF_I32:
+        case RF_F32:
+        {
+            uint32_t* out = col->ptr.u32;
+            uint32_t n;
+            if( swap )
+            {
+                for( i = first; i < end; ++i, in += stride )
+                {
+                    memcpy( &n, in, 4 );
+                    out[i] = _swap32( n );
+                }
+            }
+            else
+            {
+                for( i = first; i < end; ++i, in += stride )
+                    memcpy( out + i, in, 4 );
+            }
+        }
+            break;
+
+        case RF_F64:
+        {
+            uint64_t* out = (uint64_t*) col->ptr.d;
+            uint64_t n;
+            if( swap )
+            {
+                for( i = first; i < end; ++i, in += stride )
+                {
+                    memcpy( &n, in, 8 );
+                    out[i] = _swap64( n );
+                }
+            }
+            else
+            {
+                for( i = first; i < end; ++i, in += stride )
+                    memcpy( out + i, in, 8 );
+            }
+        }
+            break;
+
+        case RF_BITS:
+        {
+            // Bit-fields are packed most significant bit first, as with
+            // pullBits().
+            int lead  = rf->offset & 7;
+            int bytes = (lead + rf->bits + 7) >> 3;
+            int shift = bytes * 8 - lead - rf->bits;
+            uint32_t mask = 0xffffffff >> (32 - rf->bits);
+            uint64_t n;
+            int b;
+
+            for( i = first; i < end; ++i, in += stride )
+            {
+                n = 0;
+                for( b = 0; b < bytes; ++b )
+                    n = (n << 8) | in[b];
+                n = (n >> shift) & mask;
+                if( rf->form == UR_VEC_U16 )
+                    col->ptr.u16[i] = n;
+                else
+                    col->ptr.u32[i] = n;
+            }
+        }
+            break;
+    }
+}
+
+
+/*
+  Parse the "records dest count layout" arguments at rit.
+
+  Returns rule following layout, or zero if the records do not fit in
+  the input or an error occured.
+*/
+static const UCell* _parseRecords( UThread* ut, BinaryParser* pe,
+                                   const UCell* rit, const UCell* rend,
+                                   UIndex* spos )
+{
+    RecordLayout rl;
+    RecordLayout rest;
+    UIndex bufN[ RECORD_FIELD_MAX + 1 ];
+    const UCell* dest;
+    const UCell* tval;
+    const UBuffer* ibin;
+    UBuffer* blk;
+    UCell* cell;
+    UBlockIt bi;
+    int64_t count;
+    UIndex avail;
+    uint32_t stride;
+    uint32_t i;
+
+    if( rit == rend || ! ur_is(rit, UT_WORD) )
+    {
+        ur_error( PARSE_ERR, "records expected word! destination" );
+        goto error;
+    }
+    dest = rit++;
+
+    if( rit == rend )
+        goto bad_count;
+    if( ur_is(rit, UT_WORD) && ur_atom(rit) == UR_ATOM_ANY )
+    {
+        count = -1;
+    }
+    else
+    {
+        tval = rit;
+        if( ur_is(tval, UT_WORD) && ! (tval = ur_wordCell( ut, tval )) )
+            goto error;
+        if( ! ur_is(tval, UT_INT) )
+            goto bad_count;
+        count = ur_int(tval);
+    }
+
+    if( ++rit == rend )
+        goto bad_layout;
+    tval = rit++;
+    if( ur_is(tval, UT_WORD) && ! (tval = ur_wordCell( ut, tval )) )
+        goto error;
+    if( ! ur_is(tval, UT_BLOCK) )
+        goto bad_layout;
+
+    rl.fieldCount = 0;
+    rl.bits = 0;
+    rl.bigEndian = pe->bigEndian;
+    ur_blockIt( ut, &bi, tval );
+    if( ! _compileRecord( ut, &rl, bi.it, bi.end, 0 ) )
+        goto error;
+    if( ! rl.bits || (rl.bits & 7) )
+    {
+        ur_error( PARSE_ERR, "records layout must be a whole number of bytes" );
+        goto error;
+    }
+
+    stride = rl.bits >> 3;
+    avail = pe->inputEnd - *spos;
+    if( avail < 0 )
+        avail = 0;
+    avail /= stride;
+    if( count < 0 )
+        count = avail;
+    else if( count > avail )
+        return 0;
+
+    // An endian switch in the layout carries into the following records,
+    // as it does when the layout rule is repeated.
+    rest.fieldCount = 0;
+    if( rl.bigEndian != pe->bigEndian && count > 1 )
+    {
+        rest.bits = 0;
+        rest.bigEndian = rl.bigEndian;
+        ur_blockIt( ut, &bi, tval );
+        if( ! _compileRecord( ut, &rest, bi.it, bi.end, 0 ) )
+            goto error;
+    }
+    pe->bigEndian = rl.bigEndian;
+
+    // Make all buffers at once so no recycle happens until the columns
+    // are held by the destination block.
+    ur_genBuffers( ut, rl.fieldCount + 1, bufN );
+    blk = ur_buffer( bufN[0] );
+    ur_blkInit( blk, UT_BLOCK, rl.fieldCount );
+    for( i = 0; i < rl.fieldCount; ++i )
+    {
+        UBuffer* col = ur_buffer( bufN[i + 1] );
+        ur_vecInit( col, rl.field[i].form, 0, count );
+        col->used = count;
+        cell = ur_blkAppendNew( blk, UT_VECTOR );
+        ur_setSeries( cell, bufN[i + 1], 0 );
+    }
+
+    if( ! (cell = ur_wordCellM( ut, dest )) )
+        goto error;
+    ur_initSeries( cell, UT_BLOCK, bufN[0] );
+
+    ibin = ur_buffer( pe->inputBufN );
+    for( i = 0; i < rl.fieldCount; ++i )
+    {
+        const uint8_t* in = ibin->ptr.b + *spos;
+        UBuffer* col = ur_buffer( bufN[i + 1] );
+        if( rest.fieldCount )
+        {
+            _decodeColumn( rl.field + i, in, stride, 0, 1, col );
+            _decodeColumn( rest.field + i, in + stride, stride, 1, count,
+                           col );
+        }
+        else
+        {
+            _decodeColumn( rl.field + i, in, stride, 0, count, col );
+        }
+    }
+    *spos += count * stride;
+    return rit;
+
+bad_count:
+    ur_error( PARSE_ERR, "records expected int! count" );
+    goto error;
+
+bad_layout:
+    ur_error( PARSE_ERR, "records expected block! layout" );
+error:
+    pe->exception = PARSE_EX_ERROR;
+    return 0;
+}
+
+
 #define CHECK_WORD(cell) \
     if( ! cell ) \
         goto parse_err;
@@ -280,9 +750,12 @@ uint_count:         // Count is number of bytes.
                             {
                                 UBuffer* cb;
                                 int size = ur_int(tval);
+                                if( size < 0 || size > inEnd - in )
+                                    goto failed;
                                 cb = ur_makeBinaryCell( ut, size, res );
                                 cb->used = size;
                                 memCpy( cb->ptr.b, in, size );
+                                ibin = ur_buffer( pe->inputBufN );
                                 in += size;
                                 break;
                             }
@@ -304,6 +777,64 @@ uint_count:         // Count is number of bytes.
                     break;
 
                 default:
+                    // Records & slice are not fixed atoms, so they are
+                    // looked up on first use.
+                    if( ATOM_SLICE == UR_INVALID_ATOM )
+                        ur_internAtoms( ut, "records slice", pe->atoms );
+
+                    if( ur_atom(rit) == ATOM_RECORDS )
+                    {
+                        UIndex pos = in - ibin->ptr.b;
+                        rit = _parseRecords( ut, pe, rit + 1, rend, &pos );
+                        if( ! rit )
+                        {
+                            if( pe->exception == PARSE_EX_ERROR )
+                                return 0;
+                            goto failed;
+                        }
+                        ibin  = ur_buffer( pe->inputBufN );
+                        in    = ibin->ptr.b + pos;
+                        inEnd = ibin->ptr.b + pe->inputEnd;
+                        break;
+                    }
+
+                    // slice  dest   size
+                    //        word!  int!/word!
+                    if( _isSliceWord( pe, rit, rend ) )
+                    {
+                        UIndex start;
+                        UCell* res;
+                        rit += 2;
+                        if( rit == rend )
+                        {
+                            ur_error( PARSE_ERR,
+                                      "slice expected word and value" );
+                            goto parse_err;
+                        }
+                        res = ur_wordCellM( ut, rit - 1 );
+                        CHECK_WORD(res);
+                        tval = rit++;
+                        if( ur_is(tval, UT_WORD) )
+                        {
+                            tval = ur_wordCell( ut, tval );
+                            CHECK_WORD(tval);
+                        }
+                        if( ur_is(tval, UT_INT) )
+                        {
+                            int size = ur_int(tval);
+                            if( size < 0 || size > inEnd - in )
+                                goto failed;
+                            start = in - ibin->ptr.b;
+                            ur_setId( res, UT_BINARY );
+                            ur_setSlice( res, pe->inputBufN, start,
+                                         start + size );
+                            in += size;
+                            break;
+                        }
+                        ur_error( PARSE_ERR, "slice expected int! count" );
+                        goto parse_err;
+                    }
+
                     tval = ur_wordCell( ut, rit );
                     CHECK_WORD(tval);
 
@@ -534,6 +1065,7 @@ UStatus ur_parseBinary( UThread* ut, UBuffer* bin, UIndex start, UIndex end,
     p.sliced    = (end != bin->used);
     p.exception = PARSE_EX_NONE;
     p.bigEndian = 0;
+    p.atoms[1]  = UR_INVALID_ATOM;
     p.bp.pipe = 0;
     p.bp.bitsFree = PIPE_BITS;
     //p.bp.byteCount = 0;
@@ -18,8 +18,13 @@
 */
 
 
+#include <string.h>
 #include "urlan.h"
 #include "urlan_atoms.h"
+#include "os.h"
+#include "i_parse_blk.c"
+#include "parse_memo.h"
+#include "parse_rule.h"
 
 
 enum BlockParseException
@@ -32,12 +37,33 @@ enum BlockParseException
 
 typedef struct
 {
+    UBlockParser bp;        // Compiled rule interpreter.
     UStatus (*eval)( UThread*, const UCell* );
     const UBuffer* blk;
     UIndex   inputBuf;
     UIndex   inputEnd;
     short    sliced;
     short    exception;
+
+    // Compiled rules.
+    struct BlockCall* calls;
+    struct BlockNest* nest;
+    UBuffer  table;         // BlockRule
+    UBuffer  snap;          // Copy of rule blocks to check for changes
+    UBuffer  bound;         // BlockBound
+
+    // Buffers used only while compiling.
+    UBuffer  bin;           // Program being compiled.
+    UBuffer  callBuf;       // BlockCall
+    UBuffer  nestBuf;       // BlockNest
+    UBuffer  atomBuf;       // UAtom
+    UBuffer  tsetBuf;       // 64-bit type masks
+    UBuffer  fixBuf;        // BlockFix
+    UBuffer  pending;       // BlockPending
+    int      lastCall;
+    int      outline;
+    UAtom    sliceAtom;
+    ParseMemo memo;         // Named rule results for parse/memo
 }
 BlockParser;
 
@@ -53,18 +79,52 @@ static const UBuffer* _acquireInput( UThread* ut, BlockParser* pe )
         // We have no way to track changes to the end of a slice,
         // so just make sure we remain in valid memery.
         if( iblk->used < pe->inputEnd )
+        {
             pe->inputEnd = iblk->used;
+            parseMemoInvalidate( &pe->memo );
+        }
     }
     else
     {
         // Not sliced, track input end.
         if( iblk->used != pe->inputEnd )
+        {
             pe->inputEnd = iblk->used;
+            parseMemoInvalidate( &pe->memo );
+        }
     }
     return iblk;
 }
 
 
+/*
+  Slice is not one of the fixed atoms, so its atom is looked up on first use.
+  It is only a keyword when followed by a word so that rules can still be
+  named slice.
+*/
+static int _isSliceWord( UThread* ut, BlockParser* pe, const UCell* rit,
+                         const UCell* rend )
+{
+    if( pe->sliceAtom == UR_INVALID_ATOM )
+        pe->sliceAtom = ur_intern( ut, "slice", 5 );
+    ++rit;
+    return ur_atom(rit - 1) == pe->sliceAtom && rit != rend &&
+           ur_is(rit, UT_WORD) && ur_atom(rit) != UR_ATOM_BAR;
+}
+
+
+static int _setSlice( UThread* ut, const BlockParser* pe, const UCell* word,
+                      UIndex start, UIndex end )
+{
+    UCell* cell = ur_wordCellM( ut, word );
+    if( ! cell )
+        return 0;
+    ur_setId( cell, UT_BLOCK );
+    ur_setSlice( cell, pe->inputBuf, start, end );
+    return 1;
+}
+
+
 #define BLK_RULE_ERROR(msg) \
     ur_error( ut, UR_ERR_SCRIPT, msg ); \
     goto parse_err
@@ -86,12 +146,22 @@ static const UCell* _parseBlock( UThread* ut, BlockParser* pe,
     UAtom atom;
     const UBuffer* iblk = pe->blk;
     UIndex pos = *spos;
+    const UCell* sliceWord = 0;
+    UIndex sliceStart = 0;
+    int slicePending = 0;
 
 
 match:
 
     while( rit != rend )
     {
+        // Set slice word after the value following it has matched.
+        if( slicePending && ! --slicePending )
+        {
+            if( ! _setSlice( ut, pe, sliceWord, sliceStart, pos ) )
+                goto parse_err;
+        }
+
         switch( ur_type(rit) )
         {
             case UT_WORD:
@@ -220,6 +290,8 @@ match:
                         {
                             BLK_RULE_ERROR( "parse into expected block" );
                         }
+                        if( pos >= pe->inputEnd )
+                            goto failed;
                         tval = iblk->ptr.cell + pos;
                         if( ! ur_is(tval, UT_BLOCK) )
                             goto failed;
@@ -236,6 +308,7 @@ match:
                         ip.inputEnd  = ip.blk->used;
                         ip.sliced    = 0;
                         ip.exception = PARSE_EX_NONE;
+                        ip.sliceAtom = pe->sliceAtom;
 
                         ur_blockIt( ut, &bi, rit );
 
@@ -301,6 +374,20 @@ skip:
                     //case UR_ATOM_COPY:
 
                     default:
+                        if( _isSliceWord( ut, pe, rit, rend ) )
+                        {
+                            rit += 2;
+                            if( rit == rend || (ur_is(rit, UT_WORD) &&
+                                ur_atom(rit) == UR_ATOM_BAR) )
+                            {
+                                BLK_RULE_ERROR(
+                                    "slice expected word and value" );
+                            }
+                            sliceWord = rit - 1;
+                            sliceStart = pos;
+                            slicePending = 2;
+                            break;
+                        }
                     {
                         tval = ur_wordCell( ut, rit );
                         CHECK_WORD( tval )
@@ -439,6 +526,11 @@ match_block:
 
 complete:
 
+    if( slicePending )
+    {
+        if( ! _setSlice( ut, pe, sliceWord, sliceStart, pos ) )
+            goto parse_err;
+    }
     *spos = pos;
     return rit;
 
@@ -561,6 +653,7 @@ failed:
         {
             ++rit;
             pos = *spos;
+            slicePending = 0;
             goto match;
         }
     }
@@ -573,6 +666,1166 @@ parse_err:
 }
 
 
+/*
+  Rules are compiled into ur_parseBlockI() programs when first used.
+  Nested blocks are put in the program of their parent unless that would
+  overflow the 8-bit offsets, in which case they are called as separate
+  rules.  Values which the bytecode does not handle (parens, set-words,
+  strings, etc.) are done through PB_Call.
+*/
+
+enum BlockCallOp
+{
+    CALL_WALK,      // Use _parseBlock on the rule cells.
+    CALL_RULE,      // Match block or word rule.
+    CALL_REPEAT,    // opt/any/some of block or word rule.
+    CALL_INTO,
+    CALL_PAREN,
+    CALL_SETWORD,
+    CALL_GETWORD,
+    CALL_SET        // Set word to current value.
+};
+
+enum BlockRuleState
+{
+    RULE_NEW,
+    RULE_COMPILED,
+    RULE_WALK       // Cannot be compiled.
+};
+
+typedef struct BlockCall
+{
+    const UCell* it;    // Rule cells.
+    const UCell* end;
+    int16_t op;
+    int16_t nest;       // Inlined block holding the rule cells, or -1.
+    int32_t rule;       // Index of rule last used.
+}
+BlockCall;
+
+typedef struct BlockNest
+{
+    UIndex  blkN;
+    int32_t parent;
+}
+BlockNest;
+
+typedef struct
+{
+    ParseRuleKey key;
+    int     state;
+    void*   mem;        // Holds calls, nest, atoms & program.
+    BlockCall* calls;
+    BlockNest* nest;
+    UAtom*  atoms;
+    uint8_t* prog;      // Typesets followed by instructions.
+    const uint8_t* pc;
+}
+BlockRule;
+
+typedef struct
+{
+    int32_t pos;        // Location of 8-bit offset in program.
+    int32_t value;      // Code offset or FIX_TYPESET with typeset index.
+}
+BlockFix;
+
+#define FIX_TYPESET     0x10000
+
+typedef struct
+{
+    const UCell* it;
+    const UCell* end;
+    int32_t fix;
+    int32_t nest;
+}
+BlockPending;
+
+typedef struct
+{
+    const UCell* word;  // Word in rule block.
+    UCell value;        // Value of word when compiled.
+}
+BlockBound;
+
+
+#define RULE(n)     (ur_ptr(BlockRule, &pe->table) + (n))
+#define IS_BAR(c)   (ur_is(c, UT_WORD) && (ur_atom(c) == UR_ATOM_BAR))
+
+
+/*
+  Get index of rule in the table, adding it if not present.
+  New rules are zeroed, which makes them RULE_NEW.
+*/
+#define _ruleIndex(ut,pe,blkCell,cache) \
+    parseRuleIndex(ut, &pe->table, &pe->snap, blkCell, cache, 0)
+
+
+/*
+  Add a block whose cells are compiled into the current program to the rule
+  table so that it is held & checked when the rules are reused.
+*/
+static void _useBlock( UThread* ut, BlockParser* pe, const UCell* blkCell )
+{
+    int32_t ri = -1;
+    _ruleIndex( ut, pe, blkCell, &ri );
+}
+
+
+static int _hasBreak( const UCell* it, const UCell* end )
+{
+    for( ; it != end; ++it )
+    {
+        if( ur_is(it, UT_WORD) && ur_atom(it) == UR_ATOM_BREAK )
+            return 1;
+    }
+    return 0;
+}
+
+
+static int _blockHasBreak( UThread* ut, const UCell* blkCell )
+{
+    UBlockIt bi;
+    ur_blockIt( ut, &bi, blkCell );
+    return _hasBreak( bi.it, bi.end );
+}
+
+
+static int _findBar( const UCell* it, const UCell* end )
+{
+    for( ; it != end; ++it )
+    {
+        if( IS_BAR(it) )
+            return 1;
+    }
+    return 0;
+}
+
+
+/*
+  Return value of word if it cannot change during the compile.
+  The value is recorded so that the program is not reused if it changes.
+*/
+static const UCell* _boundValue( UThread* ut, BlockParser* pe,
+                                 const UCell* word )
+{
+    UBuffer* buf = &pe->bound;
+    BlockBound* bb;
+    const UCell* cell;
+
+    switch( ur_binding(word) )
+    {
+        case UR_BIND_THREAD:
+        case UR_BIND_ENV:
+            cell = ur_wordCell( ut, word );
+            if( cell )
+            {
+                ur_arrExpand1( BlockBound, buf, bb );
+                bb->word  = word;
+                bb->value = *cell;
+            }
+            return cell;
+    }
+    return 0;
+}
+
+
+static void _emit2( BlockParser* pe, int op, int data )
+{
+    UBuffer* bin = &pe->bin;
+    ur_arrReserve( bin, bin->used + 2 );
+    bin->ptr.b[ bin->used++ ] = op;
+    if( data >= 0 )
+        bin->ptr.b[ bin->used++ ] = data;
+}
+
+#define _emit(pe,op)    _emit2(pe, op, -1)
+
+
+static void _emitFix( BlockParser* pe, int op, int32_t value )
+{
+    UBuffer* buf = &pe->fixBuf;
+    BlockFix* fix;
+
+    _emit2( pe, op, 0 );
+    ur_arrExpand1( BlockFix, buf, fix );
+    fix->pos   = pe->bin.used - 1;
+    fix->value = value;
+}
+
+
+/*
+  \return Number of rule cells used, or zero if the call table is full.
+*/
+static int _emitCall( BlockParser* pe, int op, const UCell* it, int count,
+                      int nest )
+{
+    UBuffer* buf = &pe->callBuf;
+    BlockCall* call;
+
+    // Join with the previous instruction if it walks the preceding cells.
+    if( op == CALL_WALK && pe->lastCall >= 0 &&
+        pe->lastCall == pe->bin.used - 2 &&
+        pe->bin.ptr.b[ pe->lastCall ] == PB_Call )
+    {
+        call = ur_ptr(BlockCall, buf) + pe->bin.ptr.b[ pe->lastCall + 1 ];
+        if( call->op == CALL_WALK && call->end == it && call->nest == nest )
+        {
+            call->end += count;
+            return count;
+        }
+    }
+
+    if( buf->used > 255 )
+        return 0;
+    ur_arrExpand1( BlockCall, buf, call );
+    call->it   = it;
+    call->end  = it + count;
+    call->op   = op;
+    call->nest = nest;
+    call->rule = -1;
+
+    pe->lastCall = pe->bin.used;
+    _emit2( pe, PB_Call, buf->used - 1 );
+    return count;
+}
+
+
+static int _atomIndex( BlockParser* pe, UAtom atom )
+{
+    UBuffer* buf = &pe->atomBuf;
+    UAtom* it  = ur_ptr(UAtom, buf);
+    UAtom* end = it + buf->used;
+
+    for( ; it != end; ++it )
+    {
+        if( *it == atom )
+            return it - ur_ptr(UAtom, buf);
+    }
+    if( buf->used > 255 )
+        return -1;
+    ur_arrExpand1( UAtom, buf, it );
+    *it = atom;
+    return buf->used - 1;
+}
+
+
+/*
+  Get the types matched by a block of datatype alternatives such as
+  [int! | double!].
+
+  \return Non-zero if block only holds datatype alternatives.
+*/
+static int _typeAlternatives( UThread* ut, const UCell* blkCell,
+                              uint32_t* mask )
+{
+    UBlockIt bi;
+    int type;
+
+    mask[0] = mask[1] = 0;
+    ur_blockIt( ut, &bi, blkCell );
+    if( bi.it == bi.end )
+        return 0;
+    while( 1 )
+    {
+        if( ur_is(bi.it, UT_WORD) && ur_atom(bi.it) < UT_BI_COUNT )
+        {
+            type = ur_atom(bi.it);
+            mask[ type >> 5 ] |= 1 << (type & 31);
+        }
+        else if( ur_is(bi.it, UT_DATATYPE) )
+        {
+            mask[0] |= bi.it->datatype.mask0;
+            mask[1] |= bi.it->datatype.mask1;
+        }
+        else
+            return 0;
+        if( ++bi.it == bi.end )
+            return 1;
+        if( ! IS_BAR(bi.it) || ++bi.it == bi.end )
+            return 0;
+    }
+}
+
+
+static void _emitTypeset( BlockParser* pe, int op, const uint32_t* types )
+{
+    UBuffer* buf = &pe->tsetBuf;
+    uint64_t* it;
+    uint8_t mask[8];
+    uint32_t m;
+    int i;
+
+    m = types[0];
+    for( i = 0; i < 4; ++i, m >>= 8 )
+        mask[i] = m & 0xff;
+    m = types[1];
+    for( ; i < 8; ++i, m >>= 8 )
+        mask[i] = m & 0xff;
+
+    for( i = 0; i < buf->used; ++i )
+    {
+        if( memcmp( buf->ptr.b + i*8, mask, 8 ) == 0 )
+            goto emit;
+    }
+    ur_arrExpand1( uint64_t, buf, it );
+    memcpy( it, mask, 8 );
+emit:
+    _emitFix( pe, op, FIX_TYPESET | i );
+}
+
+
+/*
+  Emit op to run block inlined in the current program.
+*/
+static void _emitInline( UThread* ut, BlockParser* pe, int op,
+                         const UCell* blkCell, int nest )
+{
+    UBlockIt bi;
+    UBuffer* buf;
+    BlockPending* pd;
+    BlockNest* bn;
+
+    ur_blockIt( ut, &bi, blkCell );
+    _useBlock( ut, pe, blkCell );
+    _emitFix( pe, op, 0 );
+
+    buf = &pe->nestBuf;
+    ur_arrExpand1( BlockNest, buf, bn );
+    bn->blkN   = blkCell->series.buf;
+    bn->parent = nest;
+
+    buf = &pe->pending;
+    ur_arrExpand1( BlockPending, buf, pd );
+    pd->it   = bi.it;
+    pd->end  = bi.end;
+    pd->fix  = pe->fixBuf.used - 1;
+    pd->nest = pe->nestBuf.used - 1;
+}
+
+
+/*
+  Return number of rule cells in the item at rit.
+*/
+static int _itemCells( UThread* ut, BlockParser* pe, const UCell* rit,
+                       const UCell* rend )
+{
+    const UCell* arg = rit + 1;
+
+    switch( ur_type(rit) )
+    {
+        case UT_WORD:
+            switch( ur_atom(rit) )
+            {
+                case UR_ATOM_OPT:
+                case UR_ATOM_ANY:
+                case UR_ATOM_SOME:
+                case UR_ATOM_TO:
+                case UR_ATOM_THRU:
+                case UR_ATOM_INTO:
+                case UR_ATOM_SET:
+                case UR_ATOM_PLACE:
+                    return 2;
+            }
+            if( _isSliceWord( ut, pe, rit, rend ) )
+            {
+                if( rend - arg < 2 || IS_BAR(arg + 1) )
+                    return 2;
+                return 2 + _itemCells( ut, pe, arg + 1, rend );
+            }
+            break;
+
+        case UT_INT:
+            if( arg != rend && ur_is(arg, UT_INT) )
+                return 3;
+            return 2;
+    }
+    return 1;
+}
+
+
+/*
+  Compile a single rule.
+
+  \return Number of rule cells used or zero if the program cannot be made.
+*/
+static int _compileItem( UThread* ut, BlockParser* pe, const UCell* rit,
+                         const UCell* rend, int nest )
+{
+    const UCell* arg = rit + 1;
+    const UCell* val;
+    uint32_t types[2];
+    int n = 1;
+    int op;
+
+    switch( ur_type(rit) )
+    {
+        case UT_WORD:
+            op = ur_atom(rit);
+            if( op < UT_BI_COUNT )
+            {
+                _emit2( pe, PB_Type, op );
+                return 1;
+            }
+            switch( op )
+            {
+                case UR_ATOM_OPT:
+                    op = PB_OptR;
+                    goto repeat;
+                case UR_ATOM_ANY:
+                    op = PB_AnyR;
+                    goto repeat;
+                case UR_ATOM_SOME:
+                    op = PB_SomeR;
+                    goto repeat;
+                case UR_ATOM_TO:
+                    op = PB_ToT;
+                    goto to_thru;
+                case UR_ATOM_THRU:
+                    op = PB_ThruT;
+                    goto to_thru;
+                case UR_ATOM_SKIP:
+                    _emit( pe, PB_Skip );
+                    return 1;
+                case UR_ATOM_INTO:
+                    if( arg != rend && ur_is(arg, UT_BLOCK) &&
+                        ! _blockHasBreak( ut, arg ) )
+                        return _emitCall( pe, CALL_INTO, rit, 2, nest );
+                    // Fall through...
+                case UR_ATOM_SET:
+                    // The following value is compiled separately.
+                    if( arg != rend && ur_is(arg, UT_WORD) )
+                        return _emitCall( pe, CALL_SET, rit, 2, nest );
+                    // Fall through...
+                case UR_ATOM_PLACE:
+                    n = 2;
+                    break;
+                default:
+                    if( _isSliceWord( ut, pe, rit, rend ) )
+                    {
+                        // The walker keeps the slice start.
+                        n = _itemCells( ut, pe, rit, rend );
+                        break;
+                    }
+                    return _emitCall( pe, CALL_RULE, rit, 1, nest );
+            }
+            break;
+
+        case UT_LITWORD:
+            op = _atomIndex( pe, ur_atom(rit) );
+            if( op >= 0 )
+            {
+                _emit2( pe, PB_Word, op );
+                return 1;
+            }
+            break;
+
+        case UT_SETWORD:
+            return _emitCall( pe, CALL_SETWORD, rit, 1, nest );
+
+        case UT_GETWORD:
+            return _emitCall( pe, CALL_GETWORD, rit, 1, nest );
+
+        case UT_INT:
+            n = (arg != rend && ur_is(arg, UT_INT)) ? 3 : 2;
+            break;
+
+        case UT_DATATYPE:
+            types[0] = rit->datatype.mask0;
+            types[1] = rit->datatype.mask1;
+            _emitTypeset( pe, PB_Typeset, types );
+            return 1;
+
+        case UT_BLOCK:
+            if( _typeAlternatives( ut, rit, types ) )
+            {
+                _useBlock( ut, pe, rit );
+                _emitTypeset( pe, PB_Typeset, types );
+                return 1;
+            }
+            if( _blockHasBreak( ut, rit ) )
+                break;
+            if( pe->outline )
+                return _emitCall( pe, CALL_RULE, rit, 1, nest );
+            _emitInline( ut, pe, PB_Rule, rit, nest );
+            return 1;
+
+        case UT_PAREN:
+            return _emitCall( pe, CALL_PAREN, rit, 1, nest );
+    }
+
+walk:
+    if( n > rend - rit )
+        n = rend - rit;
+    return _emitCall( pe, CALL_WALK, rit, n, nest );
+
+repeat:
+    if( arg == rend )
+        goto walk;
+    n = 2;
+    switch( ur_type(arg) )
+    {
+        case UT_WORD:
+            if( ur_atom(arg) < UT_BI_COUNT )
+            {
+                // _parseBlock uses the value of the datatype word.
+                val = _boundValue( ut, pe, arg );
+                if( val && ur_is(val, UT_DATATYPE) &&
+                    ur_datatype(val) == ur_atom(arg) )
+                {
+                    _emit2( pe, op + 1, ur_atom(arg) );
+                    return 2;
+                }
+                goto walk;
+            }
+            return _emitCall( pe, CALL_REPEAT, rit, 2, nest );
+
+        case UT_DATATYPE:
+            _emit2( pe, op + 1, ur_datatype(arg) );
+            return 2;
+
+        case UT_BLOCK:
+            if( _typeAlternatives( ut, arg, types ) )
+            {
+                _useBlock( ut, pe, arg );
+                _emitTypeset( pe, op + 2, types );
+                return 2;
+            }
+            if( _blockHasBreak( ut, arg ) )
+                break;
+            if( pe->outline )
+                return _emitCall( pe, CALL_REPEAT, rit, 2, nest );
+            _emitInline( ut, pe, op, arg, nest );
+            return 2;
+    }
+    goto walk;
+
+to_thru:
+    n = 2;
+    if( arg != rend && ur_is(arg, UT_WORD) && ur_atom(arg) < UT_BI_COUNT )
+    {
+        _emit2( pe, op, ur_atom(arg) );
+        return 2;
+    }
+    goto walk;
+}
+
+
+static int _compileBlock( UThread* ut, BlockParser* pe, const UCell* rit,
+                          const UCell* rend, int nest )
+{
+    int nextPos = -1;
+    int n;
+
+    if( _findBar( rit, rend ) )
+    {
+        _emit2( pe, PB_Next, 0 );
+        nextPos = pe->bin.used - 1;
+    }
+
+    while( rit != rend )
+    {
+        if( IS_BAR(rit) )
+        {
+            _emit( pe, PB_End );
+            n = pe->bin.used - (nextPos + 1);
+            if( n > 255 )
+                return 0;
+            pe->bin.ptr.b[ nextPos ] = n;
+
+            if( _findBar( ++rit, rend ) )
+            {
+                _emit2( pe, PB_Next, 0 );
+                nextPos = pe->bin.used - 1;
+            }
+        }
+        else
+        {
+            n = _compileItem( ut, pe, rit, rend, nest );
+            if( ! n )
+                return 0;
+            rit += n;
+        }
+    }
+    _emit( pe, PB_End );
+    return 1;
+}
+
+
+/*
+  Compile rule & any nested blocks into pe->bin.
+
+  \param outline    If non-zero then nested blocks are not inlined.
+
+  \return Non-zero if successful.
+*/
+static int _compileProg( UThread* ut, BlockParser* pe, int ruleN,
+                         int outline )
+{
+    const BlockPending* pd;
+    BlockFix* fix;
+    BlockFix* fend;
+    UIndex i;
+    int tsize;
+
+    pe->bin.used     = 0;
+    pe->callBuf.used = 0;
+    pe->nestBuf.used = 0;
+    pe->atomBuf.used = 0;
+    pe->tsetBuf.used = 0;
+    pe->fixBuf.used  = 0;
+    pe->pending.used = 0;
+    pe->lastCall = -1;
+    pe->outline  = outline;
+
+    if( ! _compileBlock( ut, pe, RULE(ruleN)->key.it, RULE(ruleN)->key.end,
+                         -1 ) )
+        return 0;
+
+    for( i = 0; i < pe->pending.used; ++i )
+    {
+        pd = ur_ptr(BlockPending, &pe->pending) + i;
+        ur_ptr(BlockFix, &pe->fixBuf)[ pd->fix ].value = pe->bin.used;
+        if( ! _compileBlock( ut, pe, pd->it, pd->end, pd->nest ) )
+            return 0;
+    }
+
+    // Typesets are placed before the instructions.
+    tsize = pe->tsetBuf.used * 8;
+    fix  = ur_ptr(BlockFix, &pe->fixBuf);
+    fend = fix + pe->fixBuf.used;
+    for( ; fix != fend; ++fix )
+    {
+        if( fix->value & FIX_TYPESET )
+            i = (fix->value & 0xffff) * 8;
+        else
+            i = fix->value + tsize;
+        if( i > 255 )
+            return 0;
+        pe->bin.ptr.b[ fix->pos ] = i;
+    }
+    return 1;
+}
+
+
+/*
+  \return Non-zero if rule is compiled.
+*/
+static int _compileRule( UThread* ut, BlockParser* pe, int ruleN )
+{
+    BlockRule* rule = RULE(ruleN);
+    uint8_t* mem;
+    size_t callSize, nestSize, atomSize, tsize;
+
+    if( rule->state != RULE_NEW )
+        return rule->state == RULE_COMPILED;
+
+    rule->state = RULE_WALK;
+    if( _hasBreak( rule->key.it, rule->key.end ) )
+        return 0;
+
+    ur_arrInit( &pe->bin,     1, 0 );
+    ur_arrInit( &pe->callBuf, sizeof(BlockCall), 0 );
+    ur_arrInit( &pe->nestBuf, sizeof(BlockNest), 0 );
+    ur_arrInit( &pe->atomBuf, sizeof(UAtom), 0 );
+    ur_arrInit( &pe->tsetBuf, 8, 0 );
+    ur_arrInit( &pe->fixBuf,  sizeof(BlockFix), 0 );
+    ur_arrInit( &pe->pending, sizeof(BlockPending), 0 );
+
+    if( ! _compileProg( ut, pe, ruleN, 0 ) &&
+        ! _compileProg( ut, pe, ruleN, 1 ) )
+        goto cleanup;
+
+    // The table may have grown while compiling.
+    rule = RULE(ruleN);
+
+    callSize = pe->callBuf.used * sizeof(BlockCall);
+    nestSize = pe->nestBuf.used * sizeof(BlockNest);
+    atomSize = pe->atomBuf.used * sizeof(UAtom);
+    tsize    = pe->tsetBuf.used * 8;
+
+    rule->mem = mem = (uint8_t*) memAlloc( callSize + nestSize + atomSize +
+                                           tsize + pe->bin.used );
+    // The ptr of an unused buffer is null, which memcpy must not be given.
+#define COPY_BUF(buf,size) \
+    if( size ) \
+        memcpy( mem, buf.ptr.v, size ); \
+    mem += size
+
+    rule->calls = (BlockCall*) mem;
+    COPY_BUF( pe->callBuf, callSize );
+    rule->nest = (BlockNest*) mem;
+    COPY_BUF( pe->nestBuf, nestSize );
+    rule->atoms = (UAtom*) mem;
+    COPY_BUF( pe->atomBuf, atomSize );
+    rule->prog = mem;
+    COPY_BUF( pe->tsetBuf, tsize );
+    rule->pc = mem;
+    memcpy( mem, pe->bin.ptr.v, pe->bin.used );
+
+    rule->state = RULE_COMPILED;
+
+cleanup:
+    ur_arrFree( &pe->bin );
+    ur_arrFree( &pe->callBuf );
+    ur_arrFree( &pe->nestBuf );
+    ur_arrFree( &pe->atomBuf );
+    ur_arrFree( &pe->tsetBuf );
+    ur_arrFree( &pe->fixBuf );
+    ur_arrFree( &pe->pending );
+    return RULE(ruleN)->state == RULE_COMPILED;
+}
+
+
+static int _runRule( BlockParser* pe, int ruleN, const UCell* it )
+{
+    UBlockParser* par = &pe->bp;
+    const BlockRule* rule = RULE(ruleN);
+    const uint8_t* rules = par->rules;
+    const UAtom* atoms   = par->atoms;
+    BlockCall* calls     = pe->calls;
+    BlockNest* nest      = pe->nest;
+    int ok;
+
+    par->rules = rule->prog;
+    par->atoms = rule->atoms;
+    pe->calls  = rule->calls;
+    pe->nest   = rule->nest;
+
+    ok = ur_parseBlockI( par, rule->pc, it );
+
+    par->rules = rules;
+    par->atoms = atoms;
+    pe->calls  = calls;
+    pe->nest   = nest;
+
+    return ok && ! pe->exception;
+}
+
+
+/*
+  Run a named rule at input position pos, using the memo table if it is
+  enabled.  On success par->it is set to the end of the match.
+*/
+static int _runNamed( BlockParser* pe, int ruleN, UIndex pos )
+{
+    UBlockParser* par = &pe->bp;
+    const ParseMemoSlot* slot;
+    int32_t gen;
+    int ok;
+
+    if( ! pe->memo.slots )
+        return _runRule( pe, ruleN, par->base + pos );
+
+    slot = parseMemoLookup( &pe->memo, ruleN, pe->inputBuf, pos );
+    if( slot )
+    {
+        if( slot->end == PARSE_MEMO_FAIL )
+            return 0;
+        par->it = par->base + slot->end;
+        return 1;
+    }
+
+    gen = pe->memo.gen;
+    ok = _runRule( pe, ruleN, par->base + pos );
+    if( ! pe->exception && gen == pe->memo.gen )
+        parseMemoStore( &pe->memo, ruleN, pe->inputBuf, pos,
+                        ok ? par->it - par->base : PARSE_MEMO_FAIL );
+    return ok;
+}
+
+
+/*
+  Get input start for the interpreter.  An empty block may have no memory,
+  but PB_Call needs a non-zero pointer to signal a match.
+*/
+static const UCell* _inputBase( const BlockParser* pe )
+{
+    static const UCell emptyInput;
+    const UCell* base = pe->blk->ptr.cell;
+    return base ? base : &emptyInput;
+}
+
+
+/*
+  PB_Call handler.
+*/
+static const UCell* _callRule( UBlockParser* par, int n, const UCell* it )
+{
+    BlockParser* pe = (BlockParser*) par;
+    UThread* ut = par->ut;
+    BlockCall* call = pe->calls + n;
+    const UCell* tval;
+    UCell* cell;
+    UIndex pos;
+    UIndex rblkN = 0;
+    int32_t count;
+    int32_t repMin;
+    int32_t repMax;
+    int named = 0;
+
+    if( pe->exception )
+        return 0;
+    pos = it - par->base;
+
+    switch( call->op )
+    {
+        case CALL_PAREN:
+            if( UR_OK != pe->eval( ut, call->it ) )
+                goto error;
+            _acquireInput( ut, pe );
+            goto sync;
+
+        case CALL_SETWORD:
+            if( ! (cell = ur_wordCellM( ut, call->it )) )
+                goto error;
+            ur_setId( cell, UT_BLOCK );
+            ur_setSlice( cell, pe->inputBuf, pos, pe->inputEnd );
+            return it;
+
+        case CALL_GETWORD:
+            if( ! (cell = ur_wordCellM( ut, call->it )) )
+                goto error;
+            if( ur_is(cell, UT_BLOCK) && (cell->series.buf == pe->inputBuf) )
+                cell->series.end = pos;
+            return it;
+
+        case CALL_SET:
+            if( pos >= pe->inputEnd )
+                return 0;
+            if( ! (cell = ur_wordCellM( ut, call->it + 1 )) )
+                goto error;
+            *cell = *it;
+            return it;
+
+        case CALL_INTO:
+            if( pos >= pe->inputEnd )
+                return 0;
+            if( ! ur_is(it, UT_BLOCK) || ur_isShared( it->series.buf ) )
+                return 0;
+            // Rule blocks cannot change so a literal block is only
+            // looked up once.
+            n = call->rule;
+            if( n < 0 )
+                n = _ruleIndex( ut, pe, call->it + 1, &call->rule );
+            if( ! _compileRule( ut, pe, n ) )
+                break;
+        {
+            const UBuffer* blk = pe->blk;
+            UIndex inputBuf = pe->inputBuf;
+            UIndex inputEnd = pe->inputEnd;
+            short sliced    = pe->sliced;
+
+            pe->blk      = ur_bufferSer( it );
+            pe->inputBuf = it->series.buf;
+            pe->inputEnd = pe->blk->used;
+            pe->sliced   = 0;
+            par->base = _inputBase( pe );
+            par->end  = par->base + pe->inputEnd;
+
+            count = _runRule( pe, n, par->base );
+
+            pe->blk      = blk;
+            pe->inputBuf = inputBuf;
+            pe->inputEnd = inputEnd;
+            pe->sliced   = sliced;
+            _acquireInput( ut, pe );
+        }
+            if( ! count )
+            {
+                if( pe->exception )
+                {
+                    rblkN = call->it[1].series.buf;
+                    goto trace_rule;
+                }
+                par->base = _inputBase( pe );
+                par->end  = par->base + pe->inputEnd;
+                return 0;
+            }
+            ++pos;
+            goto sync;
+
+        case CALL_RULE:
+        case CALL_REPEAT:
+            tval = call->it;
+            if( call->op == CALL_REPEAT )
+                ++tval;
+            if( ur_is(tval, UT_WORD) )
+            {
+                if( ! (tval = ur_wordCell( ut, tval )) )
+                    goto error;
+                if( ! ur_is(tval, UT_BLOCK) )
+                    break;
+                n = _ruleIndex( ut, pe, tval, &call->rule );
+                named = 1;
+            }
+            else
+            {
+                n = call->rule;
+                if( n < 0 )
+                    n = _ruleIndex( ut, pe, tval, &call->rule );
+            }
+            rblkN = tval->series.buf;
+            if( ! _compileRule( ut, pe, n ) )
+                break;
+
+            if( call->op == CALL_RULE )
+            {
+                if( named ? _runNamed( pe, n, pos ) : _runRule( pe, n, it ) )
+                    return par->it;
+                if( pe->exception )
+                    goto trace_rule;
+                return 0;
+            }
+
+            switch( ur_atom(call->it) )
+            {
+                case UR_ATOM_OPT:
+                    repMin = 0;
+                    repMax = 1;
+                    break;
+                case UR_ATOM_SOME:
+                    repMin = 1;
+                    repMax = 0x7fffffff;
+                    break;
+                default:
+                    repMin = 0;
+                    repMax = 0x7fffffff;
+                    break;
+            }
+            for( count = 0; count < repMax; ++count )
+            {
+                if( pos >= pe->inputEnd )
+                    break;
+                if( ! (named ? _runNamed( pe, n, pos )
+                             : _runRule( pe, n, par->base + pos )) )
+                {
+                    if( pe->exception )
+                        goto trace_rule;
+                    break;
+                }
+                pos = par->it - par->base;
+            }
+            if( count < repMin )
+                return 0;
+            return par->base + pos;
+    }
+
+    // CALL_WALK or a rule which cannot be compiled.
+    tval = _parseBlock( ut, pe, call->it, call->end, &pos );
+    if( ! tval )
+    {
+        if( pe->exception == PARSE_EX_ERROR )
+            goto error;
+        par->base = _inputBase( pe );
+        par->end  = par->base + pe->inputEnd;
+        return 0;
+    }
+
+sync:
+    par->base = _inputBase( pe );
+    par->end  = par->base + pe->inputEnd;
+    return par->base + pos;
+
+trace_rule:
+    ur_appendTrace( ut, rblkN, 0 );
+error:
+    for( n = call->nest; n >= 0; n = pe->nest[ n ].parent )
+        ur_appendTrace( ut, pe->nest[ n ].blkN, 0 );
+    pe->exception = PARSE_EX_ERROR;
+    par->base = _inputBase( pe );
+    par->end  = par->base;
+    return 0;
+}
+
+
+//----------------------------------------------------------------------------
+// Compiled rule cache
+/*
+  As with string parsing, the compiled rules are kept for each thread and
+  reused when the same rule block is parsed again.  Before reuse all the
+  blocks in the rule table are compared with the copies made when they were
+  added, and the values of any words used by the compiler are checked.
+*/
+
+
+#define BLOCK_CACHE_SLOTS   4
+
+typedef struct
+{
+    UIndex   blkN;          // Top rule block or UR_INVALID_BUF if unused.
+    UBuffer  table;
+    UBuffer  snap;
+    UBuffer  bound;
+}
+BlockCacheSlot;
+
+typedef struct
+{
+    BlockCacheSlot slot[ BLOCK_CACHE_SLOTS ];
+    int next;               // Slot to replace when all are used.
+}
+BlockCache;
+
+
+static void _rulesFree( UThread* ut, BlockParser* pe )
+{
+    const BlockRule* rule = RULE(0);
+    const BlockRule* end  = rule + pe->table.used;
+    for( ; rule != end; ++rule )
+    {
+        if( rule->mem )
+            memFree( rule->mem );
+    }
+    parseRuleRelease( ut, &pe->table );
+    ur_arrFree( &pe->table );
+    ur_arrFree( &pe->snap );
+    ur_arrFree( &pe->bound );
+}
+
+
+/*
+  \return Non-zero if the compiled rules are still valid.
+*/
+static int _rulesUnchanged( UThread* ut, const BlockParser* pe )
+{
+    const BlockRule* rule = RULE(0);
+    const BlockRule* rend = rule + pe->table.used;
+    const BlockBound* bb  = ur_ptr(BlockBound, &pe->bound);
+    const BlockBound* bend = bb + pe->bound.used;
+    const UCell* cell;
+
+    for( ; rule != rend; ++rule )
+    {
+        if( ! parseRuleUnchanged( ut, &pe->snap, &rule->key ) )
+            return 0;
+    }
+    for( ; bb != bend; ++bb )
+    {
+        cell = ur_wordCell( ut, bb->word );
+        if( ! cell || memcmp( cell, &bb->value, sizeof(UCell) ) )
+            return 0;
+    }
+    return 1;
+}
+
+
+/*
+  Move compiled rules for blkN from the cache to the parser.
+  The slot is left empty while in use so that a nested parse with the same
+  rules does not share it.
+
+  \return Non-zero if found.
+*/
+static int _cacheTake( UThread* ut, BlockParser* pe, UIndex blkN )
+{
+    BlockCache* cache = (BlockCache*) ut->parseBlockCache;
+    BlockCacheSlot* sl;
+    BlockCacheSlot* send;
+
+    if( ! cache )
+        return 0;
+    sl   = cache->slot;
+    send = sl + BLOCK_CACHE_SLOTS;
+    for( ; sl != send; ++sl )
+    {
+        if( sl->blkN == blkN )
+            goto found;
+    }
+    return 0;
+
+found:
+    pe->table = sl->table;
+    pe->snap  = sl->snap;
+    pe->bound = sl->bound;
+    sl->blkN = UR_INVALID_BUF;
+
+    if( ! _rulesUnchanged( ut, pe ) )
+    {
+        _rulesFree( ut, pe );
+        return 0;
+    }
+    return 1;
+}
+
+
+static void _cacheFreeSlot( UThread* ut, BlockCacheSlot* sl )
+{
+    BlockParser p;
+    if( sl->blkN != UR_INVALID_BUF )
+    {
+        p.table = sl->table;
+        p.snap  = sl->snap;
+        p.bound = sl->bound;
+        _rulesFree( ut, &p );
+        sl->blkN = UR_INVALID_BUF;
+    }
+}
+
+
+static void _cachePut( UThread* ut, BlockParser* pe, UIndex blkN )
+{
+    BlockCache* cache = (BlockCache*) ut->parseBlockCache;
+    BlockCacheSlot* sl;
+    int i;
+
+    if( ! cache )
+    {
+        cache = (BlockCache*) memAlloc( sizeof(BlockCache) );
+        for( i = 0; i < BLOCK_CACHE_SLOTS; ++i )
+            cache->slot[ i ].blkN = UR_INVALID_BUF;
+        cache->next = 0;
+        ut->parseBlockCache = cache;
+    }
+
+    // Replace any other copy of these rules (from a nested parse), or use
+    // an empty slot if possible.
+    for( i = 0; i < BLOCK_CACHE_SLOTS; ++i )
+    {
+        if( cache->slot[ i ].blkN == blkN )
+            break;
+    }
+    if( i == BLOCK_CACHE_SLOTS )
+    {
+        for( i = 0; i < BLOCK_CACHE_SLOTS; ++i )
+        {
+            if( cache->slot[ i ].blkN == UR_INVALID_BUF )
+                break;
+        }
+    }
+    if( i == BLOCK_CACHE_SLOTS )
+    {
+        i = cache->next;
+        cache->next = (i + 1) % BLOCK_CACHE_SLOTS;
+    }
+
+    sl = cache->slot + i;
+    _cacheFreeSlot( ut, sl );
+    sl->table = pe->table;
+    sl->snap  = pe->snap;
+    sl->bound = pe->bound;
+    sl->blkN  = blkN;
+}
+
+
+/*
+  Free the compiled rule cache of a thread.  This must be called before the
+  thread data store is frozen or destroyed.
+*/
+void ur_parseBlockFreeCache( UThread* ut )
+{
+    BlockCache* cache = (BlockCache*) ut->parseBlockCache;
+    int i;
+    if( cache )
+    {
+        for( i = 0; i < BLOCK_CACHE_SLOTS; ++i )
+            _cacheFreeSlot( ut, cache->slot + i );
+        memFree( cache );
+        ut->parseBlockCache = 0;
+    }
+}
+
+
 /**
   \ingroup urlan_dsl
 
@@ -586,14 +1839,16 @@ parse_err:
                     and remain unchanged during the parsing.
   \param eval       Evaluator callback to do paren values in rule.
                     The callback must return UR_OK/UR_THROW.
+  \param opt        Zero or UR_PARSE_MEMO to memoize named sub-rules.
 
   \return UR_OK or UR_THROW.
 */
 UStatus ur_parseBlock( UThread* ut, UBuffer* blk, UIndex start, UIndex end,
                        UIndex* parsePos, const UBuffer* ruleBlk,
-                       UStatus (*eval)(UThread*, const UCell*) )
+                       UStatus (*eval)(UThread*, const UCell*), int opt )
 {
     BlockParser p;
+    UIndex blkN;
 
     p.eval = eval;
     p.blk  = blk;
@@ -601,10 +1856,65 @@ UStatus ur_parseBlock( UThread* ut, UBuffer* blk, UIndex start, UIndex end,
     p.inputEnd  = end;
     p.sliced    = (end != blk->used);
     p.exception = PARSE_EX_NONE;
+    p.sliceAtom = UR_INVALID_ATOM;
+
+    p.calls = 0;
+    p.nest  = 0;
+    parseMemoInit( &p.memo, opt & UR_PARSE_MEMO );
+
+    // Only rules in thread storage are cached.
+    blkN = ruleBlk - ut->dataStore.ptr.buf;
+    if( blkN <= 0 || blkN >= ut->dataStore.used )
+        blkN = UR_INVALID_BUF;
+
+    if( blkN == UR_INVALID_BUF || ! _cacheTake( ut, &p, blkN ) )
+    {
+        UBuffer* table = &p.table;
+        BlockRule* rule;
+
+        ur_arrInit( table, sizeof(BlockRule), 0 );
+        ur_arrInit( &p.snap, 1, 0 );
+        ur_arrInit( &p.bound, sizeof(BlockBound), 0 );
+
+        ur_arrExpand1( BlockRule, table, rule );
+        parseRuleRoot( &rule->key, ruleBlk, blkN );
+        rule->state = RULE_NEW;
+        rule->mem   = 0;
+        if( blkN != UR_INVALID_BUF )
+        {
+            rule->key.hold = ur_hold( blkN );
+            parseRuleSnap( ut, &p.snap, &rule->key );
+        }
+    }
 
     *parsePos = start;
-    _parseBlock( ut, &p, ruleBlk->ptr.cell,
-                         ruleBlk->ptr.cell + ruleBlk->used, parsePos );
+    if( _compileRule( ut, &p, 0 ) )
+    {
+        p.bp.ut     = ut;
+        p.bp.rules  = 0;
+        p.bp.atoms  = 0;
+        p.bp.report = 0;
+        p.bp.rflag  = 0;
+        p.bp.base   = _inputBase( &p );
+        p.bp.end    = p.bp.base + end;
+        p.bp.call   = _callRule;
+
+        if( _runRule( &p, 0, p.bp.base + start ) )
+            *parsePos = p.bp.it - p.bp.base;
+    }
+    else
+    {
+        _parseBlock( ut, &p, ruleBlk->ptr.cell,
+                             ruleBlk->ptr.cell + ruleBlk->used, parsePos );
+    }
+
+    // Keep the compiled rules for the next parse unless there was an error.
+    if( blkN == UR_INVALID_BUF || p.exception == PARSE_EX_ERROR )
+        _rulesFree( ut, &p );
+    else
+        _cachePut( ut, &p, blkN );
+    parseMemoFree( &p.memo );
+
     return (p.exception == PARSE_EX_ERROR) ? UR_THROW : UR_OK;
 }
 
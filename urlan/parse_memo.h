@@ -0,0 +1,107 @@
+#ifndef PARSE_MEMO_H
+#define PARSE_MEMO_H
+/*
+  Memo table for parse/memo
+
+  The result of a named sub-rule at an input position is recorded so that
+  backtracking alternatives which retry the rule at the same position do not
+  parse it again.  The table is direct-mapped with a fixed number of slots;
+  a new result simply replaces whatever was in its slot.
+
+  All entries are invalidated by incrementing the generation, which is done
+  whenever the input may have changed.
+*/
+
+
+#include <string.h>
+#include "os.h"
+
+
+#define PARSE_MEMO_BITS     12
+#define PARSE_MEMO_FAIL     -1
+
+typedef struct
+{
+    int32_t rule;
+    int32_t gen;
+    UIndex  buf;        // Input buffer.
+    UIndex  pos;
+    UIndex  end;        // Input position after match or PARSE_MEMO_FAIL.
+}
+ParseMemoSlot;
+
+typedef struct
+{
+    ParseMemoSlot* slots;
+    int32_t gen;
+}
+ParseMemo;
+
+
+static void parseMemoInit( ParseMemo* memo, int enable )
+{
+    size_t size;
+    memo->gen = 1;
+    if( enable )
+    {
+        size = sizeof(ParseMemoSlot) << PARSE_MEMO_BITS;
+        memo->slots = (ParseMemoSlot*) memAlloc( size );
+        memset( memo->slots, 0, size );
+    }
+    else
+        memo->slots = 0;
+}
+
+
+static void parseMemoFree( ParseMemo* memo )
+{
+    if( memo->slots )
+    {
+        memFree( memo->slots );
+        memo->slots = 0;
+    }
+}
+
+
+static inline void parseMemoInvalidate( ParseMemo* memo )
+{
+    ++memo->gen;
+}
+
+
+static inline ParseMemoSlot* parseMemoSlot( ParseMemo* memo, int rule,
+                                            UIndex buf, UIndex pos )
+{
+    uint32_t h = ((uint32_t) pos * 0x9E3779B1u) ^
+                 ((uint32_t) (rule + (buf << 8)) * 0x85EBCA6Bu);
+    return memo->slots + (h >> (32 - PARSE_MEMO_BITS));
+}
+
+
+/*
+  Return pointer to slot if it holds the result for rule at buf/pos, or zero.
+*/
+static inline const ParseMemoSlot* parseMemoLookup( ParseMemo* memo, int rule,
+                                                    UIndex buf, UIndex pos )
+{
+    const ParseMemoSlot* slot = parseMemoSlot( memo, rule, buf, pos );
+    if( slot->gen == memo->gen && slot->rule == rule &&
+        slot->pos == pos && slot->buf == buf )
+        return slot;
+    return 0;
+}
+
+
+static inline void parseMemoStore( ParseMemo* memo, int rule, UIndex buf,
+                                   UIndex pos, UIndex end )
+{
+    ParseMemoSlot* slot = parseMemoSlot( memo, rule, buf, pos );
+    slot->rule = rule;
+    slot->gen  = memo->gen;
+    slot->buf  = buf;
+    slot->pos  = pos;
+    slot->end  = end;
+}
+
+
+#endif  /*PARSE_MEMO_H*/
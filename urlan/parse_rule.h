@@ -0,0 +1,236 @@
+#ifndef PARSE_RULE_H
+#define PARSE_RULE_H
+/*
+  Rule table for the string & block parsers
+
+  Each rule block (or block slice) used in a parse is added to a table so
+  that it is only compiled once.  The table entries of both parsers begin
+  with a ParseRuleKey, which identifies the block & holds it.
+
+  A table may be kept for later parses with the same rules.  To tell if a
+  rule block has since been modified in place, a copy of its cells and the
+  contents of any strings, binaries, and bitsets in it are appended to a
+  snap buffer.
+*/
+
+
+#include <string.h>
+
+
+typedef struct
+{
+    const UCell* it;
+    const UCell* end;
+    const UCell* cells;     // Block memory when added.
+    UIndex  blkN;           // Block or UR_INVALID_BUF for unnamed root rules.
+    UIndex  used;           // Block size when added.
+    UIndex  hold;
+    int32_t snap;           // Offset of copy in snap buffer or -1.
+}
+ParseRuleKey;
+
+
+#define parseRuleKey(table,n) \
+    ((ParseRuleKey*) ((table)->ptr.b + (n) * (table)->elemSize))
+
+
+// Same as ur_bufferSer() but without a function call.
+#define parseRuleSeries(c) \
+    (ur_isShared((c)->series.buf) ? ut->sharedStoreBuf - (c)->series.buf \
+                                  : ur_buffer((c)->series.buf))
+
+#define SNAP_APPEND(src,size) \
+    memcpy( snap->ptr.b + snap->used, src, size ); \
+    snap->used += size
+
+
+/*
+  Append a copy of the rule to the snap buffer.  Rules in shared storage
+  cannot change and so are not copied.
+
+  The cells are followed by a count of the strings, binaries, and bitsets
+  in them, and for each of these the cell index, byte size, and contents.
+*/
+static void parseRuleSnap( UThread* ut, UBuffer* snap, ParseRuleKey* key )
+{
+    const UBuffer* buf;
+    const UCell* it;
+    int32_t count = 0;
+    int32_t countPos;
+    int32_t n[2];
+
+    if( ur_isShared(key->blkN) )
+    {
+        key->snap = -1;
+        return;
+    }
+    key->snap = snap->used;
+
+    n[0] = (key->end - key->it) * sizeof(UCell);
+    ur_arrReserve( snap, snap->used + n[0] + sizeof(int32_t) );
+    SNAP_APPEND( key->it, n[0] );
+    countPos = snap->used;
+    snap->used += sizeof(int32_t);
+
+    for( it = key->it; it != key->end; ++it )
+    {
+        switch( ur_type(it) )
+        {
+            case UT_BINARY:
+            case UT_BITSET:
+            case UT_STRING:
+            case UT_FILE:
+                buf = parseRuleSeries( it );
+                n[0] = it - key->it;
+                n[1] = buf->used * buf->elemSize;
+                ur_arrReserve( snap, snap->used + sizeof(n) + n[1] );
+                SNAP_APPEND( n, sizeof(n) );
+                if( n[1] )
+                {
+                    SNAP_APPEND( buf->ptr.b, n[1] );
+                }
+                ++count;
+                break;
+        }
+    }
+    memcpy( snap->ptr.b + countPos, &count, sizeof(int32_t) );
+}
+
+
+/*
+  \return Non-zero if the rule block is the same as when it was copied.
+*/
+static int parseRuleUnchanged( UThread* ut, const UBuffer* snap,
+                               const ParseRuleKey* key )
+{
+    const UBuffer* buf;
+    const uint8_t* sp;
+    int32_t count;
+    int32_t n[2];
+
+    if( key->snap < 0 )
+        return 1;
+
+    buf = ur_buffer( key->blkN );
+    if( buf->ptr.cell != key->cells || buf->used != key->used )
+        return 0;
+
+    sp = snap->ptr.b + key->snap;
+    n[0] = (key->end - key->it) * sizeof(UCell);
+    if( memcmp( sp, key->it, n[0] ) )
+        return 0;
+    sp += n[0];
+
+    memcpy( &count, sp, sizeof(int32_t) );
+    sp += sizeof(int32_t);
+    while( count-- )
+    {
+        memcpy( n, sp, sizeof(n) );
+        sp += sizeof(n);
+        buf = parseRuleSeries( key->it + n[0] );
+        if( n[1] != buf->used * buf->elemSize ||
+            (n[1] && memcmp( sp, buf->ptr.b, n[1] )) )
+            return 0;
+        sp += n[1];
+    }
+    return 1;
+}
+
+
+/*
+  Get index of rule in the table, adding it if not present.
+  The members which follow the key in an added entry are zeroed.
+
+  \param table  Table of rules which begin with a ParseRuleKey.
+  \param snap   Buffer to copy added rules to.
+  \param cache  Index of the rule last found for this cell.
+  \param added  Set to non-zero if the rule was added.  May be zero.
+*/
+static int parseRuleIndex( UThread* ut, UBuffer* table, UBuffer* snap,
+                           const UCell* blkCell, int32_t* cache, int* added )
+{
+    UBlockIt bi;
+    const UBuffer* blk;
+    ParseRuleKey* key;
+    UIndex blkN = blkCell->series.buf;
+    int n;
+
+    blk = ur_blockIt( ut, &bi, blkCell );
+
+#define PARSE_RULE_MATCH \
+    (key->it == bi.it && key->end == bi.end && key->blkN == blkN && \
+     key->used == blk->used && key->cells == blk->ptr.cell)
+
+    if( *cache >= 0 )
+    {
+        key = parseRuleKey( table, *cache );
+        if( PARSE_RULE_MATCH )
+            goto done;
+    }
+
+    for( n = 0; n < table->used; ++n )
+    {
+        key = parseRuleKey( table, n );
+        if( PARSE_RULE_MATCH )
+        {
+            *cache = n;
+            goto done;
+        }
+    }
+
+    ur_arrReserve( table, table->used + 1 );
+    *cache = table->used++;
+    key = parseRuleKey( table, *cache );
+    memset( key, 0, table->elemSize );
+    key->it    = bi.it;
+    key->end   = bi.end;
+    key->cells = blk->ptr.cell;
+    key->blkN  = blkN;
+    key->used  = blk->used;
+    // Hold the block so that it is not recycled & replaced by another at
+    // the same address.
+    key->hold = ur_isShared(blkN) ? UR_INVALID_HOLD : ur_hold( blkN );
+    parseRuleSnap( ut, snap, key );
+    if( added )
+        *added = 1;
+    return *cache;
+
+done:
+    if( added )
+        *added = 0;
+    return *cache;
+}
+
+
+/*
+  Set the key of the root rule block, which is left unheld.
+*/
+static void parseRuleRoot( ParseRuleKey* key, const UBuffer* blk, UIndex blkN )
+{
+    key->it    = blk->ptr.cell;
+    key->end   = blk->ptr.cell + blk->used;
+    key->cells = blk->ptr.cell;
+    key->blkN  = blkN;
+    key->used  = blk->used;
+    key->hold  = UR_INVALID_HOLD;
+    key->snap  = -1;
+}
+
+
+/*
+  Release the holds of all rules in the table.
+*/
+static void parseRuleRelease( UThread* ut, const UBuffer* table )
+{
+    const ParseRuleKey* key;
+    UIndex n;
+    for( n = 0; n < table->used; ++n )
+    {
+        key = parseRuleKey( table, n );
+        if( key->hold != UR_INVALID_HOLD )
+            ur_release( key->hold );
+    }
+}
+
+
+#endif  /*PARSE_RULE_H*/
@@ -18,9 +18,12 @@
 */
 
 
+#include <string.h>
 #include "urlan.h"
 #include "urlan_atoms.h"
 #include "mem_util.h"
+#include "parse_memo.h"
+#include "parse_rule.h"
 
 
 #define REPEAT_ANY  0x7fffffff
@@ -41,12 +44,21 @@ typedef struct
 {
     UStatus (*eval)( UThread*, const UCell* );
     UBuffer* str;
+    UBuffer  prog;          // Compiled rules
+    UBuffer  table;         // StringRule
+    UBuffer  words;         // StringWord
+    UBuffer  guards;        // StringGuard
+    UBuffer  snap;          // Copy of rule blocks to check for changes
+    ParseMemo memo;         // Named rule results for parse/memo
+    int32_t  version;       // Incremented when words change
     UIndex   inputBuf;
     UIndex   inputEnd;
     int      sliced;
     int      exception;
     int      matchCase;
     int      ucs2;
+    int      cacheSlot;     // Cache slot rules were taken from or -1.
+    UAtom    sliceAtom;
 }
 StringParser;
 
@@ -133,25 +145,364 @@ SCAN_BITSET(uint8_t)
 SCAN_BITSET(uint16_t)
 
 
-#define CHECK_WORD(cell) \
-    if( ! cell ) \
-        goto parse_err;
+/*
+  Rule blocks are compiled to a program of StringParseOp instructions the
+  first time they are used in a parse.
+
+  Each alternative begins with PS_Next so that a failed match jumps directly
+  to the next one rather than searching for '|'.  PS_Next also has a guard,
+  the set of characters which can start the alternative, so that
+  alternatives are skipped without trying them.
+
+  Cell operands are indexes into the rule block.  Words are kept in a table
+  of StringWord values which is re-checked whenever a paren is evaluated or
+  a word is set by the rules.  A value reference operand is either a cell
+  index (>= 0) or a word (-1 - word index).
+*/
+enum StringParseOp
+{
+    PS_End,         // Alternative matched
+    PS_Next,        // Offset of next alternative (or zero), guard
+    PS_Fail,
+    PS_Break,
+    PS_Char,        // char
+    PS_Skip,        // count
+    PS_Str,         // cell
+    PS_Bitset,      // cell
+    PS_Matcher,     // cell
+    PS_Rule,        // rule
+    PS_Word,        // word
+    PS_Repeat,      // min, max, value reference
+    PS_RepeatRule,  // min, max, rule
+    PS_To,          // value reference
+    PS_Thru,        // value reference
+    PS_Place,       // word
+    PS_SetWord,     // cell
+    PS_GetWord,     // cell
+    PS_Paren,       // cell
+    PS_SliceStart,
+    PS_SliceEnd,    // cell
+    PS_Error        // StringParseError, cell
+};
+
+enum StringParseError
+{
+    PS_ERR_END,
+    PS_ERR_PLACE,
+    PS_ERR_SLICE,
+    PS_ERR_VALUE
+};
+
+typedef struct
+{
+    ParseRuleKey key;
+    int32_t pc;         // Program offset or -1 if not yet compiled.
+    int32_t guard;      // Guard for all alternatives.
+    int32_t version;    // Words version of guards, or -1 while being set.
+    int32_t dfa;        // Program offset of DFA or -1 if not regular.
+    int32_t dfaClass;   // Program offset of character bitset or -1.
+    int32_t dfaVersion; // Words version of DFA.
+    int32_t dfaBuilds;
+}
+StringRule;
+
+typedef struct
+{
+    const UCell* word;  // Word in rule block.
+    const UCell* ptr;   // Bound cell, or zero if looked up for each use.
+    UCell   value;      // Copy of *ptr.
+    int32_t rule;       // Rule index if value is a block or -1.
+    int32_t key;        // First character of string or size of bitset.
+    UBuffer text;       // Copy of string or binary contents.
+    uint8_t bits[32];   // Start of bitset.
+}
+StringWord;
+
+typedef struct
+{
+    uint8_t bits[32];
+    uint8_t high;       // Characters above 255 may match.
+    uint8_t all;        // Any character may match, or none needed.
+}
+StringGuard;
+
+
+#define RULE(n)     (ur_ptr(StringRule, &pe->table) + (n))
+#define WORD(n)     (ur_ptr(StringWord, &pe->words) + (n))
+#define GUARD(n)    (ur_ptr(StringGuard, &pe->guards) + (n))
+#define INPUT_CHAR(n)   (pe->ucs2 ? istr->ptr.u16[n] : istr->ptr.b[n])
+
+#define EMIT(n) \
+    ur_arrReserve( prog, prog->used + n ); \
+    op = prog->ptr.i32 + prog->used; \
+    prog->used += n
+
+
+static int _newGuard( StringParser* pe )
+{
+    UBuffer* buf = &pe->guards;
+    StringGuard* g;
+    ur_arrExpand1( StringGuard, buf, g );
+    g->all = 1;
+    return buf->used - 1;
+}
+
 
 /*
-  Returns zero if matching rule not found or exception occured.
+  Get index of rule in the table, adding it if not present.
+
+  \param cache  Index of the rule last found for this cell.
 */
-static const UCell* _parseStr( UThread* ut, StringParser* pe,
-                               const UCell* rit, const UCell* rend,
-                               UIndex* spos )
+static int _ruleIndex( UThread* ut, StringParser* pe, const UCell* blkCell,
+                       int32_t* cache )
 {
-    const UCell* tval;
-    int32_t repMin;
-    int32_t repMax;
-    UBuffer* istr = pe->str;
-    UIndex pos = *spos;
+    StringRule* rule;
+    int added;
+    int n = parseRuleIndex( ut, &pe->table, &pe->snap, blkCell, cache,
+                            &added );
+    if( added )
+    {
+        rule = RULE(n);
+        rule->pc      = -1;
+        rule->guard   = -1;
+        rule->version = -2;
+        rule->dfaVersion = -2;
+    }
+    return n;
+}
 
 
-match:
+/*
+  Set the parts of a word value which guards are made from.
+
+  \return Non-zero if they have changed.
+*/
+static int _wordKey( UThread* ut, StringWord* sw )
+{
+    const UCell* val = &sw->value;
+    int32_t key = 0;
+    int changed = 0;
+
+    switch( ur_type(val) )
+    {
+        case UT_BINARY:
+        case UT_STRING:
+        {
+            USeriesIter si;
+            UBuffer* text = &sw->text;
+            const uint8_t* it;
+            int size;
+
+            ur_seriesSlice( ut, &si, val );
+            if( si.it == si.end )
+                key = -1;
+            else if( si.buf->type == UT_STRING && ur_strIsUcs2(si.buf) )
+                key = si.buf->ptr.u16[ si.it ];
+            else
+                key = si.buf->ptr.b[ si.it ];
+
+            // The whole string is used by DFAs so check all of it.
+            it   = si.buf->ptr.b + si.it * si.buf->elemSize;
+            size = (si.end - si.it) * si.buf->elemSize;
+            if( size != text->used ||
+                (size && memcmp( text->ptr.b, it, size )) )
+            {
+                ur_arrReserve( text, size );
+                if( size )
+                    memcpy( text->ptr.b, it, size );
+                text->used = size;
+                changed = 1;
+            }
+        }
+            break;
+
+        case UT_BITSET:
+        {
+            const UBuffer* bin = ur_bufferSer( val );
+            int n = (bin->used < 32) ? bin->used : 32;
+            key = bin->used;
+            if( memcmp( sw->bits, bin->ptr.b, n ) )
+            {
+                memcpy( sw->bits, bin->ptr.b, n );
+                changed = 1;
+            }
+        }
+            break;
+    }
+
+    if( sw->key != key )
+    {
+        sw->key = key;
+        changed = 1;
+    }
+    return changed;
+}
+
+
+static int _wordIndex( UThread* ut, StringParser* pe, const UCell* word )
+{
+    UBuffer* words = &pe->words;
+    StringWord* sw;
+    StringWord* end;
+    const UCell* cell = 0;
+
+    switch( ur_binding(word) )
+    {
+        case UR_BIND_THREAD:
+        case UR_BIND_ENV:
+        case UR_BIND_STACK:
+            cell = ur_wordCell( ut, word );
+            sw  = ur_ptr(StringWord, words);
+            end = sw + words->used;
+            for( ; sw != end; ++sw )
+            {
+                if( sw->ptr == cell )
+                    return sw - ur_ptr(StringWord, words);
+            }
+            break;
+    }
+
+    ur_arrExpand1( StringWord, words, sw );
+    sw->word = word;
+    sw->ptr  = cell;
+    sw->rule = -1;
+    ur_arrInit( &sw->text, 1, 0 );
+    if( cell )
+    {
+        sw->value = *cell;
+        sw->key = 0;
+        _wordKey( ut, sw );
+    }
+    return words->used - 1;
+}
+
+
+/*
+  Update the copies of word values.
+
+  \return Non-zero if any have changed.
+*/
+static int _wordsChanged( UThread* ut, StringParser* pe )
+{
+    StringWord* sw  = WORD(0);
+    StringWord* end = sw + pe->words.used;
+    const UCell* cell;
+    int changed = 0;
+
+    for( ; sw != end; ++sw )
+    {
+        if( sw->ptr )
+        {
+            // The context may have been resized & the block changed.
+            sw->ptr = cell = ur_wordCell( ut, sw->word );
+            sw->rule = -1;
+            if( memcmp( cell, &sw->value, sizeof(UCell) ) )
+            {
+                sw->value = *cell;
+                changed = 1;
+            }
+            if( _wordKey( ut, sw ) )
+                changed = 1;
+        }
+    }
+    return changed;
+}
+
+
+/*
+  Update words after they may have been changed by an evaluation.
+  The guards are invalidated if any words or rule blocks are changed.
+*/
+static void _checkWords( UThread* ut, StringParser* pe )
+{
+    const StringRule* rule;
+    const StringRule* rend;
+    int changed = _wordsChanged( ut, pe );
+
+    rule = RULE(0);
+    rend = rule + pe->table.used;
+    for( ; rule != rend; ++rule )
+    {
+        if( rule->key.blkN > 0 )
+        {
+            const UBuffer* blk = ur_buffer( rule->key.blkN );
+            if( blk->ptr.cell != rule->key.cells ||
+                blk->used != rule->key.used )
+                changed = 1;
+        }
+    }
+
+    if( changed )
+    {
+        ++pe->version;
+        parseMemoInvalidate( &pe->memo );
+    }
+}
+
+
+/*
+  Update word table after a word is set by the rules.
+*/
+static void _setWord( UThread* ut, StringParser* pe, const UCell* cell )
+{
+    StringWord* sw  = WORD(0);
+    StringWord* end = sw + pe->words.used;
+
+    for( ; sw != end; ++sw )
+    {
+        if( sw->ptr == cell )
+        {
+            sw->value = *cell;
+            sw->rule = -1;
+            _wordKey( ut, sw );
+            ++pe->version;
+            parseMemoInvalidate( &pe->memo );
+            return;
+        }
+    }
+}
+
+
+/*
+  Slice is not one of the fixed atoms, so its atom is looked up on first use.
+  It is only a keyword when followed by a word so that rules can still be
+  named slice.
+*/
+static int _isSliceWord( UThread* ut, StringParser* pe, const UCell* rit,
+                         const UCell* rend )
+{
+    if( pe->sliceAtom == UR_INVALID_ATOM )
+        pe->sliceAtom = ur_intern( ut, "slice", 5 );
+    ++rit;
+    return ur_atom(rit - 1) == pe->sliceAtom && rit != rend &&
+           ur_is(rit, UT_WORD) && ur_atom(rit) != UR_ATOM_BAR;
+}
+
+
+static void _compileStr( UThread* ut, StringParser* pe, int ruleN )
+{
+    UBuffer* prog = &pe->prog;
+    const UCell* start = RULE(ruleN)->key.it;
+    const UCell* rend  = RULE(ruleN)->key.end;
+    const UCell* rit   = start;
+    int32_t* op;
+    int32_t repMin;
+    int32_t repMax;
+    int32_t ri;
+    int next;
+    int sliceCell = 0;
+    int slicePending = 0;
+
+    ri = _newGuard( pe );
+    RULE(ruleN)->guard = ri;
+    RULE(ruleN)->pc = prog->used;
+
+    ri = _newGuard( pe );
+    EMIT(3);
+    op[0] = PS_Next;
+    op[1] = 0;
+    op[2] = ri;
+    next = prog->used - 2;
 
     while( rit != rend )
     {
@@ -161,330 +512,1625 @@ match:
                 switch( ur_atom(rit) )
                 {
                 case UR_ATOM_OPT:
-                    ++rit;
                     repMin = 0;
                     repMax = 1;
                     goto repeat;
 
                 case UR_ATOM_ANY:
-                    ++rit;
                     repMin = 0;
                     repMax = REPEAT_ANY;
                     goto repeat;
 
                 case UR_ATOM_SOME:
-                    ++rit;
                     repMin = 1;
                     repMax = REPEAT_ANY;
                     goto repeat;
 
                 case UR_ATOM_BREAK:
-                    pe->exception = PARSE_EX_BREAK;
-                    *spos = pos;
-                    return 0;
+                    EMIT(1);
+                    op[0] = PS_Break;
+                    ++rit;
+                    break;
 
                 case UR_ATOM_BAR:
-                    goto complete;
+                    if( slicePending )
+                    {
+                        slicePending = 0;
+                        EMIT(2);
+                        op[0] = PS_SliceEnd;
+                        op[1] = sliceCell;
+                    }
+                    ri = _newGuard( pe );
+                    EMIT(4);
+                    op[0] = PS_End;
+                    op[1] = PS_Next;
+                    op[2] = 0;
+                    op[3] = ri;
+                    prog->ptr.i32[ next ] = prog->used - 3;
+                    next = prog->used - 2;
+                    ++rit;
+                    break;
 
                 case UR_ATOM_TO:
                 case UR_ATOM_THRU:
-                {
-                    UAtom ratom = ur_atom(rit);
+                    if( ++rit == rend )
+                        goto fail;
+                    ri = ur_is(rit, UT_WORD) ? -1 - _wordIndex( ut, pe, rit )
+                                             : rit - start;
+                    EMIT(2);
+                    op[0] = (ur_atom(rit - 1) == UR_ATOM_TO) ? PS_To : PS_Thru;
+                    op[1] = ri;
+                    ++rit;
+                    break;
 
+                case UR_ATOM_SKIP:
+                    repMin = 1;
+skip:
+                    EMIT(2);
+                    op[0] = PS_Skip;
+                    op[1] = repMin;
                     ++rit;
-                    if( rit == rend )
-                        return 0;
+                    break;
 
-                    if( ur_is(rit, UT_WORD) )
+                case UR_ATOM_PLACE:
+                    ++rit;
+                    if( (rit != rend) && ur_is(rit, UT_WORD) )
                     {
-                        tval = ur_wordCell( ut, rit );
-                        CHECK_WORD(tval);
+                        ri = _wordIndex( ut, pe, rit );
+                        EMIT(2);
+                        op[0] = PS_Place;
+                        op[1] = ri;
+                        ++rit;
                     }
                     else
                     {
-                        tval = rit;
+                        EMIT(3);
+                        op[0] = PS_Error;
+                        op[1] = PS_ERR_PLACE;
+                        op[2] = 0;
                     }
+                    break;
 
-                    switch( ur_type(tval) )
+                default:
+                    if( _isSliceWord( ut, pe, rit, rend ) )
                     {
-                        case UT_CHAR:
-                            pos = ur_strFindChar( istr, pos, pe->inputEnd,
-                                                  ur_int(tval), pe->matchCase );
-                            if( pos < 0 )
-                                goto failed;
-                            if( ratom == UR_ATOM_THRU )
-                                ++pos;
-                            break;
-
-                        case UT_BINARY:
-                        case UT_STRING:
+                        // The word is set after the next value matches.
+                        rit += 2;
+                        if( rit != rend && ! (ur_is(rit, UT_WORD) &&
+                                              ur_atom(rit) == UR_ATOM_BAR) )
                         {
-                            USeriesIter si;
-                            USeriesIter sp;
-
-                            si.buf = istr;
-                            si.it  = pos;
-                            si.end = pe->inputEnd;
-
-                            ur_seriesSlice( ut, &sp, tval );
-                            pos = ur_strFind( &si, &sp, pe->matchCase );
-                            if( pos < 0 )
-                                goto failed;
-                            if( ratom == UR_ATOM_THRU )
-                                pos += sp.end - sp.it;
+                            sliceCell = rit - 1 - start;
+                            slicePending = 2;
+                            EMIT(1);
+                            op[0] = PS_SliceStart;
                         }
-                            break;
-
-                        case UT_BITSET:
-                            pos = pe->ucs2 ?
-                                _scanToBitset_uint16_t( ut, istr->ptr.u16,
-                                            pos, pe->inputEnd, tval ) :
-                                _scanToBitset_uint8_t( ut, istr->ptr.b,
-                                            pos, pe->inputEnd, tval );
-                            if( pos < 0 )
-                                goto failed;
-                            if( ratom == UR_ATOM_THRU )
-                                ++pos;
-                            break;
-
-                        default:
-                            ur_error( PARSE_ERR, "to/thru does not handle %s",
-                                      ur_atomCStr( ut, ur_type(tval) ) );
-                            goto parse_err;
+                        else
+                        {
+                            EMIT(3);
+                            op[0] = PS_Error;
+                            op[1] = PS_ERR_SLICE;
+                            op[2] = 0;
+                        }
+                        break;
                     }
+                    ri = _wordIndex( ut, pe, rit );
+                    EMIT(2);
+                    op[0] = PS_Word;
+                    op[1] = ri;
                     ++rit;
-                }
                     break;
+                }
+                break;
 
-                case UR_ATOM_SKIP:
-                    repMin = 1;
-skip:
-                    if( (pos + repMin) > pe->inputEnd )
-                        goto failed;
-                    pos += repMin;
-                    ++rit;
-                    break;
+            case UT_SETWORD:
+            case UT_GETWORD:
+            case UT_PAREN:
+                EMIT(2);
+                op[0] = ur_is(rit, UT_SETWORD) ? PS_SetWord :
+                        ur_is(rit, UT_GETWORD) ? PS_GetWord : PS_Paren;
+                op[1] = rit - start;
+                ++rit;
+                break;
 
-                case UR_ATOM_PLACE:
+            case UT_INT:
+                repMin = ur_int(rit);
+                if( rit + 1 == rend )
+                    goto fail;
+                if( ur_is(rit + 1, UT_INT) )
+                {
+                    repMax = ur_int(rit + 1);
                     ++rit;
-                    if( (rit != rend) && ur_is(rit, UT_WORD) )
-                    {
-                        tval = ur_wordCell( ut, rit++ );
-                        CHECK_WORD(tval);
-                        if( ur_is(tval, UT_STRING) )
-                        {
-                            pos = tval->series.it;
-                            break;
-                        }
-                    }
-                    ur_error( PARSE_ERR, "place expected series word" );
-                    goto parse_err;
+                }
+                else if( ur_is(rit + 1, UT_WORD) &&
+                         ur_atom(rit + 1) == UR_ATOM_SKIP )
+                {
+                    ++rit;
+                    goto skip;
+                }
+                else
+                {
+                    repMax = repMin;
+                }
+                goto repeat;
 
-                //case UR_ATOM_COPY:
+            case UT_CHAR:
+                EMIT(2);
+                op[0] = PS_Char;
+                op[1] = ur_int(rit);
+                ++rit;
+                break;
 
-                default:
-                    tval = ur_wordCell( ut, rit );
-                    CHECK_WORD(tval);
-
-                    if( ur_is(tval, UT_CHAR) )
-                        goto match_char;
-                    else if( ur_is(tval, UT_STRING) )
-                        goto match_string;
-                    else if( ur_is(tval, UT_BLOCK) )
-                        goto match_block;
-                    else if( ur_is(tval, UT_BITSET) )
-                        goto match_bitset;
-                    else
-                    {
-                        ur_error( PARSE_ERR,
-                              "parse expected char!/block!/bitset!/string!" );
-                        goto parse_err;
-                    }
+            case UT_BLOCK:
+                ri = -1;
+                ri = _ruleIndex( ut, pe, rit, &ri );
+                EMIT(2);
+                op[0] = PS_Rule;
+                op[1] = ri;
+                ++rit;
+                break;
+
+            case UT_BINARY:
+            case UT_STRING:
+            case UT_BITSET:
+                EMIT(2);
+                op[0] = ur_is(rit, UT_BITSET) ? PS_Bitset : PS_Str;
+                op[1] = rit - start;
+                ++rit;
+                break;
+
+            default:
+                if( ur_isMatcher( ut, rit ) )
+                {
+                    EMIT(2);
+                    op[0] = PS_Matcher;
+                    op[1] = rit - start;
+                    ++rit;
                     break;
                 }
+                EMIT(3);
+                op[0] = PS_Error;
+                op[1] = PS_ERR_VALUE;
+                op[2] = rit - start;
+                ++rit;
                 break;
+        }
+        goto item_done;
+
+repeat:
+        if( ++rit == rend )
+        {
+            EMIT(3);
+            op[0] = PS_Error;
+            op[1] = PS_ERR_END;
+            op[2] = 0;
+            break;
+        }
+        if( ur_is(rit, UT_BLOCK) )
+        {
+            ri = -1;
+            ri = _ruleIndex( ut, pe, rit, &ri );
+            EMIT(4);
+            op[0] = PS_RepeatRule;
+        }
+        else
+        {
+            ri = ur_is(rit, UT_WORD) ? -1 - _wordIndex( ut, pe, rit )
+                                     : rit - start;
+            EMIT(4);
+            op[0] = PS_Repeat;
+        }
+        op[1] = repMin;
+        op[2] = repMax;
+        op[3] = ri;
+        ++rit;
+
+item_done:
+        if( slicePending && ! --slicePending )
+        {
+            EMIT(2);
+            op[0] = PS_SliceEnd;
+            op[1] = sliceCell;
+        }
+    }
+
+    if( slicePending )
+    {
+        EMIT(2);
+        op[0] = PS_SliceEnd;
+        op[1] = sliceCell;
+    }
+    EMIT(1);
+    op[0] = PS_End;
+    return;
+
+fail:
+    EMIT(1);
+    op[0] = PS_Fail;
+}
+
+
+static void _guardChar( StringGuard* g, int c )
+{
+    if( c > 255 )
+        g->high = 1;
+    else
+        g->bits[ c >> 3 ] |= 1 << (c & 7);
+}
+
+
+static void _guardString( UThread* ut, StringGuard* g, const UCell* cell,
+                          int matchCase )
+{
+    USeriesIter si;
+    int c;
+
+    ur_seriesSlice( ut, &si, cell );
+    if( si.it == si.end )
+        return;         // Empty string never matches.
+    c = (si.buf->type == UT_STRING && ur_strIsUcs2(si.buf)) ?
+            si.buf->ptr.u16[ si.it ] : si.buf->ptr.b[ si.it ];
+    if( matchCase )
+    {
+        _guardChar( g, c );
+    }
+    else
+    {
+        int n;
+        c = ur_charLowercase( c );
+        for( n = 0; n < 256; ++n )
+        {
+            if( ur_charLowercase( n ) == c )
+                _guardChar( g, n );
+        }
+        g->high = 1;
+    }
+}
+
+
+static void _guardBitset( UThread* ut, StringGuard* g, const UCell* cell )
+{
+    const UBuffer* bin = ur_bufferSer( cell );
+    int n = bin->used;
+    if( n > 32 )
+    {
+        n = 32;
+        g->high = 1;
+    }
+    while( n-- )
+        g->bits[ n ] |= bin->ptr.b[ n ];
+}
+
+
+static void _ruleGuards( UThread*, StringParser*, int ruleN );
+
+static int _guardRule( UThread* ut, StringParser* pe, StringGuard* g,
+                       int ruleN )
+{
+    const StringGuard* rg;
+    int n;
+
+    if( RULE(ruleN)->version != pe->version )
+    {
+        if( RULE(ruleN)->version == -1 )
+            return 0;       // Recursive rule.
+        _ruleGuards( ut, pe, ruleN );
+    }
+    rg = GUARD( RULE(ruleN)->guard );
+    if( rg->all )
+        return 0;
+    for( n = 0; n < 32; ++n )
+        g->bits[ n ] |= rg->bits[ n ];
+    g->high |= rg->high;
+    return 1;
+}
+
+
+/*
+  Add characters which can start a match of the instruction at pc.
+
+  \return Zero if instruction can match any character or no input.
+*/
+static int _guardOp( UThread* ut, StringParser* pe, StringGuard* g,
+                     const UCell* base, const int32_t* pc )
+{
+    const StringWord* sw;
+    const UCell* tval;
+    int ref;
+
+    switch( pc[0] )
+    {
+        case PS_Char:
+            _guardChar( g, pc[1] );
+            return 1;
+
+        case PS_Str:
+            _guardString( ut, g, base + pc[1], pe->matchCase );
+            return 1;
+
+        case PS_Bitset:
+            _guardBitset( ut, g, base + pc[1] );
+            return 1;
+
+        case PS_Rule:
+            return _guardRule( ut, pe, g, pc[1] );
+
+        case PS_RepeatRule:
+            if( pc[1] < 1 )
+                return 0;
+            return _guardRule( ut, pe, g, pc[3] );
+
+        case PS_Word:
+            ref = -1 - pc[1];
+            break;
+
+        case PS_Repeat:
+            if( pc[1] < 1 )
+                return 0;
+            ref = pc[3];
+            break;
+
+        default:
+            return 0;
+    }
+
+    if( ref >= 0 )
+    {
+        tval = base + ref;
+    }
+    else
+    {
+        sw = WORD(-1 - ref);
+        if( ! sw->ptr )
+            return 0;
+        tval = &sw->value;
+    }
+
+    switch( ur_type(tval) )
+    {
+        case UT_CHAR:
+            _guardChar( g, ur_int(tval) );
+            return 1;
+
+        case UT_BINARY:
+            if( pc[0] == PS_Word )
+                return 0;       // Let PS_Word report the error.
+            // Fall through...
+        case UT_STRING:
+            _guardString( ut, g, tval, pe->matchCase );
+            return 1;
+
+        case UT_BITSET:
+            _guardBitset( ut, g, tval );
+            return 1;
+
+        case UT_BLOCK:
+        {
+            int32_t ri = -1;
+            ri = _ruleIndex( ut, pe, tval, &ri );
+            return _guardRule( ut, pe, g, ri );
+        }
+    }
+    return 0;
+}
+
+
+/*
+  Set guards of rule alternatives for the current word values.
+*/
+static void _ruleGuards( UThread* ut, StringParser* pe, int ruleN )
+{
+    StringRule* rule = RULE(ruleN);
+    StringGuard all;
+    StringGuard alt;
+    const UCell* base;
+    UIndex pc;
+    int n;
+
+    if( rule->key.blkN > 0 )
+    {
+        // Recompile if the block has been resized.
+        const UBuffer* blk = ur_buffer( rule->key.blkN );
+        if( blk->ptr.cell != rule->key.cells || blk->used != rule->key.used )
+        {
+            UIndex it  = rule->key.it  - rule->key.cells;
+            UIndex end = rule->key.end - rule->key.cells;
+            if( end > blk->used )
+                end = blk->used;
+            if( it > end )
+                it = end;
+            rule->key.it    = blk->ptr.cell + it;
+            rule->key.end   = blk->ptr.cell + end;
+            rule->key.cells = blk->ptr.cell;
+            rule->key.used  = blk->used;
+            rule->pc    = -1;
+        }
+    }
+    if( rule->pc < 0 )
+        _compileStr( ut, pe, ruleN );
+    RULE(ruleN)->version = -1;
+    base = RULE(ruleN)->key.it;
+    pc = RULE(ruleN)->pc;
+
+    memset( &all, 0, sizeof(all) );
+    do
+    {
+        memset( &alt, 0, sizeof(alt) );
+        if( ! _guardOp( ut, pe, &alt, base, pe->prog.ptr.i32 + pc + 3 ) )
+            alt.all = all.all = 1;
+        *GUARD( pe->prog.ptr.i32[ pc + 2 ] ) = alt;
+
+        for( n = 0; n < 32; ++n )
+            all.bits[ n ] |= alt.bits[ n ];
+        all.high |= alt.high;
+
+        pc = pe->prog.ptr.i32[ pc + 1 ];
+    }
+    while( pc );
+
+    *GUARD( RULE(ruleN)->guard ) = all;
+    RULE(ruleN)->version = pe->version;
+}
+
+
+static inline int _guardPass( const StringGuard* g, int c )
+{
+    return (c > 255) ? g->high : (g->bits[ c >> 3 ] & 1 << (c & 7));
+}
+
+
+/*
+  Return non-zero if rule may match at pos.
+*/
+static int _ruleMayMatch( UThread* ut, StringParser* pe, int ruleN,
+                          UIndex pos )
+{
+    const StringGuard* g;
+    const UBuffer* istr;
+
+    if( RULE(ruleN)->version != pe->version )
+        _ruleGuards( ut, pe, ruleN );
+    g = GUARD( RULE(ruleN)->guard );
+    if( g->all )
+        return 1;
+    if( pos >= pe->inputEnd )
+        return 0;
+    istr = pe->str;
+    return _guardPass( g, INPUT_CHAR(pos) );
+}
+
+
+/*
+  Regular rules
+
+  A rule whose alternatives are made only of characters, strings, bitsets,
+  skip & repeats of single characters is compiled to a DFA which matches
+  in one pass over the input.  A DFA state holds the position in each
+  alternative which can still match.  When an alternative completes, all
+  those after it are dropped, so the lowest numbered one wins just as it
+  would when trying them in order.  The repeats are possessive like those
+  of _parseStr.
+
+  DFAs are only used with 8-bit input and are stored in the program as:
+
+    nstates, nclass, cmap[64], eof[nstates], trans[nstates * nclass]
+
+  The cmap maps each byte to a character class.  A transition is
+  (next state + 1) << 1, with bit 0 set if the rule matched before the
+  character.  A next state of -1 means no alternative can match further.
+*/
+
+#define DFA_MAX_ELEM    64
+#define DFA_MAX_ALT     16
+#define DFA_MAX_STATE   128
+#define DFA_MAX_DEPTH   4
+#define DFA_MAX_BUILDS  4
+
+enum DfaStep
+{
+    DFA_FAIL,
+    DFA_ACCEPT,
+    DFA_CONSUME
+};
+
+typedef struct
+{
+    uint8_t bits[32];
+    int32_t min;
+    int32_t max;
+}
+DfaElem;
+
+typedef struct
+{
+    DfaElem elem[ DFA_MAX_ELEM ];
+    int alt[ DFA_MAX_ALT + 1 ];     // Start of each alternative in elem.
+    int elemCount;
+    int altCount;
+}
+DfaRule;
+
+typedef struct
+{
+    int32_t i;      // Element index or -1 if alternative failed.
+    int32_t c;      // Repeat count of element.
+}
+DfaPos;
+
+
+static int _dfaAdd( DfaRule* dr, const uint8_t* bits, int min, int max )
+{
+    DfaElem* e;
+    if( dr->elemCount == DFA_MAX_ELEM )
+        return 0;
+    e = dr->elem + dr->elemCount++;
+    memcpy( e->bits, bits, 32 );
+    e->min = min;
+    e->max = max;
+    return 1;
+}
+
+
+static void _dfaChar( uint8_t* bits, int c, int matchCase )
+{
+    int n;
+    memset( bits, 0, 32 );
+    if( matchCase )
+    {
+        if( c < 256 )
+            bits[ c >> 3 ] |= 1 << (c & 7);
+    }
+    else
+    {
+        // Same test as ur_strMatch().
+        c = ur_charLowercase( c );
+        for( n = 0; n < 256; ++n )
+        {
+            if( ur_charLowercase( n ) == c )
+                bits[ n >> 3 ] |= 1 << (n & 7);
+        }
+    }
+}
+
+
+static void _dfaBitset( UThread* ut, uint8_t* bits, const UCell* cell )
+{
+    const UBuffer* bin = ur_bufferSer( cell );
+    int n = (bin->used < 32) ? bin->used : 32;
+    memset( bits, 0, 32 );
+    memcpy( bits, bin->ptr.b, n );
+}
+
+
+static int _dfaString( UThread* ut, StringParser* pe, DfaRule* dr,
+                       const UCell* cell )
+{
+    USeriesIter si;
+    uint8_t bits[32];
+    int ucs2;
+    int c;
+
+    ur_seriesSlice( ut, &si, cell );
+    if( si.it == si.end )
+    {
+        // Empty string never matches.
+        memset( bits, 0, 32 );
+        return _dfaAdd( dr, bits, 1, 1 );
+    }
+    ucs2 = (si.buf->type == UT_STRING) && ur_strIsUcs2(si.buf);
+    for( ; si.it != si.end; ++si.it )
+    {
+        c = ucs2 ? si.buf->ptr.u16[ si.it ] : si.buf->ptr.b[ si.it ];
+        _dfaChar( bits, c, pe->matchCase );
+        if( ! _dfaAdd( dr, bits, 1, 1 ) )
+            return 0;
+    }
+    return 1;
+}
+
+
+static int _dfaRule( UThread*, StringParser*, int ruleN, DfaRule*, int depth );
+
+/*
+  Get the characters matched by a rule if all its alternatives are single
+  characters.
+*/
+static int _dfaClass( const DfaRule* dr, uint8_t* bits )
+{
+    const DfaElem* e;
+    int a, n;
+
+    memset( bits, 0, 32 );
+    for( a = 0; a < dr->altCount; ++a )
+    {
+        if( dr->alt[ a + 1 ] - dr->alt[ a ] != 1 )
+            return 0;
+        e = dr->elem + dr->alt[ a ];
+        if( e->min != 1 || e->max != 1 )
+            return 0;
+        for( n = 0; n < 32; ++n )
+            bits[ n ] |= e->bits[ n ];
+    }
+    return 1;
+}
+
+
+static int _dfaRuleClass( UThread* ut, StringParser* pe, int ruleN,
+                          uint8_t* bits, int depth )
+{
+    DfaRule sub;
+    if( ! _dfaRule( ut, pe, ruleN, &sub, depth + 1 ) )
+        return 0;
+    return _dfaClass( &sub, bits );
+}
+
+
+/*
+  Get the characters matched by a single character value.
+*/
+static int _dfaValueClass( UThread* ut, StringParser* pe, const UCell* val,
+                           uint8_t* bits, int depth )
+{
+    switch( ur_type(val) )
+    {
+        case UT_CHAR:
+            _dfaChar( bits, ur_int(val), 1 );
+            return 1;
+
+        case UT_BINARY:
+        case UT_STRING:
+        {
+            USeriesIter si;
+            ur_seriesSlice( ut, &si, val );
+            if( si.it == si.end )
+            {
+                memset( bits, 0, 32 );
+                return 1;
+            }
+            if( si.end - si.it > 1 )
+                return 0;
+            _dfaChar( bits, (si.buf->type == UT_STRING &&
+                             ur_strIsUcs2(si.buf)) ?
+                                si.buf->ptr.u16[ si.it ] :
+                                si.buf->ptr.b[ si.it ],
+                      pe->matchCase );
+        }
+            return 1;
+
+        case UT_BITSET:
+            _dfaBitset( ut, bits, val );
+            return 1;
+
+        case UT_BLOCK:
+        {
+            int32_t ri = -1;
+            ri = _ruleIndex( ut, pe, val, &ri );
+            return _dfaRuleClass( ut, pe, ri, bits, depth );
+        }
+    }
+    return 0;
+}
+
+
+/*
+  Append sub-rule to the current alternative.  This is only possible if
+  it has one alternative or all of them are single characters.
+*/
+static int _dfaSubRule( UThread* ut, StringParser* pe, DfaRule* dr,
+                        int ruleN, int depth )
+{
+    DfaRule sub;
+    uint8_t bits[32];
+    int n;
+
+    if( ! _dfaRule( ut, pe, ruleN, &sub, depth + 1 ) )
+        return 0;
+    if( sub.altCount == 1 )
+    {
+        for( n = 0; n < sub.elemCount; ++n )
+        {
+            if( ! _dfaAdd( dr, sub.elem[n].bits, sub.elem[n].min,
+                                                 sub.elem[n].max ) )
+                return 0;
+        }
+        return 1;
+    }
+    if( ! _dfaClass( &sub, bits ) )
+        return 0;
+    return _dfaAdd( dr, bits, 1, 1 );
+}
+
+
+/*
+  Convert the program of a rule to DfaRule elements.
+
+  \return Non-zero if rule is regular.
+*/
+static int _dfaRule( UThread* ut, StringParser* pe, int ruleN, DfaRule* dr,
+                     int depth )
+{
+    const StringWord* sw;
+    const UCell* base;
+    const UCell* tval;
+    const int32_t* op;
+    uint8_t bits[32];
+    UIndex pc;
+    UIndex next;
+    int32_t repMin;
+    int32_t repMax;
+
+    if( depth > DFA_MAX_DEPTH )
+        return 0;
+    if( RULE(ruleN)->version != pe->version )
+    {
+        if( RULE(ruleN)->version == -1 )
+            return 0;       // Recursive rule.
+        _ruleGuards( ut, pe, ruleN );
+    }
+    base = RULE(ruleN)->key.it;
+    pc = RULE(ruleN)->pc;
+
+    dr->elemCount = dr->altCount = 0;
+    do
+    {
+        if( dr->altCount == DFA_MAX_ALT )
+            return 0;
+        dr->alt[ dr->altCount++ ] = dr->elemCount;
+        next = pe->prog.ptr.i32[ pc + 1 ];
+        pc += 3;
+
+        while( 1 )
+        {
+            // Sub-rules may be compiled here, so the program can move.
+            op = pe->prog.ptr.i32 + pc;
+            switch( op[0] )
+            {
+                case PS_End:
+                    goto alt_done;
+
+                case PS_Char:
+                    _dfaChar( bits, op[1], 1 );
+                    if( ! _dfaAdd( dr, bits, 1, 1 ) )
+                        return 0;
+                    pc += 2;
+                    break;
+
+                case PS_Skip:
+                    memset( bits, 0xff, 32 );
+                    if( ! _dfaAdd( dr, bits, op[1], op[1] ) )
+                        return 0;
+                    pc += 2;
+                    break;
+
+                case PS_Str:
+                    pc += 2;
+                    if( ! _dfaString( ut, pe, dr, base + op[1] ) )
+                        return 0;
+                    break;
+
+                case PS_Bitset:
+                    _dfaBitset( ut, bits, base + op[1] );
+                    if( ! _dfaAdd( dr, bits, 1, 1 ) )
+                        return 0;
+                    pc += 2;
+                    break;
+
+                case PS_Rule:
+                    pc += 2;
+                    if( ! _dfaSubRule( ut, pe, dr, op[1], depth ) )
+                        return 0;
+                    break;
+
+                case PS_Word:
+                    sw = WORD( op[1] );
+                    if( ! sw->ptr )
+                        return 0;
+                    tval = &sw->value;
+                    pc += 2;
+                    switch( ur_type(tval) )
+                    {
+                        case UT_CHAR:
+                            _dfaChar( bits, ur_int(tval), 1 );
+                            if( ! _dfaAdd( dr, bits, 1, 1 ) )
+                                return 0;
+                            break;
+                        case UT_STRING:
+                            if( ! _dfaString( ut, pe, dr, tval ) )
+                                return 0;
+                            break;
+                        case UT_BITSET:
+                            _dfaBitset( ut, bits, tval );
+                            if( ! _dfaAdd( dr, bits, 1, 1 ) )
+                                return 0;
+                            break;
+                        case UT_BLOCK:
+                        {
+                            int32_t ri = -1;
+                            ri = _ruleIndex( ut, pe, tval, &ri );
+                            if( ! _dfaSubRule( ut, pe, dr, ri, depth ) )
+                                return 0;
+                        }
+                            break;
+                        default:
+                            return 0;
+                    }
+                    break;
+
+                case PS_Repeat:
+                    repMin = op[1];
+                    repMax = op[2];
+                    if( op[3] >= 0 )
+                        tval = base + op[3];
+                    else
+                    {
+                        sw = WORD( -1 - op[3] );
+                        if( ! sw->ptr )
+                            return 0;
+                        tval = &sw->value;
+                    }
+                    pc += 4;
+                    if( ! _dfaValueClass( ut, pe, tval, bits, depth ) )
+                        return 0;
+                    if( ! _dfaAdd( dr, bits, repMin, repMax ) )
+                        return 0;
+                    break;
+
+                case PS_RepeatRule:
+                    repMin = op[1];
+                    repMax = op[2];
+                    pc += 4;
+                    if( ! _dfaRuleClass( ut, pe, op[3], bits, depth ) )
+                        return 0;
+                    if( ! _dfaAdd( dr, bits, repMin, repMax ) )
+                        return 0;
+                    break;
+
+                default:
+                    return 0;
+            }
+        }
+alt_done:
+        pc = next;
+    }
+    while( pc );
+
+    dr->alt[ dr->altCount ] = dr->elemCount;
+    return 1;
+}
+
+
+/*
+  Advance alternative a at pos by character ch (or -1 at end of input).
+*/
+static int _dfaStep( const DfaRule* dr, int a, DfaPos* pos, int ch )
+{
+    const DfaElem* e;
+    int end = dr->alt[ a + 1 ];
+    int i = pos->i;
+    int c = pos->c;
+
+    while( i != end )
+    {
+        e = dr->elem + i;
+        if( ch >= 0 && bitIsSet( e->bits, ch ) && c < e->max )
+        {
+            // Counts beyond the minimum of an unlimited repeat are all
+            // the same state.
+            if( ++c > e->min && e->max == REPEAT_ANY )
+                c = e->min;
+            pos->i = i;
+            pos->c = c;
+            return DFA_CONSUME;
+        }
+        if( c < e->min )
+            return DFA_FAIL;
+        ++i;
+        c = 0;
+    }
+    return DFA_ACCEPT;
+}
+
+
+/*
+  Compile a DFA for rule to the end of the program.  If the rule only
+  matches single characters then a bitset of them is also added.
+
+  \param cls   Set to program offset of bitset or -1.
+
+  \return Program offset of DFA or -1 if rule is not regular or too complex.
+*/
+static int32_t _dfaCompile( UThread* ut, StringParser* pe, int ruleN,
+                            int32_t* cls )
+{
+    DfaRule dr;
+    DfaPos np[ DFA_MAX_ALT ];
+    DfaPos* states;
+    int32_t* trans;
+    int32_t eof[ DFA_MAX_STATE ];
+    uint64_t sig[ 256 ];
+    uint8_t cmap[ 256 ];
+    uint8_t rep[ 256 ];
+    uint8_t bits[ 32 ];
+    UBuffer* prog;
+    int32_t* op;
+    int32_t off = -1;
+    int nclass = 0;
+    int nstates;
+    int alts;
+    int s, x, a, n;
+
+    *cls = -1;
+    if( ! _dfaRule( ut, pe, ruleN, &dr, 0 ) )
+        return -1;
+    alts = dr.altCount;
+
+    // Group bytes into classes which are matched by the same elements.
+    for( x = 0; x < 256; ++x )
+    {
+        uint64_t m = 0;
+        for( n = 0; n < dr.elemCount; ++n )
+        {
+            if( bitIsSet( dr.elem[n].bits, x ) )
+                m |= ((uint64_t) 1) << n;
+        }
+        for( n = 0; n < nclass; ++n )
+        {
+            if( sig[n] == m )
+                break;
+        }
+        if( n == nclass )
+        {
+            sig[n] = m;
+            rep[n] = x;
+            ++nclass;
+        }
+        cmap[x] = n;
+    }
+
+    states = (DfaPos*) memAlloc( sizeof(DfaPos) * DFA_MAX_STATE * alts +
+                                 sizeof(int32_t) * DFA_MAX_STATE * nclass );
+    trans = (int32_t*) (states + DFA_MAX_STATE * alts);
+
+    for( a = 0; a < alts; ++a )
+    {
+        states[a].i = dr.alt[a];
+        states[a].c = 0;
+    }
+    nstates = 1;
+
+    for( s = 0; s < nstates; ++s )
+    {
+        const DfaPos* sp = states + s * alts;
+
+        eof[s] = 0;
+        for( a = 0; a < alts; ++a )
+        {
+            if( sp[a].i >= 0 )
+            {
+                np[a] = sp[a];
+                if( _dfaStep( &dr, a, np + a, -1 ) == DFA_ACCEPT )
+                {
+                    eof[s] = 1;
+                    break;
+                }
+            }
+        }
+
+        for( x = 0; x < nclass; ++x )
+        {
+            int acc = 0;
+            int live = 0;
+
+            for( a = 0; a < alts; ++a )
+                np[a].i = -1;
+            for( a = 0; a < alts; ++a )
+            {
+                if( sp[a].i < 0 )
+                    continue;
+                np[a] = sp[a];
+                switch( _dfaStep( &dr, a, np + a, rep[x] ) )
+                {
+                    case DFA_CONSUME:
+                        ++live;
+                        continue;
+                    case DFA_ACCEPT:
+                        acc = 1;
+                        break;
+                }
+                np[a].i = -1;
+                if( acc )
+                    break;      // Later alternatives lose to this one.
+            }
+
+            if( ! live )
+            {
+                n = -1;
+            }
+            else
+            {
+                for( n = 0; n < nstates; ++n )
+                {
+                    if( ! memcmp( states + n * alts, np,
+                                  sizeof(DfaPos) * alts ) )
+                        break;
+                }
+                if( n == nstates )
+                {
+                    if( nstates == DFA_MAX_STATE )
+                        goto cleanup;
+                    memcpy( states + n * alts, np, sizeof(DfaPos) * alts );
+                    ++nstates;
+                }
+            }
+            trans[ s * nclass + x ] = ((n + 1) << 1) | acc;
+        }
+    }
+
+    prog = &pe->prog;
+    EMIT( 2 + 64 + nstates + nstates * nclass );
+    off = op - prog->ptr.i32;
+    op[0] = nstates;
+    op[1] = nclass;
+    memcpy( op + 2, cmap, 256 );
+    memcpy( op + 66, eof, sizeof(int32_t) * nstates );
+    op += 66 + nstates;
+    for( s = 0; s < nstates; ++s )
+    {
+        memcpy( op, trans + s * nclass, sizeof(int32_t) * nclass );
+        op += nclass;
+    }
+
+    if( _dfaClass( &dr, bits ) )
+    {
+        EMIT( 8 );
+        memcpy( op, bits, 32 );
+        *cls = op - prog->ptr.i32;
+    }
+
+cleanup:
+    memFree( states );
+    return off;
+}
+
+
+/*
+  Get DFA for the current word values of a rule.
+
+  \return Program offset of DFA or -1 if rule is not regular.
+*/
+static int32_t _ruleDfa( UThread* ut, StringParser* pe, int ruleN )
+{
+    StringRule* rule = RULE(ruleN);
+    if( rule->dfaVersion != pe->version )
+    {
+        // Stop trying if the words keep changing.
+        if( rule->dfaBuilds == DFA_MAX_BUILDS )
+        {
+            rule->dfa = rule->dfaClass = -1;
+        }
+        else
+        {
+            int32_t off, cls;
+            rule->dfaBuilds++;
+            off = _dfaCompile( ut, pe, ruleN, &cls );
+            rule = RULE(ruleN);
+            rule->dfa = off;
+            rule->dfaClass = cls;
+        }
+        rule->dfaVersion = pe->version;
+    }
+    return rule->dfa;
+}
+
+
+/*
+  Match DFA at pos.
+
+  \return Input position at end of match or -1 if no match.
+*/
+static UIndex _dfaMatch( const int32_t* dfa, const uint8_t* input,
+                         UIndex pos, UIndex end )
+{
+    const uint8_t* cmap  = (const uint8_t*) (dfa + 2);
+    const int32_t* eof   = dfa + 66;
+    const int32_t* trans = eof + dfa[0];
+    int nclass = dfa[1];
+    UIndex match = -1;
+    int32_t t;
+    int s = 0;
+
+    for( ; pos < end; ++pos )
+    {
+        t = trans[ s * nclass + cmap[ input[pos] ] ];
+        if( t & 1 )
+            match = pos;
+        s = (t >> 1) - 1;
+        if( s < 0 )
+            return match;
+    }
+    if( eof[s] )
+        match = pos;
+    return match;
+}
+
+
+/*
+  Return number of characters advanced.
+*/
+static int _dfaRepeatClass( const uint8_t* input, UIndex pos, UIndex end,
+                            int limit, const uint8_t* bits )
+{
+    const uint8_t* it   = input + pos;
+    const uint8_t* iend = input + end;
+    if( (limit != REPEAT_ANY) && (iend > (it + limit)) )
+        iend = it + limit;
+    input = it;
+    while( it != iend && bitIsSet( bits, *it ) )
+        ++it;
+    return it - input;
+}
+
+
+#define CHECK_WORD(cell) \
+    if( ! cell ) \
+        goto parse_err;
+
+#define SUB_RULE_ERROR(n) \
+    if( pe->exception == PARSE_EX_ERROR ) { \
+        ur_appendTrace( ut, RULE(n)->key.blkN, 0 ); \
+        return 0; \
+    }
+
+static int _parseStr( UThread*, StringParser*, int ruleN, UIndex* spos );
+
+/*
+  Parse a sub-rule.  If memo is non-zero then the result is taken from or
+  recorded in the memo table.
+
+  Returns zero if the rule does not match or an exception occured.
+*/
+static int _parseSub( UThread* ut, StringParser* pe, int ruleN,
+                      UIndex* spos, int memo )
+{
+    const ParseMemoSlot* slot;
+    UIndex start = *spos;
+    int32_t gen = 0;
+    int ok;
+
+    if( memo )
+    {
+        slot = parseMemoLookup( &pe->memo, ruleN, pe->inputBuf, start );
+        if( slot )
+        {
+            if( slot->end == PARSE_MEMO_FAIL )
+                return 0;
+            *spos = slot->end;
+            return 1;
+        }
+        gen = pe->memo.gen;
+    }
+
+    if( ! pe->ucs2 && _ruleDfa( ut, pe, ruleN ) >= 0 )
+    {
+        UIndex end = _dfaMatch( pe->prog.ptr.i32 + RULE(ruleN)->dfa,
+                                pe->str->ptr.b, start, pe->inputEnd );
+        ok = (end >= 0);
+        if( ok )
+            *spos = end;
+    }
+    else
+    {
+        ok = _ruleMayMatch( ut, pe, ruleN, start );
+        if( ok )
+            ok = _parseStr( ut, pe, ruleN, spos );
+    }
+
+    // Results are not kept if an exception occured or the input or rules
+    // changed while parsing.
+    if( memo && ! pe->exception && gen == pe->memo.gen )
+        parseMemoStore( &pe->memo, ruleN, pe->inputBuf, start,
+                        ok ? *spos : PARSE_MEMO_FAIL );
+    return ok;
+}
+
+
+/*
+  Returns zero if matching rule not found or exception occured.
+*/
+static int _parseStr( UThread* ut, StringParser* pe, int ruleN,
+                      UIndex* spos )
+{
+    StringWord* sw = 0;
+    const UCell* base;
+    const UCell* tval;
+    const int32_t* pc;
+    int32_t repMin;
+    int32_t repMax;
+    int32_t ri;
+    int next = 0;
+    int memo;
+    UIndex sliceStart = 0;
+    UBuffer* istr = pe->str;
+    UIndex pos = *spos;
+
+
+    if( RULE(ruleN)->version != pe->version )
+        _ruleGuards( ut, pe, ruleN );
+    base = RULE(ruleN)->key.it;
+    pc = pe->prog.ptr.i32 + RULE(ruleN)->pc;
+
+    // The program may grow (and move) whenever another rule is compiled,
+    // so pc is re-acquired from an offset after such calls.
+#define PC_OFFSET       (pc - pe->prog.ptr.i32)
+#define RELOAD_PC(off)  pc = pe->prog.ptr.i32 + off
+
+#define REF_VALUE(ref) \
+    if( (ref) >= 0 ) \
+        tval = base + (ref); \
+    else { \
+        sw = WORD(-1 - (ref)); \
+        if( sw->ptr ) \
+            tval = &sw->value; \
+        else { \
+            tval = ur_wordCell( ut, sw->word ); \
+            CHECK_WORD(tval); \
+        } \
+    }
+
+match:
+
+    switch( *pc )
+    {
+        case PS_End:
+            *spos = pos;
+            return 1;
+
+        case PS_Next:
+        {
+            const StringGuard* g;
+            next = pc[1];
+            if( RULE(ruleN)->version != pe->version )
+            {
+                int off = PC_OFFSET;
+                _ruleGuards( ut, pe, ruleN );
+                RELOAD_PC( off );
+            }
+            g = GUARD( pc[2] );
+            pc += 3;
+            if( g->all )
+                goto match;
+            if( pos < pe->inputEnd && _guardPass( g, INPUT_CHAR(pos) ) )
+                goto match;
+        }
+            goto failed;
+
+        case PS_Fail:
+            goto failed;
+
+        case PS_Break:
+            pe->exception = PARSE_EX_BREAK;
+            *spos = pos;
+            return 0;
+
+        case PS_Char:
+            ri = pc[1];
+            pc += 2;
+match_char:
+            if( pos >= pe->inputEnd )
+                goto failed;
+            if( INPUT_CHAR(pos) != ri )
+                goto failed;
+            ++pos;
+            goto match;
+
+        case PS_Skip:
+            if( (pos + pc[1]) > pe->inputEnd )
+                goto failed;
+            pos += pc[1];
+            pc += 2;
+            goto match;
+
+        case PS_Str:
+            tval = base + pc[1];
+            pc += 2;
+match_string:
+        {
+            USeriesIter si;
+            USeriesIter sp;
+            int plen;
+
+            si.buf = istr;
+            si.it  = pos;
+            si.end = pe->inputEnd;
+
+            ur_seriesSlice( ut, &sp, tval );
+            plen = sp.end - sp.it;
+
+            if( plen && (ur_strMatch( &si, &sp, pe->matchCase ) == plen) )
+                pos += plen;
+            else
+                goto failed;
+        }
+            goto match;
+
+        case PS_Bitset:
+            tval = base + pc[1];
+            pc += 2;
+match_bitset:
+            if( pos >= pe->inputEnd )
+                goto failed;
+        {
+            const UBuffer* bin = ur_bufferSer( tval );
+            int c = INPUT_CHAR(pos);
+            if( c < bin->used * 8 && bitIsSet( bin->ptr.b, c ) )
+                ++pos;
+            else
+                goto failed;
+        }
+            goto match;
 
-            case UT_SETWORD:
+        case PS_Matcher:
+            tval = base + pc[1];
+            pc += 2;
+match_matcher:
+        {
+            int len = ur_matcherMatch( ur_bufferSer(tval), istr,
+                                       pos, pe->inputEnd );
+            if( ! len )
+                goto failed;
+            pos += len;
+        }
+            goto match;
+
+        case PS_Rule:
+            ri = pc[1];
+            pc += 2;
+            memo = 0;
+match_rule:
+        {
+            int off = PC_OFFSET;
+            int ok = _parseSub( ut, pe, ri, &pos, memo );
+            istr = pe->str;
+            RELOAD_PC( off );
+            if( ! ok )
             {
-                UCell* cell = ur_wordCellM( ut, rit++ );
-                if( ! cell )
-                    goto parse_err;
-                ur_setId( cell, istr->type );
-                ur_setSlice( cell, pe->inputBuf, pos, pe->inputEnd );
+                SUB_RULE_ERROR( ri )
+                if( pe->exception == PARSE_EX_BREAK )
+                    pe->exception = PARSE_EX_NONE;
+                else
+                    goto failed;
             }
-                break;
+        }
+            goto match;
 
-            case UT_GETWORD:
+        case PS_Word:
+            REF_VALUE( -1 - pc[1] )
+            switch( ur_type(tval) )
             {
-                UCell* cell = ur_wordCellM( ut, rit++ );
-                if( ! cell )
-                    goto parse_err;
-                if( cell->series.buf == pe->inputBuf )
-                    cell->series.end = pos;
+                case UT_CHAR:
+                    ri = ur_int(tval);
+                    pc += 2;
+                    goto match_char;
+                case UT_STRING:
+                    pc += 2;
+                    goto match_string;
+                case UT_BLOCK:
+                    if( sw->ptr && sw->rule >= 0 )
+                        ri = sw->rule;
+                    else
+                        ri = _ruleIndex( ut, pe, tval, &sw->rule );
+                    pc += 2;
+                    memo = (pe->memo.slots != 0);
+                    goto match_rule;
+                case UT_BITSET:
+                    pc += 2;
+                    goto match_bitset;
             }
-                break;
+            if( ur_isMatcher( ut, tval ) )
+            {
+                pc += 2;
+                goto match_matcher;
+            }
+            ur_error( PARSE_ERR,
+                      "parse expected char!/block!/bitset!/string!/matcher!" );
+            goto parse_err;
 
-            case UT_INT:
-                repMin = ur_int(rit);
+        case PS_Repeat:
+        case PS_RepeatRule:
+            goto repeat;
 
-                ++rit;
-                if( rit == rend )
-                    return 0;
+        case PS_To:
+        case PS_Thru:
+        {
+            int thru = (*pc == PS_Thru);
 
-                if( ur_is(rit, UT_INT) )
-                {
-                    repMax = ur_int(rit);
-                    ++rit;
-                }
-                else if( ur_is(rit, UT_WORD) && ur_atom(rit) == UR_ATOM_SKIP )
-                {
-                    goto skip;
-                }
-                else
+            REF_VALUE( pc[1] )
+            switch( ur_type(tval) )
+            {
+                case UT_CHAR:
+                    pos = ur_strFindChar( istr, pos, pe->inputEnd,
+                                          ur_int(tval), pe->matchCase );
+                    if( pos < 0 )
+                        goto failed;
+                    if( thru )
+                        ++pos;
+                    break;
+
+                case UT_BINARY:
+                case UT_STRING:
                 {
-                    repMax = repMin;
-                }
-                goto repeat;
+                    USeriesIter si;
+                    USeriesIter sp;
 
-            case UT_CHAR:
-                tval = rit;
-match_char:
-                if( pos >= pe->inputEnd )
-                    goto failed;
-                if( (pe->ucs2 ? istr->ptr.u16[ pos ] :
-                                istr->ptr.b[ pos ]) != ur_int(tval) )
-                    goto failed;
-                ++rit;
-                ++pos;
-                break;
+                    si.buf = istr;
+                    si.it  = pos;
+                    si.end = pe->inputEnd;
 
-            case UT_BLOCK:
-                tval = rit;
-match_block:
-                {
-                UBlockIt bi;
-                UIndex rblkN = tval->series.buf;
-                ur_blockIt( ut, &bi, tval );
-                tval = _parseStr( ut, pe, bi.it, bi.end, &pos );
-                istr = pe->str;
-                if( ! tval )
-                {
-                    if( pe->exception == PARSE_EX_ERROR )
-                    {
-                        ur_appendTrace( ut, rblkN, 0 );
-                        return 0;
-                    }
-                    if( pe->exception == PARSE_EX_BREAK )
-                        pe->exception = PARSE_EX_NONE;
-                    else
+                    ur_seriesSlice( ut, &sp, tval );
+                    pos = ur_strFind( &si, &sp, pe->matchCase );
+                    if( pos < 0 )
                         goto failed;
+                    if( thru )
+                        pos += sp.end - sp.it;
                 }
-                }
-                ++rit;
-                break;
+                    break;
 
-            case UT_PAREN:
-                if( UR_OK != pe->eval( ut, rit ) )
+                case UT_BITSET:
+                    pos = pe->ucs2 ?
+                        _scanToBitset_uint16_t( ut, istr->ptr.u16,
+                                    pos, pe->inputEnd, tval ) :
+                        _scanToBitset_uint8_t( ut, istr->ptr.b,
+                                    pos, pe->inputEnd, tval );
+                    if( pos < 0 )
+                        goto failed;
+                    if( thru )
+                        ++pos;
+                    break;
+
+                default:
+                    if( ur_isMatcher( ut, tval ) )
+                    {
+                        int len, pat;
+                        pos = ur_matcherFind( ur_bufferSer(tval), istr,
+                                              pos, pe->inputEnd, 0,
+                                              &len, &pat );
+                        if( pos < 0 )
+                            goto failed;
+                        if( thru )
+                            pos += len;
+                        break;
+                    }
+                    ur_error( PARSE_ERR, "to/thru does not handle %s",
+                              ur_atomCStr( ut, ur_type(tval) ) );
                     goto parse_err;
+            }
+            pc += 2;
+        }
+            goto match;
 
-                /* Re-acquire pointer & check if input modified. */
-                istr = pe->str = ur_buffer( pe->inputBuf );
-                if( pe->sliced )
-                {
-                    // We have no way to track changes to the end of a slice,
-                    // so just make sure we remain in valid memery.
-                    if( istr->used < pe->inputEnd )
-                        pe->inputEnd = istr->used;
-                }
-                else
-                {
-                    // Not sliced, track input end.
-                    if( istr->used != pe->inputEnd )
-                        pe->inputEnd = istr->used;
-                }
+        case PS_Place:
+            REF_VALUE( -1 - pc[1] )
+            if( ur_is(tval, UT_STRING) )
+            {
+                pos = tval->series.it;
+                pc += 2;
+                goto match;
+            }
+            ur_error( PARSE_ERR, "place expected series word" );
+            goto parse_err;
 
-                ++rit;
-                break;
+        case PS_SetWord:
+        {
+            UCell* cell = ur_wordCellM( ut, base + pc[1] );
+            if( ! cell )
+                goto parse_err;
+            ur_setId( cell, istr->type );
+            ur_setSlice( cell, pe->inputBuf, pos, pe->inputEnd );
+            _setWord( ut, pe, cell );
+            pc += 2;
+        }
+            goto match;
 
-            case UT_BINARY:
-            case UT_STRING:
-                tval = rit;
-match_string:
+        case PS_GetWord:
+        {
+            UCell* cell = ur_wordCellM( ut, base + pc[1] );
+            if( ! cell )
+                goto parse_err;
+            if( cell->series.buf == pe->inputBuf )
             {
-                USeriesIter si;
-                USeriesIter sp;
-                int plen;
+                cell->series.end = pos;
+                _setWord( ut, pe, cell );
+            }
+            pc += 2;
+        }
+            goto match;
 
-                si.buf = istr;
-                si.it  = pos;
-                si.end = pe->inputEnd;
+        case PS_SliceStart:
+            sliceStart = pos;
+            ++pc;
+            goto match;
 
-                ur_seriesSlice( ut, &sp, tval );
-                plen = sp.end - sp.it;
+        case PS_SliceEnd:
+        {
+            UCell* cell = ur_wordCellM( ut, base + pc[1] );
+            if( ! cell )
+                goto parse_err;
+            ur_setId( cell, istr->type );
+            ur_setSlice( cell, pe->inputBuf, sliceStart, pos );
+            _setWord( ut, pe, cell );
+            pc += 2;
+        }
+            goto match;
+
+        case PS_Paren:
+        {
+            int off = PC_OFFSET;
+
+            if( UR_OK != pe->eval( ut, base + pc[1] ) )
+                goto parse_err;
+            _checkWords( ut, pe );
+            RELOAD_PC( off + 2 );
 
-                if( plen && (ur_strMatch( &si, &sp, pe->matchCase ) == plen) )
+            /* Re-acquire pointer & check if input modified. */
+            istr = pe->str = ur_buffer( pe->inputBuf );
+            if( pe->sliced )
+            {
+                // We have no way to track changes to the end of a slice,
+                // so just make sure we remain in valid memery.
+                if( istr->used < pe->inputEnd )
                 {
-                    pos += plen;
-                    ++rit;
+                    pe->inputEnd = istr->used;
+                    parseMemoInvalidate( &pe->memo );
                 }
-                else
-                    goto failed;
             }
-                break;
-
-            case UT_BITSET:
-                tval = rit;
-match_bitset:
-            if( pos >= pe->inputEnd )
-                goto failed;
+            else
             {
-                const UBuffer* bin = ur_bufferSer( tval );
-                int c = istr->ptr.c[ pos ];
-                if( bitIsSet( bin->ptr.b, c ) )
+                // Not sliced, track input end.
+                if( istr->used != pe->inputEnd )
                 {
-                    ++rit;
-                    ++pos;
+                    pe->inputEnd = istr->used;
+                    parseMemoInvalidate( &pe->memo );
                 }
-                else
-                    goto failed;
             }
-                break;
-
-            default:
-                ur_error( PARSE_ERR, "Invalid parse rule value (%s)",
-                          ur_atomCStr( ut, ur_type(rit) ) );
-                goto parse_err;
         }
-    }
-
-complete:
+            goto match;
 
-    *spos = pos;
-    return rit;
+        case PS_Error:
+            switch( pc[1] )
+            {
+                case PS_ERR_END:
+                    ur_error( PARSE_ERR, "Unexpected end of parse rule" );
+                    break;
+                case PS_ERR_PLACE:
+                    ur_error( PARSE_ERR, "place expected series word" );
+                    break;
+                case PS_ERR_SLICE:
+                    ur_error( PARSE_ERR, "slice expected word and value" );
+                    break;
+                default:
+                    ur_error( PARSE_ERR, "Invalid parse rule value (%s)",
+                              ur_atomCStr( ut, ur_type(base + pc[2]) ) );
+                    break;
+            }
+            goto parse_err;
+    }
 
 repeat:
 
-    /* Repeat rit for repMin to repMax times. */
+    /* Repeat operand for repMin to repMax times. */
 
-    if( rit == rend )
-    {
-        ur_error( PARSE_ERR, "Unexpected end of parse rule" );
-        goto parse_err;
-    }
-    else
+    repMin = pc[1];
+    repMax = pc[2];
     {
         int count;
 
-        if( ur_is(rit, UT_WORD) )
+        memo = 0;
+        if( *pc == PS_RepeatRule )
         {
-            tval = ur_wordCell( ut, rit );
-            CHECK_WORD(tval);
-        }
-        else
-        {
-            tval = rit;
+            ri = pc[3];
+            goto repeat_rule;
         }
 
+        REF_VALUE( pc[3] )
         switch( ur_type(tval) )
         {
             case UT_CHAR:
@@ -535,23 +2181,42 @@ repeat:
                 break;
 
             case UT_BLOCK:
+                if( pc[3] >= 0 )
+                {
+                    ri = -1;
+                    ri = _ruleIndex( ut, pe, tval, &ri );
+                }
+                else
+                {
+                    if( sw->ptr && sw->rule >= 0 )
+                        ri = sw->rule;
+                    else
+                        ri = _ruleIndex( ut, pe, tval, &sw->rule );
+                    memo = (pe->memo.slots != 0);
+                }
+repeat_rule:
             {
-                UBlockIt bli;
-                ur_blockIt( ut, &bli, tval );
+                int off = PC_OFFSET;
 
-                count = 0;
+                if( ! pe->ucs2 && _ruleDfa( ut, pe, ri ) >= 0 &&
+                    RULE(ri)->dfaClass >= 0 )
+                {
+                    count = _dfaRepeatClass( istr->ptr.b, pos, pe->inputEnd,
+                        repMax, (const uint8_t*)
+                                (pe->prog.ptr.i32 + RULE(ri)->dfaClass) );
+                    pos += count;
+                    RELOAD_PC( off );
+                    break;
+                }
 
+                count = 0;
                 while( count < repMax )
                 {
                     if( pos >= pe->inputEnd )
                         break;
-                    if( ! _parseStr( ut, pe, bli.it, bli.end, &pos ) )
+                    if( ! _parseSub( ut, pe, ri, &pos, memo ) )
                     {
-                        if( pe->exception == PARSE_EX_ERROR )
-                        {
-                            ur_appendTrace( ut, tval->series.buf, 0 );
-                            return 0;
-                        }
+                        SUB_RULE_ERROR( ri )
                         if( pe->exception == PARSE_EX_BREAK )
                         {
                             pe->exception = PARSE_EX_NONE;
@@ -562,35 +2227,45 @@ repeat:
                     ++count;
                 }
                 istr = pe->str;
+                RELOAD_PC( off );
             }
                 break;
 
             default:
+                if( ur_isMatcher( ut, tval ) )
+                {
+                    const UBuffer* mat = ur_bufferSer(tval);
+                    int len;
+
+                    count = 0;
+                    while( count < repMax )
+                    {
+                        len = ur_matcherMatch( mat, istr, pos, pe->inputEnd );
+                        if( ! len )
+                            break;
+                        pos += len;
+                        ++count;
+                    }
+                    break;
+                }
                 ur_error( PARSE_ERR, "Invalid parse rule" );
                 goto parse_err;
         }
 
         if( count < repMin )
             goto failed;
-        ++rit;
+        pc += 4;
     }
     goto match;
 
 failed:
 
-    // Goto next rule; search for '|'.
-
-    for( ; rit != rend; ++rit )
+    // Go to next alternative.
+    if( next )
     {
-        // It would be faster to check atom first.  This test will fail more
-        // often, but the word.atom is not currently guaranteed to be in
-        // intialized memory, causing memory checker errors. 
-        if( ur_is(rit, UT_WORD) && (ur_atom(rit) == UR_ATOM_BAR) )
-        {
-            ++rit;
-            pos = *spos;
-            goto match;
-        }
+        pc = pe->prog.ptr.i32 + next;
+        pos = *spos;
+        goto match;
     }
     return 0;
 
@@ -601,6 +2276,204 @@ parse_err:
 }
 
 
+//----------------------------------------------------------------------------
+// Compiled rule cache
+/*
+  Compiling the rules (and building DFAs) costs more than parsing a short
+  string, so the compiled program is kept for each thread and reused when
+  the same rule block is parsed again.
+
+  Before reuse every rule block is compared with the copy made when it was
+  compiled, and _wordsChanged() picks up any words which have changed.
+*/
+
+
+#define STRING_CACHE_SLOTS  4
+
+typedef struct
+{
+    UIndex   blkN;          // Top rule block or UR_INVALID_BUF if unused.
+    int      matchCase;
+    int32_t  version;
+    UBuffer  prog;
+    UBuffer  table;
+    UBuffer  words;
+    UBuffer  guards;
+    UBuffer  snap;
+}
+StringCacheSlot;
+
+typedef struct
+{
+    StringCacheSlot slot[ STRING_CACHE_SLOTS ];
+    int next;               // Slot to replace when all are used.
+}
+StringCache;
+
+
+static void _parserFree( UThread* ut, StringParser* pe )
+{
+    StringWord* sw  = WORD(0);
+    StringWord* end = sw + pe->words.used;
+    for( ; sw != end; ++sw )
+        ur_arrFree( &sw->text );
+
+    parseRuleRelease( ut, &pe->table );
+    ur_arrFree( &pe->prog );
+    ur_arrFree( &pe->table );
+    ur_arrFree( &pe->words );
+    ur_arrFree( &pe->guards );
+    ur_arrFree( &pe->snap );
+}
+
+
+#define SLOT_TO_PARSER(sl,pe) \
+    pe->prog   = sl->prog; \
+    pe->table  = sl->table; \
+    pe->words  = sl->words; \
+    pe->guards = sl->guards; \
+    pe->snap   = sl->snap; \
+    pe->version = sl->version
+
+#define PARSER_TO_SLOT(pe,sl) \
+    sl->prog   = pe->prog; \
+    sl->table  = pe->table; \
+    sl->words  = pe->words; \
+    sl->guards = pe->guards; \
+    sl->snap   = pe->snap; \
+    sl->version = pe->version
+
+
+/*
+  Move compiled rules for blkN from the cache to the parser.
+  The slot is left empty while in use so that a nested parse with the same
+  rules does not share it.
+
+  \return Non-zero if found.
+*/
+static int _cacheTake( UThread* ut, StringParser* pe, UIndex blkN )
+{
+    StringCache* cache = (StringCache*) ut->parseCache;
+    StringCacheSlot* sl;
+    StringCacheSlot* send;
+    const StringRule* rule;
+    const StringRule* rend;
+
+    if( ! cache )
+        return 0;
+    sl   = cache->slot;
+    send = sl + STRING_CACHE_SLOTS;
+    for( ; sl != send; ++sl )
+    {
+        if( sl->blkN == blkN && sl->matchCase == pe->matchCase )
+            goto found;
+    }
+    return 0;
+
+found:
+    SLOT_TO_PARSER(sl, pe);
+    sl->blkN = UR_INVALID_BUF;
+    pe->cacheSlot = sl - cache->slot;
+
+    rule = RULE(0);
+    rend = rule + pe->table.used;
+    for( ; rule != rend; ++rule )
+    {
+        if( ! parseRuleUnchanged( ut, &pe->snap, &rule->key ) )
+        {
+            _parserFree( ut, pe );
+            return 0;
+        }
+    }
+
+    // The rule blocks were checked above so only the words remain.
+    if( _wordsChanged( ut, pe ) )
+        ++pe->version;
+    return 1;
+}
+
+
+static void _cacheFreeSlot( UThread* ut, StringCacheSlot* sl )
+{
+    StringParser p;
+    if( sl->blkN != UR_INVALID_BUF )
+    {
+        StringParser* pe = &p;
+        SLOT_TO_PARSER(sl, pe);
+        _parserFree( ut, pe );
+        sl->blkN = UR_INVALID_BUF;
+    }
+}
+
+
+static void _cachePut( UThread* ut, StringParser* pe, UIndex blkN )
+{
+    StringCache* cache = (StringCache*) ut->parseCache;
+    StringCacheSlot* sl;
+    int i;
+
+    if( ! cache )
+    {
+        cache = (StringCache*) memAlloc( sizeof(StringCache) );
+        for( i = 0; i < STRING_CACHE_SLOTS; ++i )
+            cache->slot[ i ].blkN = UR_INVALID_BUF;
+        cache->next = 0;
+        ut->parseCache = cache;
+    }
+
+    // Return the rules to the slot they came from if a nested parse has
+    // not used it.  Otherwise replace any other copy of these rules, or use
+    // an empty slot if possible.
+    i = pe->cacheSlot;
+    if( i >= 0 && cache->slot[ i ].blkN == UR_INVALID_BUF )
+        goto put;
+    for( i = 0; i < STRING_CACHE_SLOTS; ++i )
+    {
+        sl = cache->slot + i;
+        if( sl->blkN == blkN && sl->matchCase == pe->matchCase )
+            break;
+    }
+    if( i == STRING_CACHE_SLOTS )
+    {
+        for( i = 0; i < STRING_CACHE_SLOTS; ++i )
+        {
+            if( cache->slot[ i ].blkN == UR_INVALID_BUF )
+                break;
+        }
+    }
+    if( i == STRING_CACHE_SLOTS )
+    {
+        i = cache->next;
+        cache->next = (i + 1) % STRING_CACHE_SLOTS;
+    }
+
+put:
+    sl = cache->slot + i;
+    _cacheFreeSlot( ut, sl );
+    PARSER_TO_SLOT(pe, sl);
+    sl->blkN = blkN;
+    sl->matchCase = pe->matchCase;
+}
+
+
+/*
+  Free the compiled rule cache of a thread.  This must be called before the
+  thread data store is frozen or destroyed.
+*/
+void ur_parseStringFreeCache( UThread* ut )
+{
+    StringCache* cache = (StringCache*) ut->parseCache;
+    int i;
+    if( cache )
+    {
+        for( i = 0; i < STRING_CACHE_SLOTS; ++i )
+            _cacheFreeSlot( ut, cache->slot + i );
+        memFree( cache );
+        ut->parseCache = 0;
+    }
+}
+
+
 /** \defgroup urlan_dsl  Domain Languages
   \ingroup urlan
   These are small, special purpose evaluators.
@@ -619,18 +2492,22 @@ parse_err:
   \param end        Ending character in input.
   \param parsePos   Index in input where parse ended.
   \param ruleBlk    Rules in the parse language.  This block must be held
-                    and remain unchanged during the parsing.
+                    and remain unchanged during the parsing.  The rules are
+                    compiled as they are used, so sub-rule blocks must not
+                    be modified in place during the parsing either.
   \param eval       Evaluator callback to do paren values in rule.
                     The callback must return UR_OK/UR_THROW.
-  \param matchCase  Use character case when comparing strings.
+  \param opt        Mask of UR_PARSE_CASE (use character case when comparing
+                    strings) & UR_PARSE_MEMO (memoize named sub-rules).
 
   \return UR_OK or UR_THROW.
 */
 UStatus ur_parseString( UThread* ut, UBuffer* str, UIndex start, UIndex end,
                         UIndex* parsePos, const UBuffer* ruleBlk,
-                        UStatus (*eval)(UThread*, const UCell*), int matchCase )
+                        UStatus (*eval)(UThread*, const UCell*), int opt )
 {
     StringParser p;
+    UIndex blkN;
 
     p.eval = eval;
     p.str  = str;
@@ -638,12 +2515,53 @@ UStatus ur_parseString( UThread* ut, UBuffer* str, UIndex start, UIndex end,
     p.inputEnd  = end;
     p.sliced    = (end != str->used);
     p.exception = PARSE_EX_NONE;
-    p.matchCase = matchCase ? UR_FIND_CASE : 0;
+    p.matchCase = (opt & UR_PARSE_CASE) ? UR_FIND_CASE : 0;
     p.ucs2      = (str->type == UT_STRING) && ur_strIsUcs2(str);
+    p.cacheSlot = -1;
+    p.sliceAtom = UR_INVALID_ATOM;
+    parseMemoInit( &p.memo, opt & UR_PARSE_MEMO );
+
+    // Only rules in thread storage are cached.
+    blkN = ruleBlk - ut->dataStore.ptr.buf;
+    if( blkN <= 0 || blkN >= ut->dataStore.used )
+        blkN = UR_INVALID_BUF;
+
+    if( blkN == UR_INVALID_BUF || ! _cacheTake( ut, &p, blkN ) )
+    {
+        UBuffer* table = &p.table;
+        StringRule* rule;
+
+        ur_arrInit( &p.prog, sizeof(int32_t), 64 );
+        ur_arrInit( table, sizeof(StringRule), 8 );
+        ur_arrInit( &p.words, sizeof(StringWord), 8 );
+        ur_arrInit( &p.guards, sizeof(StringGuard), 16 );
+        ur_arrInit( &p.snap, 1, 0 );
+        p.version = 0;
+
+        ur_arrExpand1( StringRule, table, rule );
+        parseRuleRoot( &rule->key, ruleBlk, blkN );
+        rule->pc      = -1;
+        rule->guard   = -1;
+        rule->version = -2;
+        rule->dfaVersion = -2;
+        rule->dfaBuilds  = 0;
+        if( blkN != UR_INVALID_BUF )
+        {
+            rule->key.hold = ur_hold( blkN );
+            parseRuleSnap( ut, &p.snap, &rule->key );
+        }
+    }
 
     *parsePos = start;
-    _parseStr( ut, &p, ruleBlk->ptr.cell,
-                       ruleBlk->ptr.cell + ruleBlk->used, parsePos );
+    _parseSub( ut, &p, 0, parsePos, 0 );
+
+    // Keep the compiled rules for the next parse unless they could not
+    // be compiled.
+    if( blkN == UR_INVALID_BUF || p.exception == PARSE_EX_ERROR )
+        _parserFree( ut, &p );
+    else
+        _cachePut( ut, &p, blkN );
+    parseMemoFree( &p.memo );
     return (p.exception == PARSE_EX_ERROR) ? UR_THROW : UR_OK;
 }
 
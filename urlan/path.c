@@ -197,7 +197,11 @@ UStatus ur_setPath( UThread* ut, const UCell* path, const UCell* src )
             {
                 if( ! (buf = ur_bufferSerM(last)) )
                     return UR_THROW;
-                index += last->series.it;
+                if( ur_isStringType(type) && ur_strIsUtf8(buf) )
+                    index = ur_strCharPos( ut, buf, index +
+                                ur_strCharIndex( ut, buf, last->series.it ) );
+                else
+                    index += last->series.it;
                 ((USeriesType*) ut->types[ type ])->poke( buf, index, src );
                 return UR_OK;
             }
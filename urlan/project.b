@@ -48,6 +48,7 @@ shlib %urlan [
         %string.c
         %context.c
         %gc.c
+        %matcher.c
         %serialize.c
         %tokenize.c
         %bignum.c
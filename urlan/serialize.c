@@ -1097,17 +1097,9 @@ unser_block:
             ur_ctxInit( buf, used );
             if( used )
             {
-#define ENTRIES(buf)    ((UAtomEntry*) (buf->ptr.cell + ur_avail(buf)))
                 int ai;
-                uint32_t an;
-                UAtomEntry* ent = ENTRIES(buf);
-
-                for( ai = 0; ai < used; ++ai, ++ent )
-                {
-                    an = _unpackU32(&bi);
-                    ent->atom  = atoms.ptr.u16[ an ];
-                    ent->index = ai;
-                }
+                for( ai = 0; ai < used; ++ai )
+                    ur_ctxAppendWord( buf, atoms.ptr.u16[ _unpackU32(&bi) ] );
 
                 ur_ctxSort( buf );
                 goto unser_block;
@@ -21,16 +21,15 @@
     type        UT_STRING
     elemSize    1 or 2
     form        UR_ENC_*
-    flags       UR_STRING_ENC_UP
-    used        Number of characters used
+    flags       UR_STRING_ENC_UP, UR_STRING_INDEXED
+    used        Number of characters (bytes for UR_ENC_UTF8) used
     ptr.b/.u16  Character data
-    ptr.i[-1]   Number of characters available
+    ptr.i[-1]   Number of characters (bytes for UR_ENC_UTF8) available
 
 */
 
 
-#include "urlan.h"
-#include "os.h"
+#include "env.h"
 #include "mem_util.h"
 
 #include "ucs2_case.c"
@@ -47,11 +46,12 @@
   \ingroup urlan
 
   Strings are stored using the single word per character Latin-1 and UCS-2
-  encodings (UR_ENC_LATIN1/UR_ENC_UCS2).
+  encodings (UR_ENC_LATIN1/UR_ENC_UCS2), or as variable width UTF-8
+  (UR_ENC_UTF8).
 
-  UTF-8 (UR_ENC_UTF8) is only handled by ur_strAppend() and
-  ur_makeStringUtf8() in order to bring UTF-8 strings into or out of the
-  datatype system.
+  The positions of a UTF-8 string are byte offsets on character boundaries.
+  Use ur_strCharIndex() & ur_strCharPos() to convert them to and from
+  character indexes.
 
   @{
 */
@@ -179,18 +179,82 @@ make_ucs2:
 }
 
 
+/*
+   Return number of continuation bytes which follow a UTF-8 lead byte, or -1
+   for a stray continuation byte.
+*/
+static inline int _utf8Trail( int c )
+{
+    if( c < 0xc0 )
+        return (c < 0x80) ? 0 : -1;
+    if( c < 0xe0 )
+        return 1;
+    if( c < 0xf0 )
+        return 2;
+    return (c < 0xf8) ? 3 : 0;
+}
+
+
+/*
+   Decode a multi-byte UTF-8 character.  The lead byte c has been read and
+   *pit points to the continuation bytes, which are skipped over.
+
+   Returns the character, -1 for a stray continuation byte, or -2 if the
+   sequence is cut off by end.
+*/
+static inline int _utf8Decode( int c, const uint8_t** pit, const uint8_t* end )
+{
+    const uint8_t* it = *pit;
+    int n = _utf8Trail( c );
+
+    if( n < 0 )
+        return -1;
+    if( n > end - it )
+        return -2;
+    switch( n )
+    {
+        case 0:
+            c = NOT_LATIN1_CHAR;
+            break;
+        case 1:
+            c = ((c & 0x1f) << 6) | (it[0] & 0x3f);
+            break;
+        case 2:
+            c = ((c & 0x0f) << 12) | ((it[0] & 0x3f) << 6) | (it[1] & 0x3f);
+            break;
+        default:
+            c = ((c & 0x07) << 18) | ((it[0] & 0x3f) << 12) |
+                ((it[1] & 0x3f) << 6) | (it[2] & 0x3f);
+            break;
+    }
+    *pit = it + n;
+    return c;
+}
+
+
 /*
    Return character count and highest value in a UTF-8 string.
 */
 static int _statUtf8( const uint8_t* it, const uint8_t* end, int* highRes )
 {
+    const uint8_t* run;
     int high = 0;
     int len = 0;
     int  ch;
 
     while( it != end )
     {
-        ch = *it++;
+        ch = *it;
+        if( ch <= 0x7f && ch != '^' )   // Run of plain ASCII
+        {
+            run = span_ascii( it, end, '^' );
+            len += run - it;
+            it = run;
+            if( high < 0x7f )
+                high = 0x7f;
+            continue;
+        }
+        ++it;
         if( ch <= 0x7f )                // A single byte
         {
             if( ch == '^' )
@@ -200,51 +264,13 @@ static int _statUtf8( const uint8_t* it, const uint8_t* end, int* highRes )
                     ch = ur_caretChar( it, end, &it );
             }
         }
-        else if( (ch & 0xf0) == 0xf0 )
-        {
-            if( ch >= 0xfc )            // 6 bytes
-            {
-                if( (end - it) < 5 )
-                    break;
-                ch = ((ch    & 0x01) << 30) |
-                     ((it[0] & 0x3f) << 24) |
-                     ((it[1] & 0x3f) << 18);
-                it += 2;
-            }
-            else if( ch >= 0xf8 )       // 5 bytes
-            {
-                if( (end - it) < 4 )
-                    break;
-                ch = ((ch    & 0x03) << 24) |
-                     ((it[0] & 0x3f) << 18);
-                it += 1;
-            }
-            else                        // 4 bytes
-            {
-                if( (end - it) < 3 )
-                    break;
-                ch = (ch & 0x07) << 18;
-            }
-            ch += ((it[0] & 0x3f) << 12) |
-                  ((it[1] & 0x3f) <<  6) |
-                   (it[2] & 0x3f);
-            it += 3;
-        }
-        else if( ch >= 0xe0 )           // 3 bytes
-        {
-            if( (end - it) < 2 )
-                break;
-            ch = ((ch    & 0x0f) << 12) |
-                 ((it[0] & 0x3f) <<  6) |
-                  (it[1] & 0x3f);
-            it += 2;
-        }
-        else                            // 2 bytes
+        else
         {
-            if( it == end )
-                break;
-            ch = ((ch & 0x1f) << 6) | (*it & 0x3f);
-            ++it;
+            ch = _utf8Decode( ch, &it, end );
+            if( ch == -1 )
+                continue;           // Skip stray continuation byte.
+            if( ch == -2 )
+                break;              // Drop incomplete multi-byte char.
         }
 
         ++len;
@@ -266,30 +292,34 @@ static void _convertString2( UBuffer* str, const uint8_t* it, const uint8_t* end
 {
     uint16_t  ch;
     uint16_t* out = str->ptr.u16 + str->used;
+    int n;
 
     while( it != end )
     {
-        ch = *it++;
+        ch = *it;
+        if( ch <= 0x7f && ch != '^' )
+        {
+            n = copy_ascii_8_16( out, it, end, '^' );
+            it  += n;
+            out += n;
+            continue;
+        }
+        ++it;
         if( ch <= 0x7f )
         {
             if( ch == '^' && it != end )
                 ch = ur_caretChar( it, end, &it );
-            *out++ = ch;
         }
-        else if( ch >= 0xc2 && ch <= 0xdf )
-        {
-            if( it == end )
-                break;
-            *out++ = ((ch & 0x1f) << 6) | (*it & 0x3f);
-            ++it;
-        }
-        else if( ch >= 0xe0 )
+        else
         {
-            if( (end - it) < 2 )
+            n = _utf8Decode( ch, &it, end );
+            if( n == -1 )
+                continue;
+            if( n == -2 )
                 break;
-            *out++ = ((ch & 0x0f) << 12) | ((it[0] & 0x3f) << 6) | (it[1] & 0x3f);
-            it += 2;
+            ch = n;
         }
+        *out++ = ch;
     }
 
     str->used = out - str->ptr.u16;
@@ -355,13 +385,23 @@ void ur_strInitUtf8( UBuffer* buf, const uint8_t* it, const uint8_t* end )
 
         while( it != end )
         {
-            ch = *it++;
+            ch = *it;
+            if( ch <= 0x7f && ch != '^' )
+            {
+                const uint8_t* run = span_ascii( it, end, '^' );
+                memCpy( out, it, run - it );
+                out += run - it;
+                it = run;
+                continue;
+            }
+            ++it;
             if( ch > 0x7f )
             {
-                if( it == end )
+                ch = _utf8Decode( ch, &it, end );
+                if( ch == -1 )
+                    continue;                       // Skip stray continuation.
+                if( ch == -2 )
                     break;                          // Drop incomplete multi-byte char.
-                ch = ((ch & 0x1f) << 6) | (*it & 0x3f);
-                ++it;
             }
             else if( ch == '^' && it != end )
             {
@@ -383,6 +423,15 @@ void ur_strInitUtf8( UBuffer* buf, const uint8_t* it, const uint8_t* end )
 
         while( it != end )
         {
+            const uint8_t* run = find_uint8_t( it, end, '^' );
+            if( ! run )
+                run = end;
+            memCpy( out, it, run - it );
+            out += run - it;
+            it = run;
+            if( it == end )
+                break;
+
             ch = *it++;
             if( ch == '^' && it != end )
             {
@@ -441,17 +490,23 @@ int copyLatin1ToUtf8( uint8_t* dest, const uint8_t* src, int srcLen )
     // TODO: Prevent overflow of dest.
     const uint8_t* dStart = dest;
     const uint8_t* end = src + srcLen;
+    const uint8_t* run;
     uint8_t c;
 
     while( src != end )
     {
-        c = *src++;
-        if( c > 127 )
+        c = *src;
+        if( c <= 127 )
         {
-            *dest++ = 0xC0 | (c >> 6);
-            c = 0x80 | (c & 0x3f);
+            run = span_ascii( src, end, 0x80 );
+            memCpy( dest, src, run - src );
+            dest += run - src;
+            src = run;
+            continue;
         }
-        *dest++ = c;
+        ++src;
+        *dest++ = 0xC0 | (c >> 6);
+        *dest++ = 0x80 | (c & 0x3f);
     }
     return dest - dStart;
 }
@@ -476,26 +531,37 @@ int copyUtf8ToLatin1( uint8_t* dest, const uint8_t* src, int srcLen )
 {
     const uint8_t* dStart = dest;
     const uint8_t* end = src + srcLen;
+    const uint8_t* run;
     uint16_t c;
+    int n;
 
     while( src != end )
     {
-        c = *src++;
-        if( c > 0x7f )
+        c = *src;
+        if( c <= 0x7f )
         {
-            if( c <= 0xdf )
-            {
-                c = ((c & 0x1f) << 6) | (*src & 0x3f);
-                if( c < 256 )
-                {
-                    // The UTF-8 value is in the Latin-1 range.
-                    ++src;
-                    goto output_char;
-                }
-            }
-            c = NOT_LATIN1_CHAR;
+            // Dest may equal src when converting in place.
+            run = span_ascii( src, end, 0x80 );
+            memmove( dest, src, run - src );
+            dest += run - src;
+            src = run;
+            continue;
+        }
+        ++src;
+        n = _utf8Trail( c );
+        if( n < 0 )
+            continue;
+        if( n > end - src )
+            break;                  // Drop incomplete multi-byte char.
+        if( n == 1 )
+        {
+            c = ((c & 0x1f) << 6) | (*src & 0x3f);
+            if( c > 255 )
+                c = NOT_LATIN1_CHAR;
         }
-output_char:
+        else
+            c = NOT_LATIN1_CHAR;
+        src += n;
         *dest++ = (uint8_t) c;
     }
     return dest - dStart;
@@ -513,33 +579,39 @@ output_char:
   0x0000-0x007f  0xxxxxxx
   0x0080-0x07ff  110xxxxx  10xxxxxx
   0x0800-0xffff  1110xxxx  10xxxxxx  10xxxxxx
+
+  Characters outside the UCS2 range are replaced with NOT_LATIN1_CHAR.
 */
 int copyUtf8ToUcs2( uint16_t* dest, const uint8_t* src, int srcLen )
 {
     const uint16_t* dStart = dest;
     const uint8_t* end = src + srcLen;
     uint16_t c;
+    int n;
 
     while( src != end )
     {
-        c = *src++;
-        if( c > 0x7f )
+        c = *src;
+        if( c <= 0x7f )
         {
-            if( (c & 0xe0) == 0xc0 )
-            {
-                c = (c & 0x1f) << 6 | (src[0] & 0x3f);
-                ++src;
-            }
-            else if( (c & 0xf0) == 0xe0 )
-            {
-                c = (c & 0x0f) << 12 | (src[0] & 0x3f) << 6 | (src[1] & 0x3f);
-                src += 2;
-            }
-            else if( (c & 0xc0) == 0x80 )
-                continue;
-            else
-                c = NOT_LATIN1_CHAR;
+            n = copy_ascii_8_16( dest, src, end, 0x80 );
+            src  += n;
+            dest += n;
+            continue;
         }
+        ++src;
+        n = _utf8Trail( c );
+        if( n < 0 )
+            continue;
+        if( n > end - src )
+            break;                  // Drop incomplete multi-byte char.
+        if( n == 1 )
+            c = (c & 0x1f) << 6 | (src[0] & 0x3f);
+        else if( n == 2 )
+            c = (c & 0x0f) << 12 | (src[0] & 0x3f) << 6 | (src[1] & 0x3f);
+        else
+            c = NOT_LATIN1_CHAR;
+        src += n;
         *dest++ = c;
     }
     return dest - dStart;
@@ -576,35 +648,39 @@ int copyUcs2ToUtf8( uint8_t* dest, const uint16_t* src, int srcLen )
     const uint8_t* dStart;
     const uint16_t* end;
     uint16_t c;
+    int n;
 
     dStart = dest;
     end = src + srcLen;
 
     while( src != end )
     {
-        c = *src++;
-        if( c > 127 )
+        c = *src;
+        if( c <= 127 )
         {
-            if( c > 0x07ff )
-            {
-                *dest++ = 0xE0 | (c >> 12);
-                *dest++ = 0x80 | ((c >> 6) & 0x3f);
-                c = 0x80 | (c & 0x3f);
-            }
-            else
-            {
-                *dest++ = 0xC0 | (c >> 6);
-                c = 0x80 | (c & 0x3f);
-            }
+            n = copy_ascii_16_8( dest, src, end );
+            src  += n;
+            dest += n;
+            continue;
         }
-        *dest++ = (uint8_t) c;
+        ++src;
+        if( c > 0x07ff )
+        {
+            *dest++ = 0xE0 | (c >> 12);
+            *dest++ = 0x80 | ((c >> 6) & 0x3f);
+        }
+        else
+        {
+            *dest++ = 0xC0 | (c >> 6);
+        }
+        *dest++ = 0x80 | (c & 0x3f);
     }
     return dest - dStart;
 }
 
 
 /**
-  Append a single UCS2 character to a string.
+  Append a single character to a string.
 */
 void ur_strAppendChar( UBuffer* str, int uc )
 {
@@ -617,11 +693,8 @@ void ur_strAppendChar( UBuffer* str, int uc )
             break;
 
         case UR_ENC_UTF8:
-        {
-            uint16_t n = uc;
-            ur_arrReserve( str, str->used + 3 );
-            str->used += copyUcs2ToUtf8( str->ptr.b + str->used, &n, 1 );
-        }
+            ur_arrReserve( str, str->used + 4 );
+            str->used = _emitUtf8( str->ptr.b + str->used, uc ) - str->ptr.b;
             break;
 
         case UR_ENC_UCS2:
@@ -950,7 +1023,7 @@ redo:
                 str->used += usedB;
                 break;
             case UR_ENC_UCS2:
-                ur_arrReserve( str, str->used + usedB*2 );
+                ur_arrReserve( str, str->used + usedB*3 );
                 dest = str->ptr.b + str->used;
                 str->used += copyUcs2ToUtf8( dest, strB->ptr.u16 + itB, usedB );
                 break;
@@ -1068,13 +1141,9 @@ int ur_strIsAscii( const UBuffer* str )
         case UR_ENC_LATIN1:
         case UR_ENC_UTF8:
         {
-            const uint8_t* it  = str->ptr.b;
-            const uint8_t* end = it + str->used;
-            while( it != end )
-            {
-                if( *it++ > 0x7f )
-                    return 0;
-            }
+            const uint8_t* end = str->ptr.b + str->used;
+            if( span_ascii( str->ptr.b, end, 0x80 ) != end )
+                return 0;
         }
             break;
 
@@ -1111,22 +1180,22 @@ void ur_strFlatten( UBuffer* str )
             const uint8_t* end = it + str->used;
             while( it != end )
             {
+                it = span_ascii( it, end, 0x80 );
+                if( it == end )
+                    break;
                 ch = *it++;
-                if( ch > 0x7f )
+                if( ch <= 0xdf && (it != end) )
                 {
-                    if( ch <= 0xdf && (it != end) )
+                    ch = ((ch & 0x1f) << 6) | (*it & 0x3f);
+                    if( ch < 256 )
                     {
-                        ch = ((ch & 0x1f) << 6) | (*it & 0x3f);
-                        if( ch < 256 )
-                        {
-                            if( ! convert )
-                                convert = (uint8_t*) it - 1;
-                            ++it;
-                            continue;
-                        }
+                        if( ! convert )
+                            convert = (uint8_t*) it - 1;
+                        ++it;
+                        continue;
                     }
-                    return;
                 }
+                return;
             }
 
             if( convert )
@@ -1178,22 +1247,14 @@ void ur_strLowercase( UBuffer* buf, UIndex start, UIndex send )
     switch( buf->form )
     {
         case UR_ENC_LATIN1:
-        {
-            uint8_t* it  = buf->ptr.b + start;
-            uint8_t* end = buf->ptr.b + send;
-            while( it != end )
-            {
-                *it = ur_charLowercase( *it );
-                ++it;
-            }
-        }
+            lowercase_latin1( buf->ptr.b + start, buf->ptr.b + send );
             break;
 
         case UR_ENC_UCS2:
         {
             uint16_t* it  = buf->ptr.u16 + start;
             uint16_t* end = buf->ptr.u16 + send;
-            while( it != end )
+            while( (it = lowercase_latin1_16( it, end )) != end )
             {
                 *it = ur_charLowercase( *it );
                 ++it;
@@ -1216,22 +1277,14 @@ void ur_strUppercase( UBuffer* buf, UIndex start, UIndex send )
     switch( buf->form )
     {
         case UR_ENC_LATIN1:
-        {
-            uint8_t* it  = buf->ptr.b + start;
-            uint8_t* end = buf->ptr.b + send;
-            while( it != end )
-            {
-                *it = ur_charUppercase( *it );
-                ++it;
-            }
-        }
+            uppercase_latin1( buf->ptr.b + start, buf->ptr.b + send );
             break;
 
         case UR_ENC_UCS2:
         {
             uint16_t* it  = buf->ptr.u16 + start;
             uint16_t* end = buf->ptr.u16 + send;
-            while( it != end )
+            while( (it = uppercase_latin1_16( it, end )) != end )
             {
                 *it = ur_charUppercase( *it );
                 ++it;
@@ -1242,13 +1295,21 @@ void ur_strUppercase( UBuffer* buf, UIndex start, UIndex send )
 }
 
 
+/*
+  Lowercase conversion which avoids the function call for Latin-1.
+*/
+#define LC_uint8_t(c)   _toLowerLatin1[ c ]
+#define LC_uint16_t(c)  (((c) < 0x100) ? _toLowerLatin1[ c ] \
+                                       : ur_charLowercase( c ))
+
+
 /*
   Returns pointer to val or zero if val not found.
 */
 #define FIND_LC(T) \
 const T* find_lc_ ## T( const T* it, const T* end, T val ) { \
     while( it != end ) { \
-        if( ur_charLowercase(*it) == val ) \
+        if( LC_ ## T(*it) == val ) \
             return it; \
         ++it; \
     } \
@@ -1266,7 +1327,7 @@ FIND_LC(uint16_t)
 const T* find_lc_last_ ## T( const T* it, const T* end, T val ) { \
     while( it != end ) { \
         --end; \
-        if( ur_charLowercase(*end) == val ) \
+        if( LC_ ## T(*end) == val ) \
             return end; \
     } \
     return 0; \
@@ -1292,7 +1353,25 @@ UIndex ur_strFindChar( const UBuffer* str, UIndex start, UIndex end, int ch,
 {
     int matchCase = (opt & UR_FIND_CASE) || (ch < 'A');
 
-    if( IS_UCS2_STRING(str) )
+    if( ch > 0x7f && ur_strIsUtf8(str) && ur_isStringType(str->type) )
+    {
+        // Search for the encoded character (case is always matched).
+        uint8_t pat[ 4 ];
+        const uint8_t* pend = _emitUtf8( pat, ch );
+        const uint8_t* it   = str->ptr.b + start;
+        const uint8_t* send = str->ptr.b + end;
+        const uint8_t* found = 0;
+
+        while( (it = find_pattern_8( it, send, pat, pend )) )
+        {
+            found = it;
+            if( ! (opt & UR_FIND_LAST) )
+                break;
+            it += pend - pat;
+        }
+        return found ? found - str->ptr.b : -1;
+    }
+    else if( IS_UCS2_STRING(str) )
     {
         const uint16_t* (*func)( const uint16_t*, const uint16_t*, uint16_t );
         const uint16_t* it;
@@ -1412,13 +1491,14 @@ UIndex ur_strFindCharsRev( const UBuffer* str, UIndex start, UIndex end,
 #define FIND_PATTERN_IC(N,T,P) \
 const T* find_pattern_ic_ ## N( const T* it, const T* end, \
         const P* pit, const P* pend ) { \
-    int pfirst = ur_charLowercase(*pit++); \
+    int pfirst = *pit++; \
+    pfirst = LC_ ## P(pfirst); \
     while( it != end ) { \
-        if( ur_charLowercase(*it) == pfirst ) { \
+        if( LC_ ## T(*it) == pfirst ) { \
             const T* in = it + 1; \
             const P* p  = pit; \
             while( p != pend && in != end ) { \
-                if( ur_charLowercase(*in) != ur_charLowercase(*p) ) \
+                if( LC_ ## T(*in) != LC_ ## P(*p) ) \
                     break; \
                 ++in; \
                 ++p; \
@@ -1437,6 +1517,234 @@ FIND_PATTERN_IC(8_16,uint8_t,uint16_t)
 FIND_PATTERN_IC(16_8,uint16_t,uint8_t)
 
 
+/*
+  Two-Way string matching (Crochemore & Perrin) with a Horspool style
+  shift on the last character of the window.  This runs in linear time for
+  any pattern, unlike the simple loops above which are O(n*m) in the worst
+  case.
+
+  The pattern is converted to 16-bit characters with any case folding
+  applied.  For reverse searches the pattern is stored backwards and the
+  haystack is read from the end.  The shift table is indexed by the low
+  8 bits of the character, which keeps it small for UCS-2 while still
+  giving a safe (if shorter) shift when characters collide.
+*/
+#define TW_LOCAL        64
+#define TW_MIN_PATTERN  3
+#define TW_MIN_HAYSTACK 64
+#define TW_MIN_VECTOR   32
+
+typedef struct
+{
+    uint16_t* pat;
+    int len;
+    int ms;         // Critical position - 1
+    int period;
+    int mem0;       // Memory after a period shift (zero if not periodic).
+    uint8_t cmask[32];
+    int shift[256];
+    uint16_t local[ TW_LOCAL ];
+}
+TwoWay;
+
+
+static int _twoWayMaxSuffix( const uint16_t* n, int l, int rev, int* period )
+{
+    int ip = -1;
+    int jp = 0;
+    int k = 1;
+    int p = 1;
+    int a, b;
+
+    while( jp + k < l )
+    {
+        a = n[ip + k];
+        b = n[jp + k];
+        if( a == b )
+        {
+            if( k == p )
+            {
+                jp += p;
+                k = 1;
+            }
+            else
+                ++k;
+        }
+        else if( rev ? (a < b) : (a > b) )
+        {
+            jp += k;
+            k = 1;
+            p = jp - ip;
+        }
+        else
+        {
+            ip = jp++;
+            k = p = 1;
+        }
+    }
+    *period = p;
+    return ip;
+}
+
+
+static void _twoWayInit( TwoWay* tw, const USeriesIter* si, int fold, int rev )
+{
+    const UBuffer* buf = si->buf;
+    uint16_t* n;
+    int l = si->end - si->it;
+    int i, c, p, p2, ms, ms2;
+
+    n = tw->pat = (l > TW_LOCAL) ? (uint16_t*) memAlloc( l * sizeof(uint16_t) )
+                                 : tw->local;
+    tw->len = l;
+    for( i = 0; i < l; ++i )
+    {
+        c = IS_UCS2_STRING(buf) ? buf->ptr.u16[ si->it + i ]
+                                : buf->ptr.b[ si->it + i ];
+        if( fold )
+            c = ur_charLowercase( c );
+        n[ rev ? l - 1 - i : i ] = c;
+    }
+
+    memset( tw->cmask, 0, sizeof(tw->cmask) );
+    for( i = 0; i < l; ++i )
+    {
+        c = n[i] & 255;
+        tw->cmask[ c >> 3 ] |= 1 << (c & 7);
+        tw->shift[ c ] = i + 1;
+    }
+
+    ms  = _twoWayMaxSuffix( n, l, 0, &p );
+    ms2 = _twoWayMaxSuffix( n, l, 1, &p2 );
+    if( ms2 > ms )
+    {
+        ms = ms2;
+        p  = p2;
+    }
+
+    if( memcmp( n, n + p, (ms + 1) * sizeof(uint16_t) ) )
+    {
+        tw->mem0 = 0;
+        p = ((ms > l - ms - 1) ? ms : l - ms - 1) + 1;
+    }
+    else
+        tw->mem0 = l - p;
+    tw->ms = ms;
+    tw->period = p;
+}
+
+
+static void _twoWayFree( TwoWay* tw )
+{
+    if( tw->pat != tw->local )
+        memFree( tw->pat );
+}
+
+
+#define TW_NOFOLD(c)    (c)
+
+/*
+  Returns first (DIR 1) or last (DIR -1) occurance of pattern or 0 if it
+  is not found.
+*/
+#define TWO_WAY(N,T,FOLD,DIR) \
+static const T* two_way_ ## N( const T* it, const T* end, const TwoWay* tw ) { \
+    const uint16_t* n = tw->pat; \
+    const T* h = (DIR > 0) ? it : end; \
+    const T* z = (DIR > 0) ? end : it; \
+    int l = tw->len; \
+    int ms = tw->ms; \
+    int k, c; \
+    int mem = 0; \
+    for(;;) { \
+        if( ((DIR > 0) ? z - h : h - z) < l ) \
+            return 0; \
+        c = FOLD( TW_AT(l - 1) ); \
+        if( tw->cmask[ (c & 255) >> 3 ] & (1 << (c & 7)) ) { \
+            k = l - tw->shift[ c & 255 ]; \
+            if( k ) { \
+                if( k < mem ) \
+                    k = mem; \
+                h += DIR * k; \
+                mem = 0; \
+                continue; \
+            } \
+        } else { \
+            h += DIR * l; \
+            mem = 0; \
+            continue; \
+        } \
+        for( k = (ms + 1 > mem) ? ms + 1 : mem; \
+             k < l && n[k] == FOLD( TW_AT(k) ); ++k ) ; \
+        if( k < l ) { \
+            h += DIR * (k - ms); \
+            mem = 0; \
+            continue; \
+        } \
+        for( k = ms + 1; k > mem && n[k - 1] == FOLD( TW_AT(k - 1) ); --k ) ; \
+        if( k <= mem ) \
+            return (DIR > 0) ? h : h - l; \
+        h += DIR * tw->period; \
+        mem = tw->mem0; \
+    } \
+}
+
+#define TW_AT(k)    h[k]
+TWO_WAY(8,uint8_t,TW_NOFOLD,1)
+TWO_WAY(16,uint16_t,TW_NOFOLD,1)
+TWO_WAY(ic_8,uint8_t,LC_uint8_t,1)
+TWO_WAY(ic_16,uint16_t,LC_uint16_t,1)
+#undef TW_AT
+#define TW_AT(k)    h[-1 - (k)]
+TWO_WAY(last_8,uint8_t,TW_NOFOLD,-1)
+TWO_WAY(last_16,uint16_t,TW_NOFOLD,-1)
+TWO_WAY(last_ic_8,uint8_t,LC_uint8_t,-1)
+TWO_WAY(last_ic_16,uint16_t,LC_uint16_t,-1)
+#undef TW_AT
+
+
+static UIndex _strFindTwoWay( const USeriesIter* ai, const USeriesIter* bi,
+                              int matchCase, int rev )
+{
+    TwoWay tw;
+    const UBuffer* bufA = ai->buf;
+    UIndex pos = -1;
+    int fold = ! matchCase;
+
+    _twoWayInit( &tw, bi, fold, rev );
+    if( IS_UCS2_STRING(bufA) )
+    {
+        const uint16_t* (*func)( const uint16_t*, const uint16_t*,
+                                 const TwoWay* );
+        const uint16_t* found;
+
+        if( rev )
+            func = fold ? two_way_last_ic_16 : two_way_last_16;
+        else
+            func = fold ? two_way_ic_16 : two_way_16;
+        found = func( bufA->ptr.u16 + ai->it, bufA->ptr.u16 + ai->end, &tw );
+        if( found )
+            pos = found - bufA->ptr.u16;
+    }
+    else
+    {
+        const uint8_t* (*func)( const uint8_t*, const uint8_t*,
+                                const TwoWay* );
+        const uint8_t* found;
+
+        if( rev )
+            func = fold ? two_way_last_ic_8 : two_way_last_8;
+        else
+            func = fold ? two_way_ic_8 : two_way_8;
+        found = func( bufA->ptr.b + ai->it, bufA->ptr.b + ai->end, &tw );
+        if( found )
+            pos = found - bufA->ptr.b;
+    }
+    _twoWayFree( &tw );
+    return pos;
+}
+
+
 /**
   Find string in another string or binary series.
 
@@ -1451,6 +1759,7 @@ UIndex ur_strFind( const USeriesIter* ai, const USeriesIter* bi,
 {
     const UBuffer* bufA = ai->buf;
     const UBuffer* bufB = bi->buf;
+    int plen = bi->end - bi->it;
     int ci = 0;
 
     if( IS_UCS2_STRING(bufA) )
@@ -1458,6 +1767,14 @@ UIndex ur_strFind( const USeriesIter* ai, const USeriesIter* bi,
     if( IS_UCS2_STRING(bufB) )
         ci += 2;
 
+    /*
+      The simple loops are fastest for short searches, and find_pattern_8/16
+      are vectorized.  Switch to Two-Way when these may become quadratic.
+    */
+    if( plen >= TW_MIN_PATTERN && (ai->end - ai->it) >= TW_MIN_HAYSTACK &&
+        (! matchCase || plen > TW_MIN_VECTOR || ci == 1 || ci == 2) )
+        return _strFindTwoWay( ai, bi, matchCase, 0 );
+
     switch( ci )
     {
         case 0:
@@ -1533,7 +1850,8 @@ UIndex ur_strFindRev( const USeriesIter* ai, const USeriesIter* bi,
     UIndex lpos = -1;
     UIndex pos;
 
-    // TODO: Implement reverse search.
+    if( bi->end > bi->it )
+        return _strFindTwoWay( ai, bi, matchCase, 1 );
 
     while( 1 )
     {
@@ -1564,8 +1882,28 @@ const P* match_pattern_ic_ ## N( const T* it, const T* end, \
     return pit; \
 }
 
-MATCH_PATTERN_IC(8,uint8_t,uint8_t)
-MATCH_PATTERN_IC(16,uint16_t,uint16_t)
+/*
+  The mismatch_ic functions fold Latin-1 letters with SIMD; only the
+  characters where they stop need the full case conversion.
+*/
+#define MATCH_PATTERN_IC_SAME(N,T) \
+const T* match_pattern_ic_ ## N( const T* it, const T* end, \
+        const T* pit, const T* pend ) { \
+    const T* pos; \
+    if( end - it < pend - pit ) \
+        pend = pit + (end - it); \
+    while( (pos = mismatch_ic_ ## N( pit, pend, it )) != pend ) { \
+        it += pos - pit; \
+        if( ur_charLowercase(*it) != ur_charLowercase(*pos) ) \
+            return pos; \
+        ++it; \
+        pit = pos + 1; \
+    } \
+    return pend; \
+}
+
+MATCH_PATTERN_IC_SAME(8,uint8_t)
+MATCH_PATTERN_IC_SAME(16,uint16_t)
 MATCH_PATTERN_IC(8_16,uint8_t,uint16_t)
 MATCH_PATTERN_IC(16_8,uint16_t,uint8_t)
 
@@ -1642,20 +1980,324 @@ UIndex ur_strMatch( const USeriesIter* ai, const USeriesIter* bi,
 }
 
 
+/*
+  UTF-8 character positions
+
+  The positions of a UR_ENC_UTF8 string are byte offsets which lie on
+  character boundaries, but the series functions count characters.
+  A character begins at the start of the string and at each byte that is
+  not a continuation byte.
+
+  Converting between the two requires a scan from the start, so for longer
+  strings the thread keeps a sparse index of the offset of every
+  UTF8_INDEX_STEP characters.  The UR_STRING_INDEXED flag is set on an
+  indexed string and cleared by ur_bufferSeriesM() when it may be modified.
+*/
+
+#define UTF8_INDEX_MIN      1024    // Minimum string size (in bytes).
+#define UTF8_INDEX_STEP     64
+#define UTF8_INDEX_SLOTS    4
+
+#define IS_UTF8_TRAIL(c)    (((c) & 0xc0) == 0x80)
+
+typedef struct
+{
+    const uint8_t* data;    // String memory when indexed or zero if unused.
+    UIndex strN;            // Indexed string (negative if shared).
+    UIndex used;            // String size when indexed.
+    UIndex chars;           // Number of characters.
+    UBuffer offset;         // Byte offset of every UTF8_INDEX_STEP character.
+}
+Utf8Index;
+
+typedef struct
+{
+    Utf8Index slot[ UTF8_INDEX_SLOTS ];
+    int next;               // Slot to replace.
+}
+Utf8IndexCache;
+
+
+/*
+  Return the number of characters which start in a range.  The first byte
+  always starts a character.
+*/
+static UIndex _utf8Count( const uint8_t* it, const uint8_t* end )
+{
+    UIndex n;
+    if( it >= end )
+        return 0;
+    n = end - it;
+    for( ++it; it != end; ++it )
+        n -= IS_UTF8_TRAIL(*it);
+    return n;
+}
+
+
+/*
+  Return pointer to the character which is *pn characters after it, or end.
+  On return *pn is the number of characters remaining past end.
+*/
+static const uint8_t* _utf8Skip( const uint8_t* it, const uint8_t* end,
+                                 UIndex* pn )
+{
+    const uint8_t* run;
+    UIndex n = *pn;
+    while( n > 0 && it != end )
+    {
+        if( *it < 0x80 )
+        {
+            run = span_ascii( it, (end - it > n) ? it + n : end, 0x80 );
+            n -= run - it;
+            it = run;
+        }
+        else
+        {
+            for( ++it; it != end && IS_UTF8_TRAIL(*it); ++it )
+                ;
+            --n;
+        }
+    }
+    *pn = n;
+    return it;
+}
+
+
+/*
+  Return the index of a string, building it if needed, or zero if the
+  string is too small or not in a data store.
+*/
+static const Utf8Index* _utf8Index( UThread* ut, const UBuffer* str )
+{
+    Utf8IndexCache* cache;
+    Utf8Index* ix;
+    const uint8_t* it;
+    const uint8_t* end;
+    UIndex n;
+    UIndex strN;
+    int i;
+
+    if( str->used < UTF8_INDEX_MIN )
+        return 0;
+
+    // Strings are keyed by buffer id as the data stores may be moved.
+    // Those in the shared store cannot be modified and so are not flagged.
+    if( str >= ut->dataStore.ptr.buf &&
+        str < ut->dataStore.ptr.buf + ut->dataStore.used )
+        strN = str - ut->dataStore.ptr.buf;
+    else if( str >= ut->sharedStoreBuf &&
+             str < ut->sharedStoreBuf + ut->env->sharedStore.used )
+        strN = -1 - (str - ut->sharedStoreBuf);
+    else
+        return 0;
+
+    cache = (Utf8IndexCache*) ut->strIndex;
+    if( cache && (strN < 0 || (str->flags & UR_STRING_INDEXED)) )
+    {
+        for( i = 0; i < UTF8_INDEX_SLOTS; ++i )
+        {
+            ix = cache->slot + i;
+            if( ix->strN == strN && ix->data == str->ptr.b &&
+                ix->used == str->used )
+                return ix;
+        }
+    }
+
+    if( ! cache )
+    {
+        cache = (Utf8IndexCache*) memAlloc( sizeof(Utf8IndexCache) );
+        for( i = 0; i < UTF8_INDEX_SLOTS; ++i )
+        {
+            cache->slot[i].data = 0;
+            ur_arrInit( &cache->slot[i].offset, sizeof(int32_t), 0 );
+        }
+        cache->next = 0;
+        ut->strIndex = cache;
+    }
+
+    // Replace any old index of this string so that it cannot be found later.
+    for( i = 0; i < UTF8_INDEX_SLOTS; ++i )
+    {
+        if( cache->slot[i].data && cache->slot[i].strN == strN )
+            break;
+    }
+    if( i == UTF8_INDEX_SLOTS )
+    {
+        i = cache->next;
+        if( ++cache->next == UTF8_INDEX_SLOTS )
+            cache->next = 0;
+    }
+    ix = cache->slot + i;
+
+    it  = str->ptr.b;
+    end = it + str->used;
+    ur_arrReserve( &ix->offset, str->used / UTF8_INDEX_STEP + 1 );
+    ix->offset.used = 0;
+    do
+    {
+        ur_arrReserve( &ix->offset, ix->offset.used + 1 );
+        ix->offset.ptr.i32[ ix->offset.used++ ] = it - str->ptr.b;
+        n = UTF8_INDEX_STEP;
+        it = _utf8Skip( it, end, &n );
+    }
+    while( it != end );
+
+    i = ix->offset.used - 1;
+    ix->chars = i * UTF8_INDEX_STEP +
+                _utf8Count( str->ptr.b + ix->offset.ptr.i32[i], end );
+    ix->strN = strN;
+    ix->data = str->ptr.b;
+    ix->used = str->used;
+    if( strN >= 0 )
+        ((UBuffer*) str)->flags |= UR_STRING_INDEXED;
+    return ix;
+}
+
+
+/*
+  Free the UTF-8 string index cache of a thread.  This must be called before
+  the thread data store is frozen or destroyed.
+*/
+void ur_strFreeIndexCache( UThread* ut )
+{
+    Utf8IndexCache* cache = (Utf8IndexCache*) ut->strIndex;
+    int i;
+    if( cache )
+    {
+        for( i = 0; i < UTF8_INDEX_SLOTS; ++i )
+            ur_arrFree( &cache->slot[i].offset );
+        memFree( cache );
+        ut->strIndex = 0;
+    }
+}
+
+
 /**
-  Return the character at a given position.
+  Get the character index of a position in a UTF-8 string.
 
-  If the str->form is UR_ENC_UTF8, then the return value will be the byte at
-  pos, not the UCS2 character.
+  \param str    Valid string buffer with UR_ENC_UTF8 form.
+  \param pos    Byte position on a character boundary.
+
+  \return Number of characters before pos.  Positions past the end of the
+          string are one character per byte.
+*/
+UIndex ur_strCharIndex( UThread* ut, const UBuffer* str, UIndex pos )
+{
+    const Utf8Index* ix;
+    const uint8_t* start = str->ptr.b;
+    UIndex extra = 0;
+    int lo, hi, mid;
+
+    if( pos <= 0 )
+        return pos;
+    if( pos > str->used )
+    {
+        extra = pos - str->used;
+        pos = str->used;
+    }
+
+    ix = _utf8Index( ut, str );
+    if( ix )
+    {
+        if( pos == str->used )
+            return ix->chars + extra;
+
+        // Find the last indexed offset not past pos.
+        lo = 0;
+        hi = ix->offset.used;
+        while( hi - lo > 1 )
+        {
+            mid = (lo + hi) / 2;
+            if( ix->offset.ptr.i32[ mid ] <= pos )
+                lo = mid;
+            else
+                hi = mid;
+        }
+        return lo * UTF8_INDEX_STEP +
+               _utf8Count( start + ix->offset.ptr.i32[ lo ], start + pos );
+    }
+    return _utf8Count( start, start + pos ) + extra;
+}
+
+
+/**
+  Get the position of a character in a UTF-8 string.
+
+  \param str    Valid string buffer with UR_ENC_UTF8 form.
+  \param index  Character index.
+
+  \return Byte position of the character.  Indexes outside the string are
+          one byte per character.
+*/
+UIndex ur_strCharPos( UThread* ut, const UBuffer* str, UIndex index )
+{
+    const Utf8Index* ix;
+    const uint8_t* start = str->ptr.b;
+    const uint8_t* it = start;
+    UIndex n;
+
+    if( index <= 0 )
+        return index;
+
+    ix = _utf8Index( ut, str );
+    if( ix )
+    {
+        if( index >= ix->chars )
+            return str->used + index - ix->chars;
+        n = index / UTF8_INDEX_STEP;
+        it += ix->offset.ptr.i32[ n ];
+        index -= n * UTF8_INDEX_STEP;
+    }
+    n = _utf8Skip( it, start + str->used, &index ) - start;
+    return n + index;
+}
+
+
+/*
+  Return the start of the UTF-8 character before pos.
+*/
+static UIndex _utf8Prev( const uint8_t* start, UIndex pos )
+{
+    while( pos > 0 && IS_UTF8_TRAIL(start[ pos - 1 ]) )
+        --pos;
+    return (pos > 0) ? pos - 1 : 0;
+}
+
+
+/**
+  Return the character at a given position.
 
   \param str    Valid string buffer.
-  \param pos    Character index.  Pass negative numbers to index from the end
-                (e.g. -1 will return the last character).
+  \param pos    Character position.  Pass negative numbers to index from the
+                end (e.g. -1 will return the last character).
+                For UR_ENC_UTF8 strings this is a byte position on a
+                character boundary, and only -1 is valid for negative numbers.
 
   \return UCS2 value or -1 if pos is out of range.
 */
 int ur_strChar( const UBuffer* str, UIndex pos )
 {
+    if( ur_strIsUtf8(str) )
+    {
+        const uint8_t* it;
+        int c;
+        if( pos < 0 )
+            pos = (pos == -1) ? _utf8Prev( str->ptr.b, str->used ) : -1;
+        if( pos >= 0 && pos < str->used )
+        {
+            it = str->ptr.b + pos;
+            c = *it++;
+            if( c > 0x7f )
+            {
+                c = _utf8Decode( c, &it, str->ptr.b + str->used );
+                if( c < 0 )
+                    c = NOT_LATIN1_CHAR;
+            }
+            return c;
+        }
+        return -1;
+    }
+
     if( pos < 0 )
         pos += str->used;
     if( pos >= 0 && pos < str->used )
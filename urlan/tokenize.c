@@ -566,6 +566,89 @@ static UCell* _makeStringEnc( UThread* ut, UIndex blkN, const uint8_t* it,
 }
 
 
+/*
+  Input is classified 64 bytes at a time into a bit mask of the characters
+  in a set, so the end of a word or string is found with a bit scan rather
+  than testing every character.  The mask is kept until the scan moves
+  past the block.
+*/
+typedef struct
+{
+    const uint8_t* base;
+    uint64_t mask;
+    uint8_t cset[32];
+    uint8_t tables[32];
+}
+CharScan;
+
+
+static void _charScanInit( CharScan* cs, const uint8_t* cset,
+                           const uint8_t* end )
+{
+    memCpy( cs->cset, cset, 32 );
+    charset_tables( cset, 32, cs->tables );
+    cs->base = end;
+    cs->mask = 0;
+}
+
+
+/*
+  Return pointer to the first character in the set at or after it,
+  or end if none is found.
+*/
+static const uint8_t* _charScan( CharScan* cs, const uint8_t* it,
+                                 const uint8_t* end )
+{
+#ifdef __GNUC__
+    size_t off;
+    uint64_t m;
+
+    while( end - it >= 64 )
+    {
+        off = (size_t) (it - cs->base);
+        if( off >= 64 )
+        {
+            cs->base = it;
+            cs->mask = charset_mask64( it, cs->tables );
+            off = 0;
+        }
+        m = cs->mask >> off;
+        if( m )
+            return it + __builtin_ctzll( m );
+        it = cs->base + 64;
+    }
+#endif
+    while( it != end && ! ur_bitIsSet(cs->cset, *it) )
+        ++it;
+    return it;
+}
+
+
+/* Characters which end a word (the inverse of charset_word). */
+static uint8_t charset_wordEnd[32] = {
+    0xFF,0xFF,0xFF,0xFF,0xBD,0x93,0x00,0x0C,
+    0x01,0x00,0x00,0x28,0x00,0x00,0x00,0xA8,
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00
+};
+
+/* Characters to stop at in a quoted string: null lf " ^ */
+static uint8_t charset_strEnd[32] = {
+    0x01,0x04,0x00,0x00,0x04,0x00,0x00,0x00,
+    0x00,0x00,0x00,0x40,0x00,0x00,0x00,0x00,
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00
+};
+
+/* Characters to stop at in a bracketed string: null ^ { } */
+static uint8_t charset_strbEnd[32] = {
+    0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x00,0x00,0x00,0x40,0x00,0x00,0x00,0x28,
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00
+};
+
+
 enum TokenOps
 {
     SKIP,   // "\t\r "  Whitespace
@@ -625,20 +708,31 @@ static uint8_t firstCharOp[ 127 ] =
 };
 
 
-/**
-  \ingroup urlan_core
+#define TOK_SPLIT   -1
 
-  Parse UTF-8 or Latin1 data into block.
+typedef struct
+{
+    const uint8_t* pos;     // Last newline reached outside of any block.
+    UIndex used;            // Size of top level block at pos.
+    int lines;              // Lines before start (for error messages).
+    int partial;            // More input follows end.
+}
+TokenTail;
 
-  \param blkN           Index of initialized block buffer.
-  \param inputEncoding  UR_ENC_UTF8 or UR_ENC_LATIN1
-  \param start          Pointer to start of input data.
-  \param end            Pointer to end of input data.
 
-  \return UR_OK if all input successfully parsed, or UR_THROW on syntax error.
+/*
+  Tokenize until end or, if stop is before end, until the newline at stop
+  is reached outside of any block.
+
+  If tail is non-zero then the last top level newline is recorded.  When
+  tail->partial is set, a syntax error caused by reaching end returns
+  TOK_SPLIT rather than throwing.
+
+  \return UR_OK, UR_THROW, or TOK_SPLIT if stop is not at the top level.
 */
-UStatus ur_tokenizeB( UThread* ut, UIndex blkN, int inputEncoding,
-                      const uint8_t* start, const uint8_t* end )
+static int _tokenize( UThread* ut, UIndex blkN, int inputEncoding,
+                      const uint8_t* start, const uint8_t* end,
+                      const uint8_t* stop, TokenTail* tail )
 {
 #define STACK   stack.ptr.i32
 #define BLOCK   ur_buffer( STACK[stack.used - 1] )
@@ -646,6 +740,9 @@ UStatus ur_tokenizeB( UThread* ut, UIndex blkN, int inputEncoding,
     UBuffer stack;
     UBuffer* blk;
     UCell* cell;
+    CharScan scanWord;
+    CharScan scanStr;
+    CharScan scanStrB;
     const char* errorMsg;
     const uint8_t* token;
     const uint8_t* it = start;
@@ -658,6 +755,10 @@ UStatus ur_tokenizeB( UThread* ut, UIndex blkN, int inputEncoding,
 
 #define CS_NEXT ((it == end) ? -1 : *it++)
 #define TOK_END ((ch < 0) ? it : it-1)
+#define LINE_NUM (_lineCount(start, it) + (tail ? tail->lines : 0))
+#define PARTIAL_END \
+    if( tail && tail->partial && it == end ) \
+        goto split_fail
 
 #define syntaxError(msg) \
     errorMsg = msg; \
@@ -670,6 +771,9 @@ UStatus ur_tokenizeB( UThread* ut, UIndex blkN, int inputEncoding,
 
     ur_arrInit( &stack, sizeof(UIndex), 32 );
     ur_arrAppendInt32( &stack, blkN );
+    _charScanInit( &scanWord, charset_wordEnd, end );
+    _charScanInit( &scanStr,  charset_strEnd,  end );
+    _charScanInit( &scanStrB, charset_strbEnd, end );
 
 next:
     ch = CS_NEXT;
@@ -684,6 +788,17 @@ proc:
             goto next;
 
         case NL:
+            if( it > stop )
+            {
+                if( it - 1 == stop && stack.used == 1 && ! vectorN )
+                    goto done;
+                goto split_fail;
+            }
+            if( tail && stack.used == 1 && ! vectorN )
+            {
+                tail->pos  = it - 1;
+                tail->used = BLOCK->used;
+            }
             sol = 1;
             tokenState = 0;
             goto next;
@@ -709,7 +824,7 @@ proc:
             {
                 ur_error( ut, UR_ERR_SYNTAX,
                           "End of block '%c' has no opening match (line %d)",
-                          ch, _lineCount(start, it) );
+                          ch, LINE_NUM );
                 goto error;
             }
             --stack.used;
@@ -721,7 +836,7 @@ proc:
             token = it - 1;
             if( (ch = CS_NEXT) > 0 && isDigit(ch) )
                 goto number;
-            if( IS_WORD(ch) )
+            if( ch > 0 && IS_WORD(ch) )
                 goto word;
             goto push_word;
 
@@ -829,8 +944,8 @@ num_dot:
         case ALPHA:
             token = it - 1;
 word:
-            while( (ch = CS_NEXT) > 0 && IS_WORD(ch) )
-                ;
+            it = _charScan( &scanWord, it, end );
+            ch = CS_NEXT;
 push_word:
             if( tokenState == UT_GETWORD ||
                 tokenState == UT_LITWORD ||
@@ -846,6 +961,8 @@ push_word:
             blk = BLOCK;
             cell = ur_blkAppendNew( blk, mode );
             ur_setWordUnbound(cell, ur_internAtom(ut, CCP token, CCP TOK_END));
+            if( ur_atom(cell) == UR_INVALID_ATOM )
+                goto error;
             if( ch == ':' )
                 ch = CS_NEXT;
             else if( ch == '/' )
@@ -876,16 +993,18 @@ path_seg:
                     wt = UT_LITWORD;
                     ++token;
                 }
-                else if( ! IS_WORD(ch) )
+                else if( ch < 0 || ! IS_WORD(ch) )
                 {
                     --token;
                     syntaxErrorT( "Invalid path segment" );
                 }
-                while( (ch = CS_NEXT) > 0 && IS_WORD(ch) )
-                    ;
+                it = _charScan( &scanWord, it, end );
+                ch = CS_NEXT;
                 cell = ur_blkAppendNew( blk, wt );
                 ur_setWordUnbound( cell, ur_internAtom(ut, CCP token,
                                                            CCP TOK_END) );
+                if( ur_atom(cell) == UR_INVALID_ATOM )
+                    goto error;
             }
             if( ch == '/' )
                 goto path_seg;
@@ -918,16 +1037,18 @@ path_seg:
 
         case STR:
             token = it;
-            while( (ch = CS_NEXT) > 0 )
+            while( 1 )
             {
+                it = _charScan( &scanStr, it, end );
+                ch = CS_NEXT;
                 if( ch == '^' )
                 {
                     if( CS_NEXT < 0 )
                         break;
                 }
-                if( ch == '"' )
+                else if( ch == '"' )
                     goto push_string;
-                if( ch == '\n' )
+                else
                     break;
             }
             goto str_term;
@@ -947,8 +1068,10 @@ path_seg:
             }
             token = it;
             mode = 0;       // Nested depth.
-            while( (ch = CS_NEXT) > 0 )
+            while( 1 )
             {
+                it = _charScan( &scanStrB, it, end );
+                ch = CS_NEXT;
                 if( ch == '^' )
                 {
                     if( CS_NEXT < 0 )
@@ -965,6 +1088,8 @@ path_seg:
                     else
                         goto push_string;
                 }
+                else
+                    break;
             }
 str_term:
             syntaxError( "String not terminated" );
@@ -1047,7 +1172,7 @@ invalid_binary:
                 }
                 ur_makeVectorCell( ut, mode, 0, cell );
                 vectorN = cell->series.buf;
-                vectorPos = blk->used;
+                vectorPos = BLOCK->used;
                 goto next_sol;
             }
             token = it - 1;
@@ -1066,6 +1191,11 @@ invalid_binary:
                 }
                 goto proc;
             }
+            else if( ch < 0 )
+            {
+                token = it - 1;
+                goto push_word;
+            }
             else if( ! IS_WORD(ch) )
             {
                 token = it - 2;
@@ -1090,12 +1220,8 @@ invalid_binary:
             }
             else
             {
-                do
-                {
-                    if( IS_DELIM( ch ) )
-                        break;
-                }
-                while( (ch = CS_NEXT) > 0 );
+                while( ch > 0 && ! IS_DELIM( ch ) )
+                    ch = CS_NEXT;
             }
             {
             UIndex bufN;
@@ -1124,7 +1250,7 @@ invalid_binary:
             goto next;
 
         case COM_L:
-            while( (ch = CS_NEXT) && ch != '\n' )
+            while( (ch = CS_NEXT) > 0 && ch != '\n' )
                 ;
             sol = 1;
             break;
@@ -1134,14 +1260,21 @@ invalid_binary:
         }
     }
 
+    if( stop != end )
+        goto split_fail;
     if( stack.used > 1 )
     {
         syntaxError( "Block or paren not closed" );
     }
 
+done:
     ur_arrFree( &stack );
     return UR_OK;
 
+split_fail:
+    ur_arrFree( &stack );
+    return TOK_SPLIT;
+
 next_sol:
     ch = CS_NEXT;
 
@@ -1155,16 +1288,17 @@ set_sol:
 
 invalid_char:
     ur_error( ut, UR_ERR_SYNTAX, "Unprintable/Non-ASCII Input %d (line %d)",
-              ch, _lineCount(start, it) );
+              ch, LINE_NUM );
     goto error;
 
 error_msg:
-    ur_error( ut, UR_ERR_SYNTAX, "%s (line %d)",
-              errorMsg, _lineCount(start, it) );
+    PARTIAL_END;
+    ur_error( ut, UR_ERR_SYNTAX, "%s (line %d)", errorMsg, LINE_NUM );
     goto error;
 
 error_token:
-    _errorToken( ut, errorMsg, _lineCount(start, it), token, end );
+    PARTIAL_END;
+    _errorToken( ut, errorMsg, LINE_NUM, token, end );
 
 error:
     ur_arrFree( &stack );
@@ -1172,6 +1306,451 @@ error:
 }
 
 
+#ifdef CONFIG_THREAD
+#define TOK_CHUNK_MIN   0x100000
+#define TOK_THREAD_MAX  16
+
+typedef struct
+{
+    UThread* ut;
+    const uint8_t* start;
+    const uint8_t* end;
+    const uint8_t* stop;
+    UIndex blkN;
+    int enc;
+    int status;
+    OSThread thread;
+}
+TokenChunk;
+
+
+static int _cpuCount()
+{
+#ifdef _WIN32
+    SYSTEM_INFO si;
+    GetSystemInfo( &si );
+    return si.dwNumberOfProcessors;
+#else
+    return sysconf( _SC_NPROCESSORS_ONLN );
+#endif
+}
+
+
+/*
+  Return pointer to a newline which is likely to be outside of any block
+  or string, or end if none is found.  This only looks for a line beginning
+  with a value in the first column; the tokenizer verifies the split.
+*/
+static const uint8_t* _findSplit( const uint8_t* it, const uint8_t* end )
+{
+    int ch;
+
+    while( (it = (const uint8_t*) memchr( it, '\n', end - it )) )
+    {
+        if( ++it == end )
+            break;
+        ch = *it;
+        if( ch < 127 && ch != '}' )
+        {
+            switch( firstCharOp[ ch ] )
+            {
+                case SKIP:
+                case NL:
+                case BLK_E:
+                case INV:
+                    break;
+                default:
+                    return it - 1;
+            }
+        }
+    }
+    return end;
+}
+
+
+#ifdef _WIN32
+static DWORD WINAPI _tokenizeThread( LPVOID arg )
+#else
+static void* _tokenizeThread( void* arg )
+#endif
+{
+    TokenChunk* tc = (TokenChunk*) arg;
+    UThread* ut = tc->ut;
+
+    tc->blkN = ur_makeBlock( ut, 0 );
+    ur_hold( tc->blkN );
+    tc->status = _tokenize( ut, tc->blkN, tc->enc,
+                            tc->start, tc->end, tc->stop, NULL );
+    return 0;
+}
+
+
+static void _gatherBuffers( UBuffer* ids, UIndex* map, const UBuffer* blk )
+{
+    const UCell* it  = blk->ptr.cell;
+    const UCell* end = it + blk->used;
+    UIndex n;
+
+    for( ; it != end; ++it )
+    {
+        if( ur_isSeriesType( ur_type(it) ) )
+        {
+            n = it->series.buf;
+            if( n > UR_INVALID_BUF && ! map[ n ] )
+            {
+                map[ n ] = n;
+                ur_arrAppendInt32( ids, n );
+            }
+        }
+    }
+}
+
+
+static void _remapBuffers( UCell* it, UCell* end, const UIndex* map )
+{
+    for( ; it != end; ++it )
+    {
+        if( ur_isSeriesType( ur_type(it) ) && it->series.buf > UR_INVALID_BUF )
+            it->series.buf = map[ it->series.buf ];
+    }
+}
+
+
+/*
+  Move the buffers referenced from block blkN of thread wt into the ut
+  dataStore and append the cells of blkN to block destN.
+*/
+static void _spliceChunk( UThread* ut, UIndex destN, UThread* wt, UIndex blkN )
+{
+    UBuffer ids;
+    UBuffer* wstore = wt->dataStore.ptr.buf;
+    UBuffer* buf;
+    UBuffer* dest;
+    UIndex* map;
+    UIndex* newN;
+    UIndex used;
+    UIndex i;
+
+    map = (UIndex*) memAlloc( wt->dataStore.used * sizeof(UIndex) );
+    memSet( map, 0, wt->dataStore.used * sizeof(UIndex) );
+    ur_arrInit( &ids, sizeof(UIndex), 0 );
+
+    _gatherBuffers( &ids, map, wstore + blkN );
+    for( i = 0; i < ids.used; ++i )
+    {
+        buf = wstore + ids.ptr.i32[ i ];
+        if( buf->type == UT_BLOCK )
+            _gatherBuffers( &ids, map, buf );
+    }
+
+    if( ids.used )
+    {
+        newN = (UIndex*) memAlloc( ids.used * sizeof(UIndex) );
+        ur_genBuffers( ut, ids.used, newN );    // gc!
+        for( i = 0; i < ids.used; ++i )
+        {
+            buf = wstore + ids.ptr.i32[ i ];
+            map[ ids.ptr.i32[ i ] ] = newN[ i ];
+            *ur_buffer( newN[ i ] ) = *buf;
+            buf->type = UT_UNSET;   // Memory now owned by ut.
+        }
+        for( i = 0; i < ids.used; ++i )
+        {
+            buf = ur_buffer( newN[ i ] );
+            if( buf->type == UT_BLOCK )
+                _remapBuffers( buf->ptr.cell, buf->ptr.cell + buf->used, map );
+        }
+        memFree( newN );
+    }
+
+    buf = wstore + blkN;
+    dest = ur_buffer( destN );
+    used = dest->used;
+    ur_arrReserve( dest, used + buf->used );
+    memCpy( dest->ptr.cell + used, buf->ptr.cell, buf->used * sizeof(UCell) );
+    dest->used += buf->used;
+    _remapBuffers( dest->ptr.cell + used, dest->ptr.cell + dest->used, map );
+
+    ur_arrFree( &ids );
+    memFree( map );
+}
+
+
+/*
+  Split input at newlines between top level values and tokenize the chunks
+  in parallel.  The calling thread does the first chunk directly into blkN
+  while worker threads make separate blocks which are spliced onto it.
+
+  Each chunk must reach the newline where the next one starts outside of
+  any block (proving the split is valid) or TOK_SPLIT is returned and blkN
+  is left unchanged.
+*/
+static int _tokenizeParallel( UThread* ut, UIndex blkN, int enc,
+                              const uint8_t* start, const uint8_t* end )
+{
+    TokenChunk chunk[ TOK_THREAD_MAX ];
+    const uint8_t* split[ TOK_THREAD_MAX + 1 ];
+    const uint8_t* it;
+    TokenChunk* tc;
+    size_t len = end - start;
+    UIndex used;
+    int count, i;
+    int ok;
+
+    count = _cpuCount();
+    if( count > TOK_THREAD_MAX )
+        count = TOK_THREAD_MAX;
+    if( (size_t) count > len / TOK_CHUNK_MIN )
+        count = len / TOK_CHUNK_MIN;
+    if( count < 2 )
+        return TOK_SPLIT;
+
+    split[0] = start;
+    for( i = 1; i < count; ++i )
+    {
+        it = start + len * i / count;
+        if( it <= split[i - 1] )
+            it = split[i - 1] + 1;
+        it = _findSplit( it, end );
+        if( it == end )
+            break;
+        split[i] = it;
+    }
+    count = i;
+    if( count < 2 )
+        return TOK_SPLIT;
+    split[ count ] = end;
+
+    for( i = 1; i < count; ++i )
+    {
+        tc = chunk + i;
+        tc->start  = split[i];
+        tc->end    = end;
+        tc->stop   = split[i + 1];
+        tc->enc    = enc;
+        tc->status = TOK_SPLIT;
+        tc->ut     = ur_makeThread( ut );
+        if( tc->ut )
+        {
+#ifdef _WIN32
+            tc->thread = CreateThread( NULL, 0, _tokenizeThread, tc, 0, NULL );
+            if( tc->thread == NULL )
+#else
+            if( pthread_create( &tc->thread, 0, _tokenizeThread, tc ) != 0 )
+#endif
+            {
+                ur_destroyThread( tc->ut );
+                tc->ut = NULL;
+            }
+        }
+    }
+
+    used = ur_buffer( blkN )->used;
+    ok = _tokenize( ut, blkN, enc, start, end, split[1], NULL );
+
+    for( i = 1; i < count; ++i )
+    {
+        tc = chunk + i;
+        if( tc->ut )
+        {
+#ifdef _WIN32
+            WaitForSingleObject( tc->thread, INFINITE );
+            CloseHandle( tc->thread );
+#else
+            pthread_join( tc->thread, NULL );
+#endif
+        }
+        if( tc->status != UR_OK && ok == UR_OK )
+            ok = TOK_SPLIT;
+    }
+
+    for( i = 1; i < count; ++i )
+    {
+        tc = chunk + i;
+        if( tc->ut )
+        {
+            if( ok == UR_OK )
+                _spliceChunk( ut, blkN, tc->ut, tc->blkN );
+            ur_destroyThread( tc->ut );
+        }
+    }
+
+    if( ok == TOK_SPLIT )
+        ur_buffer( blkN )->used = used;
+    return ok;
+}
+#endif
+
+
+/**
+  \ingroup urlan_core
+
+  Parse UTF-8 or Latin1 data into block.
+
+  If Urlan is built with CONFIG_THREAD then large inputs are split between
+  top level values and the pieces are tokenized in parallel.
+
+  \param blkN           Index of initialized block buffer.
+  \param inputEncoding  UR_ENC_UTF8 or UR_ENC_LATIN1
+  \param start          Pointer to start of input data.
+  \param end            Pointer to end of input data.
+
+  \return UR_OK if all input successfully parsed, or UR_THROW on syntax error.
+*/
+UStatus ur_tokenizeB( UThread* ut, UIndex blkN, int inputEncoding,
+                      const uint8_t* start, const uint8_t* end )
+{
+#ifdef CONFIG_THREAD
+    if( end - start >= 2 * TOK_CHUNK_MIN )
+    {
+        int ok = _tokenizeParallel( ut, blkN, inputEncoding, start, end );
+        if( ok != TOK_SPLIT )
+            return ok;
+    }
+#endif
+    return _tokenize( ut, blkN, inputEncoding, start, end, end, NULL );
+}
+
+
+/**
+  \ingroup urlan_core
+
+  Initialize tokenizer for input which arrives in pieces.
+
+  \param tok            Tokenizer to initialize.
+  \param inputEncoding  UR_ENC_UTF8 or UR_ENC_LATIN1
+  \param blkN           Block to which completed values are appended.
+                        This may be changed between calls to
+                        ur_tokenizeFeed().
+
+  \sa ur_tokenizeFeed, ur_tokenizeFree
+*/
+void ur_tokenizeInit( UTokenizer* tok, int inputEncoding, UIndex blkN )
+{
+    ur_binInit( &tok->input, 0 );
+    tok->blkN  = blkN;
+    tok->lines = 0;
+    tok->retryLen = 0;
+    tok->enc   = inputEncoding;
+}
+
+
+/**
+  \ingroup urlan_core
+
+  Free memory used by tokenizer.
+*/
+void ur_tokenizeFree( UTokenizer* tok )
+{
+    ur_binFree( &tok->input );
+}
+
+
+static const uint8_t* _lastNewline( const uint8_t* start, const uint8_t* it )
+{
+    while( it != start )
+    {
+        if( *--it == '\n' )
+            return it;
+    }
+    return NULL;
+}
+
+
+/**
+  \ingroup urlan_core
+
+  Parse the next piece of input.  Values which are complete are appended
+  to tok->blkN and any partial value is kept until more input is fed.
+
+  Input is only tokenized up to the last newline which is outside of any
+  block or string, so memory use is limited by the size of the largest
+  top level value.
+
+  \param tok    Initialized tokenizer.
+  \param it     Start of input.
+  \param end    End of input.  Pass it == end when there is no more input.
+
+  \return UR_OK or UR_THROW on syntax error.
+*/
+UStatus ur_tokenizeFeed( UThread* ut, UTokenizer* tok,
+                         const uint8_t* it, const uint8_t* end )
+{
+    TokenTail tail;
+    UBuffer* input = &tok->input;
+    const uint8_t* start;
+    const uint8_t* last;
+    UIndex used;
+    int ok;
+
+    tail.pos   = NULL;
+    tail.lines = tok->lines;
+
+    if( it == end )
+    {
+        if( ! input->used )
+            return UR_OK;
+        tail.partial = 0;
+        start = input->ptr.b;
+        end = start + input->used;
+        ok = _tokenize( ut, tok->blkN, tok->enc, start, end, end, &tail );
+        input->used = 0;
+        return ok;
+    }
+
+    if( input->used )
+    {
+        ur_binAppendData( input, it, end - it );
+        start = input->ptr.b;
+        end = start + input->used;
+    }
+    else
+        start = it;
+
+    last = NULL;
+    if( end - start >= tok->retryLen )
+        last = _lastNewline( start, end );
+    if( last )
+    {
+        tail.partial = 1;
+        used = ur_buffer( tok->blkN )->used;
+        ok = _tokenize( ut, tok->blkN, tok->enc, start, last + 1, last + 1,
+                        &tail );
+        if( ok == UR_THROW )
+            return UR_THROW;
+
+        // Keep values up to the last top level newline; the newline itself
+        // is kept so the next value is marked as starting a line.
+        if( tail.pos )
+        {
+            ur_buffer( tok->blkN )->used = tail.used;
+            tok->lines = tail.lines + _lineCount( start, tail.pos ) - 1;
+            tok->retryLen = 0;
+            it = tail.pos;
+        }
+        else
+        {
+            // Try again when twice as much input has been collected so that
+            // a large value is not re-tokenized for each piece.
+            ur_buffer( tok->blkN )->used = used;
+            tok->retryLen = (end - start) * 2;
+            it = start;
+        }
+    }
+    else
+        it = start;
+
+    if( input->used )
+    {
+        input->used = end - it;
+        memMove( input->ptr.b, it, input->used );
+    }
+    else
+        ur_binAppendData( input, it, end - it );
+    return UR_OK;
+}
+
+
 /**
   \ingroup urlan_core
 